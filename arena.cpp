@@ -0,0 +1,196 @@
+////////////////////////////////////////////////////////////////////////////////
+// Base: A Simple Graphics Suite
+// Author: Eric Scrivner
+//
+// Time-stamp: <Last modified 2026-10-19 17:31:18 by Eric Scrivner>
+//
+// Description:
+//   Region-based allocation of objects which are all released together.
+////////////////////////////////////////////////////////////////////////////////
+
+#include "arena.hpp"
+
+#include <algorithm>
+#include <ostream>
+#include <stdint.h>
+
+#include <sys/mman.h>
+using namespace std;
+
+namespace {
+  //////////////////////////////////////////////////////////////////////////////
+  // Constants
+  const size_t kHugePageSize = 2 << 20;
+
+  //////////////////////////////////////////////////////////////////////////////
+  // Function: AlignUp
+  //
+  // Rounds value up to a multiple of alignment (a power of two)
+  uintptr_t AlignUp(const uintptr_t& value, const size_t& alignment) {
+    return (value + alignment - 1) & ~static_cast<uintptr_t>(alignment - 1);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+const size_t Base::Arena::kDefaultBlockSize;
+
+////////////////////////////////////////////////////////////////////////////////
+
+Base::Arena::Arena(const size_t& blockSize, bool hugePages)
+  : blockSize_(blockSize), hugePages_(hugePages), next_(0), end_(0),
+    destructors_(0)
+{ }
+
+////////////////////////////////////////////////////////////////////////////////
+
+Base::Arena::~Arena() {
+  release();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void* Base::Arena::allocate(const size_t& size, const size_t& alignment) {
+  stats_.allocations++;
+
+  // Allocations which would waste much of a block get a block of their own,
+  // leaving the current block to be filled
+  if (size > blockSize_ / 4) {
+    Block& block = _newBlock(size + alignment);
+    char* result = reinterpret_cast<char*>(
+      AlignUp(reinterpret_cast<uintptr_t>(block.data), alignment));
+    stats_.bytesUsed += (result - block.data) + size;
+    return result;
+  }
+
+  char* result = reinterpret_cast<char*>(
+    AlignUp(reinterpret_cast<uintptr_t>(next_), alignment));
+  if (next_ == 0 || result + size > end_) {
+    Block& block = _newBlock(blockSize_);
+    next_ = block.data;
+    end_ = block.data + block.size;
+    result = reinterpret_cast<char*>(
+      AlignUp(reinterpret_cast<uintptr_t>(next_), alignment));
+  }
+
+  stats_.bytesUsed += (result + size) - next_;
+  next_ = result + size;
+  return result;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void Base::Arena::release() {
+  // Destroy the objects, latest first
+  while (destructors_ != 0) {
+    Destructor* destructor = destructors_;
+    destructors_ = destructor->next;
+    destructor->destroy(destructor->object);
+  }
+
+  for (size_t i = 0; i < blocks_.size(); i++) {
+    if (blocks_[i].mapped) {
+      munmap(blocks_[i].data, blocks_[i].size);
+    } else {
+      delete [] blocks_[i].data;
+    }
+  }
+
+  blocks_.clear();
+  next_ = end_ = 0;
+  stats_ = ArenaStats();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool Base::Arena::owns(const void* pointer) const {
+  const char* p = static_cast<const char*>(pointer);
+
+  // Find the last block starting at or before the pointer
+  size_t low = 0, high = blocks_.size();
+  while (low < high) {
+    size_t middle = (low + high) / 2;
+    if (blocks_[middle].data <= p) {
+      low = middle + 1;
+    } else {
+      high = middle;
+    }
+  }
+
+  return low > 0 && p < blocks_[low - 1].data + blocks_[low - 1].size;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void Base::Arena::_addDestructor(void* object, void (*destroy)(void*)) {
+  Destructor* destructor = static_cast<Destructor*>(
+    allocate(sizeof(Destructor), alignof(Destructor)));
+  destructor->object = object;
+  destructor->destroy = destroy;
+  destructor->next = destructors_;
+  destructors_ = destructor;
+  stats_.destructors++;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+Base::Arena::Block& Base::Arena::_newBlock(const size_t& size) {
+  Block block;
+  block.data = 0;
+  block.size = size;
+  block.mapped = false;
+
+  if (hugePages_) {
+    // Huge pages come in whole pages, so round the block up to fill them
+    size_t hugeSize = AlignUp(size, kHugePageSize);
+    void* data = MAP_FAILED;
+#ifdef MAP_HUGETLB
+    // Reserved huge pages, if the system has any
+    data = mmap(0, hugeSize, PROT_READ | PROT_WRITE,
+                MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    if (data != MAP_FAILED) {
+      stats_.hugePageBlocks++;
+    }
+#endif
+    if (data == MAP_FAILED) {
+      // Otherwise ask for transparent huge pages
+      data = mmap(0, hugeSize, PROT_READ | PROT_WRITE,
+                  MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+#ifdef MADV_HUGEPAGE
+      if (data != MAP_FAILED && madvise(data, hugeSize, MADV_HUGEPAGE) == 0) {
+	stats_.hugePageBlocks++;
+      }
+#endif
+    }
+
+    if (data != MAP_FAILED) {
+      block.data = static_cast<char*>(data);
+      block.size = hugeSize;
+      block.mapped = true;
+    }
+  }
+
+  if (block.data == 0) {
+    block.data = new char[size];
+  }
+
+  stats_.blocks++;
+  stats_.bytesReserved += block.size;
+
+  // Keep the blocks in order of address for owns
+  vector<Block>::iterator position = blocks_.begin();
+  while (position != blocks_.end() && position->data < block.data) {
+    ++position;
+  }
+  return *blocks_.insert(position, block);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+ostream& Base::operator << (ostream& out, const ArenaStats& stats) {
+  out << stats.allocations << " allocations, " << stats.bytesUsed
+      << " of " << stats.bytesReserved << " bytes used in " << stats.blocks
+      << " blocks (" << stats.hugePageBlocks << " huge), "
+      << stats.destructors << " destructors";
+  return out;
+}
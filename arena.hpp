@@ -0,0 +1,185 @@
+////////////////////////////////////////////////////////////////////////////////
+// Base: A Simple Graphics Suite
+// Author: Eric Scrivner
+//
+// Time-stamp: <Last modified 2026-10-19 17:31:18 by Eric Scrivner>
+//
+// Description:
+//   Region-based allocation of objects which are all released together.
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef ARENA_HPP__
+#define ARENA_HPP__
+
+#include "base.hpp"
+
+#include <iosfwd>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace Base {
+  //////////////////////////////////////////////////////////////////////////////
+  // Struct: ArenaStats
+  //
+  // Counts of the memory held by an arena
+  struct ArenaStats {
+    size_t blocks;         // Blocks of memory currently held
+    size_t hugePageBlocks; // Of those, the blocks backed by huge pages
+    size_t bytesReserved;  // Total size of the blocks held
+    size_t bytesUsed;      // Bytes handed out (including alignment padding)
+    size_t allocations;    // Allocations made
+    size_t destructors;    // Objects whose destructors will run on release
+
+    ArenaStats()
+      : blocks(0), hugePageBlocks(0), bytesReserved(0), bytesUsed(0),
+        allocations(0), destructors(0)
+    { }
+  };
+
+  //////////////////////////////////////////////////////////////////////////////
+  // Function: operator <<
+  //
+  // Writes a one line summary of the given statistics to a stream
+  std::ostream& operator << (std::ostream& out, const ArenaStats& stats);
+
+  //////////////////////////////////////////////////////////////////////////////
+  // Struct: ArenaDestroys
+  //
+  // Whether an arena must run the destructor of a T when it is released. This
+  // is true unless T is trivially destructible. Types whose destructors have
+  // nothing to release (such as those which are only virtual) specialize this
+  // as false, so that an arena need not keep track of them.
+  template <class T>
+  struct ArenaDestroys {
+    static const bool value = !std::is_trivially_destructible<T>::value;
+  };
+
+  //////////////////////////////////////////////////////////////////////////////
+  // Class: Arena
+  //
+  // Hands out memory from large blocks by advancing a pointer, and frees all
+  // of it at once when released or destroyed. Objects made with create have
+  // their destructors run on release, latest first. There is no way to free
+  // a single allocation.
+  //
+  // Blocks may be backed by huge pages (where the system supports them),
+  // which cuts the TLB misses of walking large scenes. If huge pages cannot
+  // be had the arena falls back to normal pages.
+  //
+  // An arena is not safe to use from several threads at once.
+  class Arena {
+  public:
+    static const size_t kDefaultBlockSize = 2 << 20; // One huge page
+
+    ////////////////////////////////////////////////////////////////////////////
+    // Function: Arena
+    //
+    // Parameters:
+    //   blockSize - The size of each block of memory
+    //   hugePages - Whether to back the blocks with huge pages
+    explicit Arena(const size_t& blockSize = kDefaultBlockSize,
+                   bool hugePages = false);
+
+    ~Arena();
+
+    ////////////////////////////////////////////////////////////////////////////
+    // Function: allocate
+    //
+    // Parameters:
+    //   size - The number of bytes to allocate
+    //   alignment - The alignment of the memory (a power of two)
+    //
+    // Returns uninitialized memory which lives until the arena is released
+    void* allocate(const size_t& size, const size_t& alignment = 16);
+
+    ////////////////////////////////////////////////////////////////////////////
+    // Function: create
+    //
+    // Returns a new T constructed in the arena from the given arguments
+    template <class T, class... Args>
+    T* create(Args&&... args) {
+      T* object = new (allocate(sizeof(T), alignof(T)))
+	T(std::forward<Args>(args)...);
+      if (ArenaDestroys<T>::value) {
+	_addDestructor(object, &Destroy<T>);
+      }
+      return object;
+    }
+
+    ////////////////////////////////////////////////////////////////////////////
+    // Function: release
+    //
+    // Destroys every object created in the arena and frees all its memory.
+    // The arena may be used again afterwards.
+    void release();
+
+    ////////////////////////////////////////////////////////////////////////////
+    // Function: owns
+    //
+    // Returns true if the given pointer is to memory of this arena
+    bool owns(const void* pointer) const;
+
+    ////////////////////////////////////////////////////////////////////////////
+    // Function: stats
+    //
+    // Returns the statistics of the arena
+    const ArenaStats& stats() const { return stats_; }
+  private:
+    ////////////////////////////////////////////////////////////////////////////
+    // Struct: Block
+    //
+    // A block of memory held by the arena
+    struct Block {
+      char*  data;   // The start of the block
+      size_t size;   // The size of the block in bytes
+      bool   mapped; // Whether the block was mapped rather than allocated
+    };
+
+    ////////////////////////////////////////////////////////////////////////////
+    // Struct: Destructor
+    //
+    // An object to be destroyed on release, kept in the arena itself
+    struct Destructor {
+      void*       object;             // The object to be destroyed
+      void        (*destroy)(void*);  // Destroys the object
+      Destructor* next;               // The destructor to run after this one
+    };
+
+    ////////////////////////////////////////////////////////////////////////////
+    // Function: Destroy
+    //
+    // Runs the destructor of an object of type T
+    template <class T>
+    static void Destroy(void* object) {
+      static_cast<T*>(object)->~T();
+    }
+
+    ////////////////////////////////////////////////////////////////////////////
+    // Function: _addDestructor
+    //
+    // Arranges for an object to be destroyed on release
+    void _addDestructor(void* object, void (*destroy)(void*));
+
+    ////////////////////////////////////////////////////////////////////////////
+    // Function: _newBlock
+    //
+    // Returns a new block of at least the given size, which is added to
+    // blocks_
+    Block& _newBlock(const size_t& size);
+
+    Arena(const Arena&);
+    Arena& operator = (const Arena&);
+
+    size_t             blockSize_;   // The size of each ordinary block
+    bool               hugePages_;   // Whether to try huge pages for blocks
+    std::vector<Block> blocks_;      // The blocks, in order of address
+    char*              next_;        // Next free byte in the current block
+    char*              end_;         // The end of the current block
+    Destructor*        destructors_; // The latest object to be destroyed
+    ArenaStats         stats_;       // Counts of the memory held
+  };
+}
+
+#endif // ARENA_HPP__
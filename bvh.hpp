@@ -0,0 +1,268 @@
+////////////////////////////////////////////////////////////////////////////////
+// Base: A Simple Graphics Suite
+// Author: Eric Scrivner
+//
+// Time-stamp: <Last modified 2026-10-19 21:14:08 by Eric Scrivner>
+//
+// Description:
+//   A bounding volume hierarchy over runs of primitives kept in spatial
+//   order, and the ray-box test it is traversed with.
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef BVH_HPP__
+#define BVH_HPP__
+
+#include "base.hpp"
+#include "hit.hpp"
+#include "ray.hpp"
+#include "vector3.hpp"
+
+#include <algorithm>
+#include <stdint.h>
+#include <utility>
+#include <vector>
+
+namespace Base {
+  //////////////////////////////////////////////////////////////////////////////
+  // Struct: BoxRay
+  //
+  // A ray laid out for intersection with many axis-aligned boxes
+  struct BoxRay {
+    Real origin[3];    // The origin of the ray
+    Real direction[3]; // The direction of the ray
+    Real inverse[3];   // The reciprocal of each component of the direction
+
+    explicit BoxRay(const Ray& ray) {
+      origin[0] = ray.origin.x;
+      origin[1] = ray.origin.y;
+      origin[2] = ray.origin.z;
+      direction[0] = ray.direction.x;
+      direction[1] = ray.direction.y;
+      direction[2] = ray.direction.z;
+      for (int axis = 0; axis < 3; axis++) {
+	inverse[axis] = 1 / direction[axis];
+      }
+    }
+
+    ////////////////////////////////////////////////////////////////////////////
+    // Function: intersect
+    //
+    // Intersects the ray with an axis-aligned box using the slab method,
+    // setting tNear to the entry distance. Returns false if the ray misses
+    // the box within [tmin, tmax].
+    template <typename T>
+    bool intersect(const T lower[3], const T upper[3], Real tmin, Real tmax,
+                   Real& tNear) const {
+      for (int axis = 0; axis < 3; axis++) {
+	if (direction[axis] == 0) {
+	  // Parallel to the slab, so the origin must lie within it
+	  if (origin[axis] < lower[axis] || origin[axis] > upper[axis]) {
+	    return false;
+	  }
+	  continue;
+	}
+
+	Real t0 = (lower[axis] - origin[axis]) * inverse[axis];
+	Real t1 = (upper[axis] - origin[axis]) * inverse[axis];
+	if (t0 > t1) {
+	  std::swap(t0, t1);
+	}
+
+	tmin = std::max(tmin, t0);
+	tmax = std::min(tmax, t1);
+	if (tmin > tmax) {
+	  return false;
+	}
+      }
+
+      tNear = tmin;
+      return true;
+    }
+
+    bool intersect(const Vector3& lower, const Vector3& upper, Real tmin,
+                   Real tmax, Real& tNear) const {
+      const Real lo[3] = { lower.x, lower.y, lower.z };
+      const Real hi[3] = { upper.x, upper.y, upper.z };
+      return intersect(lo, hi, tmin, tmax, tNear);
+    }
+  };
+
+  //////////////////////////////////////////////////////////////////////////////
+  // Class: Bvh
+  //
+  // A binary hierarchy of axis-aligned boxes over a sequence of leaves, such
+  // as the blocks of a CompressedMesh or the runs of spheres of a SphereSet.
+  // The leaves are expected to be in an order which keeps neighbours close
+  // in space (such as along a Morton curve), so each node simply splits its
+  // leaves in the middle. Boxes are kept as T, float or Real.
+  //
+  // The nodes are stored depth first. The left child of an interior node
+  // follows it directly and the right child is at the index it records.
+  template <typename T>
+  class Bvh {
+  public:
+    ////////////////////////////////////////////////////////////////////////////
+    // Struct: Node
+    //
+    // A node of the hierarchy
+    struct Node {
+      T        lower[3], upper[3]; // The bounding box of the node's leaves
+      uint32_t first;              // The leaf (leaf nodes) or right child
+      uint32_t count;              // 1 for a leaf, 0 if interior
+    };
+
+    ////////////////////////////////////////////////////////////////////////////
+    // Function: build
+    //
+    // Parameters:
+    //   bounds - The box of each leaf, as its lower then upper corner
+    //
+    // Replaces the hierarchy with one over the given leaves
+    void build(const std::vector<T>& bounds) {
+      size_t numLeaves = bounds.size() / 6;
+      nodes_.clear();
+      if (numLeaves == 0) {
+	return;
+      }
+      nodes_.reserve(2 * numLeaves - 1);
+      _buildNode(0, numLeaves, bounds);
+    }
+
+    ////////////////////////////////////////////////////////////////////////////
+    // Function: intersect
+    //
+    // Parameters:
+    //   ray - The ray to be traced
+    //   hit - The closest hit so far, which the leaf test updates
+    //   tmin - The smallest distance which constitutes an intersection
+    //   leafTest - Called with the index of each leaf the ray reaches,
+    //              returning true if it hit something in the leaf
+    //
+    // Visits the leaves whose boxes the ray passes through before the
+    // closest hit, nearer side of each node first. Returns true if any leaf
+    // test did.
+    template <typename LeafTest>
+    bool intersect(const Ray& ray, Hit& hit, Real tmin,
+                   LeafTest leafTest) const {
+      if (nodes_.empty()) {
+	return false;
+      }
+
+      BoxRay boxRay(ray);
+
+      // Nodes still to be visited, with the distance at which the ray enters
+      // them
+      std::pair<uint32_t, Real> stack[kMaxDepth];
+      size_t top = 0;
+      Real tNear;
+      if (!boxRay.intersect(nodes_[0].lower, nodes_[0].upper, tmin,
+                            hit.getDistance(), tNear)) {
+	return false;
+      }
+      stack[top++] = std::make_pair(0u, tNear);
+
+      bool didHit = false;
+      while (top > 0) {
+	std::pair<uint32_t, Real> entry = stack[--top];
+
+	// Skip nodes which are entirely beyond the closest hit so far
+	if (entry.second > hit.getDistance()) {
+	  continue;
+	}
+
+	const Node& node = nodes_[entry.first];
+	if (node.count > 0) {
+	  if (leafTest(static_cast<size_t>(node.first))) {
+	    didHit = true;
+	  }
+	  continue;
+	}
+
+	// Push the children which the ray passes through, nearest on top
+	uint32_t children[2] = { entry.first + 1, node.first };
+	Real tChild[2];
+	bool hitChild[2];
+	for (int i = 0; i < 2; i++) {
+	  const Node& child = nodes_[children[i]];
+	  hitChild[i] = boxRay.intersect(child.lower, child.upper, tmin,
+	                                 hit.getDistance(), tChild[i]);
+	}
+
+	if (hitChild[0] && hitChild[1]) {
+	  int nearest = (tChild[0] <= tChild[1]) ? 0 : 1;
+	  stack[top++] = std::make_pair(children[1 - nearest],
+	                                tChild[1 - nearest]);
+	  stack[top++] = std::make_pair(children[nearest], tChild[nearest]);
+	} else if (hitChild[0]) {
+	  stack[top++] = std::make_pair(children[0], tChild[0]);
+	} else if (hitChild[1]) {
+	  stack[top++] = std::make_pair(children[1], tChild[1]);
+	}
+      }
+
+      return didHit;
+    }
+
+    ////////////////////////////////////////////////////////////////////////////
+    // Function: clear
+    //
+    // Removes every node of the hierarchy
+    void clear() { nodes_.clear(); }
+
+    ////////////////////////////////////////////////////////////////////////////
+    // Function: numNodes
+    //
+    // Returns the number of nodes in the hierarchy
+    size_t numNodes() const { return nodes_.size(); }
+
+    ////////////////////////////////////////////////////////////////////////////
+    // Function: memoryBytes
+    //
+    // Returns the size of the nodes in bytes
+    size_t memoryBytes() const { return nodes_.size() * sizeof(Node); }
+  private:
+    static const size_t kMaxDepth = 64; // Deepest hierarchy traversed
+
+    ////////////////////////////////////////////////////////////////////////////
+    // Function: _buildNode
+    //
+    // Appends the subtree over the leaves [first, last) to nodes_ and returns
+    // the index of its root
+    uint32_t _buildNode(const size_t& first, const size_t& last,
+                        const std::vector<T>& bounds) {
+      uint32_t index = nodes_.size();
+      nodes_.push_back(Node());
+
+      if (last - first == 1) {
+	Node& node = nodes_[index];
+	std::copy(&bounds[6 * first], &bounds[6 * first] + 3, node.lower);
+	std::copy(&bounds[6 * first] + 3, &bounds[6 * first] + 6, node.upper);
+	node.first = first;
+	node.count = 1;
+	return index;
+      }
+
+      // Split in the middle, each half being compact in space
+      size_t middle = first + (last - first) / 2;
+      _buildNode(first, middle, bounds);
+      uint32_t right = _buildNode(middle, last, bounds);
+
+      Node& node = nodes_[index];
+      const Node& leftChild = nodes_[index + 1];
+      const Node& rightChild = nodes_[right];
+      for (int axis = 0; axis < 3; axis++) {
+	node.lower[axis] = std::min(leftChild.lower[axis],
+	                            rightChild.lower[axis]);
+	node.upper[axis] = std::max(leftChild.upper[axis],
+	                            rightChild.upper[axis]);
+      }
+      node.first = right;
+      node.count = 0;
+      return index;
+    }
+
+    std::vector<Node> nodes_; // The hierarchy, root first
+  };
+}
+
+#endif // BVH_HPP__
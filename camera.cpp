@@ -0,0 +1,94 @@
+////////////////////////////////////////////////////////////////////////////////
+// Base: A Simple Graphics Suite
+// Author: Eric Scrivner
+//
+// Time-stamp: <Last modified 2026-10-19 18:24:51 by Eric Scrivner>
+//
+// Description:
+//   Generation of the rays of a tile of pixels.
+////////////////////////////////////////////////////////////////////////////////
+
+#include "camera.hpp"
+
+#include <algorithm>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+using namespace std;
+
+////////////////////////////////////////////////////////////////////////////////
+// Camera
+
+void Base::Camera::generateRays(const CameraTile& tile, vector<Ray>& rays) {
+  rays.clear();
+  rays.reserve(tile.width * tile.height);
+
+  for (size_t j = 0; j < tile.height; j++) {
+    Real y = static_cast<Real>(tile.y + j) / tile.imageHeight;
+    for (size_t i = 0; i < tile.width; i++) {
+      Real x = static_cast<Real>(tile.x + i) / tile.imageWidth;
+      rays.push_back(generateRay(Vector2(x, y)));
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// PerspectiveCamera
+
+void Base::PerspectiveCamera::generateRays(const CameraTile& tile,
+                                           vector<Ray>& rays) {
+  // Every ray spreads by about the angle between neighbouring pixels
+  Real spread = max(horizontal_.magnitude() / tile.imageWidth,
+                    up_.magnitude() / tile.imageHeight);
+  rays.assign(tile.width * tile.height, Ray(center_, direction_, 0, spread));
+
+  // The view direction plus the horizontal offset of each column
+  vector<Vector3> columns(tile.width);
+  for (size_t i = 0; i < tile.width; i++) {
+    Real x = static_cast<Real>(tile.x + i) / tile.imageWidth;
+    columns[i] = direction_ + (x - 0.5) * horizontal_;
+  }
+
+  Ray* ray = rays.data();
+  for (size_t j = 0; j < tile.height; j++) {
+    Real y = static_cast<Real>(tile.y + j) / tile.imageHeight;
+    Vector3 row = (y - 0.5) * up_;
+
+    size_t i = 0;
+#ifdef __SSE2__
+    // Normalize two directions at a time, with the same arithmetic as
+    // Vector3::normalize
+    const __m128d rowX = _mm_set1_pd(row.x);
+    const __m128d rowY = _mm_set1_pd(row.y);
+    const __m128d rowZ = _mm_set1_pd(row.z);
+    const __m128d zero = _mm_setzero_pd();
+    for (; i + 2 <= tile.width; i += 2, ray += 2) {
+      const Vector3& a = columns[i];
+      const Vector3& b = columns[i + 1];
+      __m128d dx = _mm_add_pd(_mm_set_pd(b.x, a.x), rowX);
+      __m128d dy = _mm_add_pd(_mm_set_pd(b.y, a.y), rowY);
+      __m128d dz = _mm_add_pd(_mm_set_pd(b.z, a.z), rowZ);
+      __m128d magnitude = _mm_sqrt_pd(
+        _mm_add_pd(_mm_add_pd(_mm_mul_pd(dx, dx), _mm_mul_pd(dy, dy)),
+                   _mm_mul_pd(dz, dz)));
+
+      // A zero direction stays zero, as it does in Vector3::normalize
+      __m128d nonZero = _mm_cmpneq_pd(magnitude, zero);
+      dx = _mm_and_pd(_mm_div_pd(dx, magnitude), nonZero);
+      dy = _mm_and_pd(_mm_div_pd(dy, magnitude), nonZero);
+      dz = _mm_and_pd(_mm_div_pd(dz, magnitude), nonZero);
+
+      double x[2], y[2], z[2];
+      _mm_storeu_pd(x, dx);
+      _mm_storeu_pd(y, dy);
+      _mm_storeu_pd(z, dz);
+      ray[0].direction = Vector3(x[0], y[0], z[0]);
+      ray[1].direction = Vector3(x[1], y[1], z[1]);
+    }
+#endif
+    for (; i < tile.width; i++, ray++) {
+      ray->direction = (columns[i] + row).normalize();
+    }
+  }
+}
@@ -14,8 +14,28 @@
 #include "vector2.hpp"
 #include "vector3.hpp"
 
+#include <vector>
+
 namespace Base {
-  
+  //////////////////////////////////////////////////////////////////////////////
+  // Struct: CameraTile
+  //
+  // A rectangle of pixels of an image for which rays are to be generated.
+  // Pixel (i, j) of the image is sampled at the point (i / imageWidth,
+  // j / imageHeight) of the screen.
+  struct CameraTile {
+    size_t x, y;                    // The first pixel of the tile
+    size_t width, height;           // The size of the tile in pixels
+    size_t imageWidth, imageHeight; // The size of the whole image in pixels
+
+    CameraTile(const size_t& tileX, const size_t& tileY,
+               const size_t& tileWidth, const size_t& tileHeight,
+               const size_t& fullWidth, const size_t& fullHeight)
+      : x(tileX), y(tileY), width(tileWidth), height(tileHeight),
+        imageWidth(fullWidth), imageHeight(fullHeight)
+    { }
+  };
+
   //////////////////////////////////////////////////////////////////////////////
   // Class: Camera
   //
@@ -34,6 +54,17 @@ namespace Base {
     // Returns a ray traveling from the given point into the scene in an
     // appropriately chosen direction.
     virtual Ray generateRay(const Vector2& point) = 0;
+
+    ////////////////////////////////////////////////////////////////////////////
+    // Function: generateRays
+    //
+    // Parameters:
+    //   tile - The pixels to generate rays for
+    //   rays - Receives the ray of each pixel of the tile, a row at a time
+    //
+    // Generates the rays for a whole tile of pixels at once. The rays are
+    // those generateRay returns for the sample point of each pixel.
+    virtual void generateRays(const CameraTile& tile, std::vector<Ray>& rays);
   };
 
   //////////////////////////////////////////////////////////////////////////////
@@ -117,6 +148,50 @@ namespace Base {
       dir += (point.y - 0.5) * up_;
       return Ray(center_, dir.normalize());
     }
+
+    ////////////////////////////////////////////////////////////////////////////
+    // Function: generateRays
+    //
+    // Generates the same rays as generateRay without a call per pixel. The
+    // offset of each column from the view direction is found once for the
+    // tile and that of each row once per row, leaving one addition per pixel,
+    // and the directions are normalized two at a time. Each ray is given the
+    // spread of a pixel, for filtering textures (see Ray).
+    void generateRays(const CameraTile& tile, std::vector<Ray>& rays);
+
+    ////////////////////////////////////////////////////////////////////////////
+    // Function: project
+    //
+    // Parameters:
+    //   point - A point in the scene
+    //   result - Receives the screen position and depth of the point
+    //
+    // The inverse of generateRay: finds the screen position (on [0, 1] if
+    // the point is in view) of the ray through the given point, storing it
+    // in result.x and result.y and the distance of the point along the view
+    // direction in result.z. Returns false if the point is not in front of
+    // the camera.
+    bool project(const Vector3& point, Vector3& result) const {
+      Vector3 offset = point - center_;
+      Real depth = offset.dotProduct(direction_);
+      if (depth <= 0) {
+	return false;
+      }
+
+      // The horizontal and up vectors are perpendicular to the direction,
+      // so the ray through the point has offset / depth as its direction.
+      result.x = 0.5 + offset.dotProduct(horizontal_) /
+        (depth * horizontal_.dotProduct(horizontal_));
+      result.y = 0.5 + offset.dotProduct(up_) / (depth * up_.dotProduct(up_));
+      result.z = depth;
+      return true;
+    }
+
+    ////////////////////////////////////////////////////////////////////////////
+    // Function: getCenter
+    //
+    // Returns the position of the camera
+    const Vector3& getCenter() const { return center_; }
   private:
     Vector3 center_;
     Vector3 direction_;
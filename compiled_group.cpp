@@ -0,0 +1,170 @@
+////////////////////////////////////////////////////////////////////////////////
+// Base: A Simple Graphics Suite
+// Author: Eric Scrivner
+//
+// Time-stamp: <Last modified 2026-10-19 17:02:45 by Eric Scrivner>
+//
+// Description:
+//   A flattened copy of a group of primitives with each type of primitive
+//   stored in its own array.
+////////////////////////////////////////////////////////////////////////////////
+
+#include "compiled_group.hpp"
+#include "fast_math.hpp"
+#include "matrix33.hpp"
+
+void Base::CompiledGroup::compile(const Group& group) {
+  planes_.clear();
+  spheres_.clear();
+  triangles_.clear();
+  others_.clear();
+  otherElements_.clear();
+
+  for (size_t i = 0; i < group.numPrimitives(); i++) {
+    _add(group.getPrimitive(i), i);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void Base::CompiledGroup::_add(Primitive* primitive, const size_t& element) {
+  if (Group* group = dynamic_cast<Group*>(primitive)) {
+    for (size_t i = 0; i < group->numPrimitives(); i++) {
+      _add(group->getPrimitive(i), element);
+    }
+  } else if (Plane* plane = dynamic_cast<Plane*>(primitive)) {
+    PlaneRecord record;
+    record.normal = plane->getNormal();
+    record.flipped = -plane->getNormal();
+    record.offset = plane->getOffset();
+    record.material = plane->material;
+    record.element = element;
+    planes_.push_back(record);
+  } else if (Sphere* sphere = dynamic_cast<Sphere*>(primitive)) {
+    SphereRecord record;
+    record.center = sphere->getCenter();
+    record.radius2 = sphere->getRadius() * sphere->getRadius();
+    record.material = sphere->material;
+    record.element = element;
+    spheres_.push_back(record);
+  } else if (Triangle* triangle = dynamic_cast<Triangle*>(primitive)) {
+    Vector3 Eb = triangle->getVertex(1) - triangle->getVertex(0);
+    Vector3 Ec = triangle->getVertex(2) - triangle->getVertex(0);
+
+    TriangleRecord record;
+    record.v1 = triangle->getVertex(0);
+    record.nb = -Eb;
+    record.nc = -Ec;
+    record.minor = record.nb.y * record.nc.z - record.nb.z * record.nc.y;
+    record.normal = -(Eb.crossProduct(Ec).normalize());
+    record.material = triangle->material;
+    record.element = element;
+    triangles_.push_back(record);
+  } else {
+    others_.push_back(primitive);
+    otherElements_.push_back(element);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool Base::CompiledGroup::intersection(const Ray& ray, Hit& hit, Real tmin) {
+  const Vector3& d = ray.direction;
+  bool didHit = false;
+
+  // Planes
+  for (size_t i = 0; i < planes_.size(); i++) {
+    const PlaneRecord& plane = planes_[i];
+    Real vd = plane.normal.dotProduct(d);
+    if (fabs(vd) > 0.0001) {
+      Real v0 = plane.normal.dotProduct(ray.origin) + plane.offset;
+      Real distance = -(v0 / vd);
+      if (distance >= tmin && distance <= hit.getDistance()) {
+	hit.setNormal((vd >= 0.0) ? plane.flipped : plane.normal);
+	hit.setDistance(distance);
+	hit.setMaterial(plane.material);
+	hit.setElement(plane.element);
+	didHit = true;
+      }
+    }
+  }
+
+  // Spheres, keeping the closest and only finishing its hit at the end
+  Real closest = hit.getDistance();
+  const SphereRecord* closestSphere = 0;
+  for (size_t i = 0; i < spheres_.size(); i++) {
+    const SphereRecord& sphere = spheres_[i];
+    Vector3 co = sphere.center - ray.origin;
+    Real rayCos = co.dotProduct(d);
+    if (rayCos < 0) {
+      continue;
+    }
+
+    Vector3 perpendicular = co - (rayCos * d);
+    Real disc = sphere.radius2 - perpendicular.dotProduct(perpendicular);
+    if (disc > 0.0001) {
+      Real root = sqrt(disc);
+      Real distance = (rayCos - root < 0) ? rayCos + root : rayCos - root;
+      if (distance >= tmin && distance <= closest) {
+	closest = distance;
+	closestSphere = &sphere;
+      }
+    }
+  }
+
+  if (closestSphere != 0) {
+    Vector3 normal = ray.positionAtTime(closest) - closestSphere->center;
+    hit.setDistance(closest);
+    hit.setNormal(Normalize(normal, GetPrecision()).toVector3());
+    hit.setMaterial(closestSphere->material);
+    hit.setElement(closestSphere->element);
+    didHit = true;
+  }
+
+  // Triangles
+  const TriangleRecord* closestTriangle = 0;
+  for (size_t i = 0; i < triangles_.size(); i++) {
+    const TriangleRecord& triangle = triangles_[i];
+
+    // The determinant of [nb | nc | d]
+    Real detA = triangle.nb.x * (triangle.nc.y * d.z - triangle.nc.z * d.y) -
+      triangle.nc.x * (triangle.nb.y * d.z - triangle.nb.z * d.y) +
+      d.x * triangle.minor;
+    if (detA == 0) {
+      continue;
+    }
+
+    Vector3 Ea = triangle.v1 - ray.origin;
+    Real dist = (triangle.nb.x * (triangle.nc.y * Ea.z - triangle.nc.z * Ea.y) -
+                 triangle.nc.x * (triangle.nb.y * Ea.z - triangle.nb.z * Ea.y) +
+                 Ea.x * triangle.minor) / detA;
+    if (!(dist >= tmin && dist <= closest)) {
+      continue;
+    }
+
+    Real beta = Determinant(Ea, triangle.nc, d) / detA;
+    Real gamma = Determinant(triangle.nb, Ea, d) / detA;
+    if (beta >= 0 && gamma >= 0 && beta + gamma < 1.0) {
+      closest = dist;
+      closestTriangle = &triangle;
+    }
+  }
+
+  if (closestTriangle != 0) {
+    hit.setDistance(closest);
+    hit.setMaterial(closestTriangle->material);
+    hit.setNormal(closestTriangle->normal);
+    hit.setElement(closestTriangle->element);
+    didHit = true;
+  }
+
+  // Anything else
+  for (size_t i = 0; i < others_.size(); i++) {
+    if (others_[i]->intersection(ray, hit, tmin)) {
+      hit.setElement(otherElements_[i]);
+      didHit = true;
+    }
+  }
+
+  return didHit;
+}
@@ -0,0 +1,129 @@
+////////////////////////////////////////////////////////////////////////////////
+// Base: A Simple Graphics Suite
+// Author: Eric Scrivner
+//
+// Time-stamp: <Last modified 2026-10-19 17:02:45 by Eric Scrivner>
+//
+// Description:
+//   A flattened copy of a group of primitives with each type of primitive
+//   stored in its own array.
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef COMPILED_GROUP_HPP__
+#define COMPILED_GROUP_HPP__
+
+#include "primitive.hpp"
+
+#include <vector>
+
+namespace Base {
+  //////////////////////////////////////////////////////////////////////////////
+  // Class: CompiledGroup
+  //
+  // The primitives of a Group (and of any groups within it) sorted by type.
+  // Planes, spheres and triangles are copied into arrays of plain records,
+  // with whatever does not depend on the ray worked out in advance, and each
+  // array is intersected in a loop of its own with no virtual calls. Any
+  // other primitives are kept by pointer and intersected as they are in a
+  // Group. Hits are the same as those of the original group, except that
+  // where primitives of different types are hit at exactly the same distance
+  // the one found is not necessarily the last one added. The element of a
+  // hit is the index of the primitive in the compiled group, as Group sets
+  // it.
+  //
+  // The compiled group does not own the primitives. It is a snapshot: the
+  // records are copies of the planes, spheres and triangles as they were when
+  // compiled, and nothing done to the group or its primitives afterwards is
+  // seen until compile is called again (see Group::version). The copies are
+  // made on top of the primitives, so a triangle takes its record of 120
+  // bytes as well as its Triangle; a mesh too large for that should be
+  // added as a CompressedMesh, which is kept by pointer.
+  class CompiledGroup : public Primitive {
+  public:
+    CompiledGroup()
+      : Primitive(0)
+    { }
+
+    ////////////////////////////////////////////////////////////////////////////
+    // Function: compile
+    //
+    // Parameters:
+    //   group - The group to be compiled
+    //
+    // Replaces the contents of this compiled group with those of the given
+    // group
+    void compile(const Group& group);
+
+    ////////////////////////////////////////////////////////////////////////////
+    // Function: intersection
+    //
+    // Computes the closest intersecting primitive in this group
+    bool intersection(const Ray& ray, Hit& hit, Real tmin);
+
+    ////////////////////////////////////////////////////////////////////////////
+    // Function: numPlanes, numSpheres, numTriangles, numOthers
+    //
+    // Returns the number of primitives of each type
+    size_t numPlanes() const { return planes_.size(); }
+    size_t numSpheres() const { return spheres_.size(); }
+    size_t numTriangles() const { return triangles_.size(); }
+    size_t numOthers() const { return others_.size(); }
+  private:
+    ////////////////////////////////////////////////////////////////////////////
+    // Struct: PlaneRecord
+    //
+    // A plane as intersected by Plane::intersection
+    struct PlaneRecord {
+      Vector3   normal;   // The normal of the plane
+      Vector3   flipped;  // The normal facing the other way
+      Real      offset;   // The offset from the origin
+      Material* material; // The material of the plane
+      size_t    element;  // The index in the compiled group
+    };
+
+    ////////////////////////////////////////////////////////////////////////////
+    // Struct: SphereRecord
+    //
+    // A sphere as intersected by Sphere::intersection
+    struct SphereRecord {
+      Vector3   center;   // The center of the sphere
+      Real      radius2;  // The squared radius
+      Material* material; // The material of the sphere
+      size_t    element;  // The index in the compiled group
+    };
+
+    ////////////////////////////////////////////////////////////////////////////
+    // Struct: TriangleRecord
+    //
+    // A triangle as intersected by Triangle::intersection, which solves for
+    // the distance and barycentric coordinates by Cramer's rule. The parts of
+    // the determinants which depend only on the triangle are kept here.
+    struct TriangleRecord {
+      Vector3   v1;       // The first vertex
+      Vector3   nb, nc;   // The negated edges v1 - v2 and v1 - v3
+      Real      minor;    // nb.y * nc.z - nb.z * nc.y
+      Vector3   normal;   // The (unit) normal of the triangle
+      Material* material; // The material of the triangle
+      size_t    element;  // The index in the compiled group
+    };
+
+    ////////////////////////////////////////////////////////////////////////////
+    // Function: _add
+    //
+    // Parameters:
+    //   primitive - The primitive to add
+    //   element - The index in the compiled group of the primitive, or of
+    //             the group containing it
+    //
+    // Adds a primitive to the array for its type, flattening groups
+    void _add(Primitive* primitive, const size_t& element);
+
+    std::vector<PlaneRecord>    planes_;        // The planes
+    std::vector<SphereRecord>   spheres_;       // The spheres
+    std::vector<TriangleRecord> triangles_;     // The triangles
+    std::vector<Primitive*>     others_;        // Everything else
+    std::vector<size_t>         otherElements_; // The elements of others_
+  };
+}
+
+#endif // COMPILED_GROUP_HPP__
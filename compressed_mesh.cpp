@@ -0,0 +1,370 @@
+////////////////////////////////////////////////////////////////////////////////
+// Base: A Simple Graphics Suite
+// Author: Eric Scrivner
+//
+// Time-stamp: <Last modified 2026-10-19 17:58:40 by Eric Scrivner>
+//
+// Description:
+//   A triangle mesh primitive with quantized vertex positions and
+//   delta-coded indices, decoded as it is intersected.
+////////////////////////////////////////////////////////////////////////////////
+
+#include "compressed_mesh.hpp"
+#include "matrix33.hpp"
+#include "mesh_order.hpp"
+#include "model.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <ostream>
+#include <utility>
+using namespace std;
+
+namespace {
+  //////////////////////////////////////////////////////////////////////////////
+  // Constants
+  const uint64_t kMask21 = 0x1fffff;   // The low 21 bits
+  const size_t   kUnused = static_cast<size_t>(-1);
+
+  //////////////////////////////////////////////////////////////////////////////
+  // Function: PutDelta
+  //
+  // Appends the difference between two indices, zigzag coded so that small
+  // differences of either sign are small, seven bits to a byte with the high
+  // bit set on all but the last byte
+  void PutDelta(std::vector<uint8_t>& out, const size_t& index,
+                const size_t& previous) {
+    int64_t delta = static_cast<int64_t>(index) -
+      static_cast<int64_t>(previous);
+    uint64_t value = (static_cast<uint64_t>(delta) << 1) ^
+      static_cast<uint64_t>(delta >> 63);
+    while (value >= 0x80) {
+      out.push_back(static_cast<uint8_t>(value | 0x80));
+      value >>= 7;
+    }
+    out.push_back(static_cast<uint8_t>(value));
+  }
+
+  //////////////////////////////////////////////////////////////////////////////
+  // Function: GetDelta
+  //
+  // Reads a difference written by PutDelta, advancing data past it, and
+  // returns the index it was taken from
+  inline size_t GetDelta(const uint8_t*& data, const size_t& previous) {
+    uint64_t value = *data & 0x7f;
+    int shift = 7;
+    while (*data++ & 0x80) {
+      value |= static_cast<uint64_t>(*data & 0x7f) << shift;
+      shift += 7;
+    }
+    int64_t delta = static_cast<int64_t>(value >> 1) ^
+      -static_cast<int64_t>(value & 1);
+    return previous + delta;
+  }
+
+  //////////////////////////////////////////////////////////////////////////////
+  // Function: RoundDown, RoundUp
+  //
+  // Returns the nearest float no greater (or no less) than the given value
+  float RoundDown(const Base::Real& value) {
+    float result = static_cast<float>(value);
+    return (result > value) ? nextafterf(result, -HUGE_VALF) : result;
+  }
+
+  float RoundUp(const Base::Real& value) {
+    float result = static_cast<float>(value);
+    return (result < value) ? nextafterf(result, HUGE_VALF) : result;
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+const size_t Base::CompressedMesh::kBlockSize;
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool Base::ParseQuantization(const std::string& name,
+                             eQuantization& quantization) {
+  if (name == "16") {
+    quantization = eQuantize16;
+  } else if (name == "21") {
+    quantization = eQuantize21;
+  } else {
+    return false;
+  }
+
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+ostream& Base::operator << (ostream& out, const CompressedMeshStats& stats) {
+  out << stats.triangles << " triangles, " << stats.vertices
+      << " vertices in " << stats.totalBytes() / 1024 << " KB (vertices "
+      << stats.vertexBytes / 1024 << " KB, indices "
+      << stats.indexBytes / 1024 << " KB, hierarchy "
+      << stats.hierarchyBytes / 1024 << " KB), "
+      << stats.uncompressedBytes / 1024 << " KB uncompressed";
+  if (stats.triangles > 0) {
+    out << ", " << static_cast<double>(stats.totalBytes()) / stats.triangles
+        << " bytes per triangle";
+  }
+  return out;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// CompressedMesh
+
+Base::CompressedMesh::CompressedMesh(const Model& model,
+                                     Material* mat,
+                                     eQuantization quantization)
+  : Primitive(mat), quantization_(quantization), numTriangles_(0),
+    numVertices_(0)
+{
+  // Split the faces into fans of triangles
+  vector<size_t> triangles;
+  for (size_t f = 0; f < model.numFaces(); f++) {
+    const size_t* face = model.faceIndices(f);
+    for (size_t j = 1; j + 1 < model.faceSize(f); j++) {
+      triangles.push_back(face[0]);
+      triangles.push_back(face[j]);
+      triangles.push_back(face[j + 1]);
+    }
+  }
+
+  numTriangles_ = triangles.size() / 3;
+  if (numTriangles_ == 0) {
+    return;
+  }
+
+  // Find the bounds of the vertices used
+  Vector3 lower = model.vertex(triangles[0]);
+  Vector3 upper = lower;
+  for (size_t i = 1; i < triangles.size(); i++) {
+    const Vector3& v = model.vertex(triangles[i]);
+    lower = Vector3(min(lower.x, v.x), min(lower.y, v.y), min(lower.z, v.z));
+    upper = Vector3(max(upper.x, v.x), max(upper.y, v.y), max(upper.z, v.z));
+  }
+
+  // Sort the triangles by the Morton code of their centroids, using one
+  // scale for all axes so the curve is not stretched
+  Vector3 extent = upper - lower;
+  Real size = max(extent.x, max(extent.y, extent.z));
+  Real scale = (size > 0) ? 1 / size : 0;
+
+  vector< pair<uint64_t, size_t> > order(numTriangles_);
+  for (size_t t = 0; t < numTriangles_; t++) {
+    Vector3 centroid = (model.vertex(triangles[3 * t]) +
+                        model.vertex(triangles[3 * t + 1]) +
+                        model.vertex(triangles[3 * t + 2])) / 3;
+    Vector3 p = (centroid - lower) * scale;
+    order[t] = make_pair(MortonCode(p.x, p.y, p.z), t);
+  }
+  sort(order.begin(), order.end());
+
+  // Renumber the vertices in order of first use by the sorted triangles
+  vector<size_t> remap(model.numVertices(), kUnused);
+  vector<size_t> used;
+  vector<size_t> sorted(triangles.size());
+  for (size_t i = 0; i < numTriangles_; i++) {
+    for (size_t k = 0; k < 3; k++) {
+      size_t v = triangles[3 * order[i].second + k];
+      if (remap[v] == kUnused) {
+	remap[v] = used.size();
+	used.push_back(v);
+      }
+      sorted[3 * i + k] = remap[v];
+    }
+  }
+  numVertices_ = used.size();
+
+  // Quantize the vertices onto a grid over the bounds
+  const int bits = (quantization_ == eQuantize16) ? 16 : 21;
+  const Real maxValue = (1 << bits) - 1;
+  origin_ = lower;
+  step_ = extent / maxValue;
+
+  if (quantization_ == eQuantize16) {
+    vertices16_.reserve(3 * numVertices_);
+  } else {
+    vertices21_.reserve(numVertices_);
+  }
+
+  for (size_t i = 0; i < numVertices_; i++) {
+    const Vector3& v = model.vertex(used[i]);
+    Real position[3] = { v.x - lower.x, v.y - lower.y, v.z - lower.z };
+    Real axisExtent[3] = { extent.x, extent.y, extent.z };
+    uint64_t q[3];
+    for (int axis = 0; axis < 3; axis++) {
+      Real scaled = (axisExtent[axis] > 0)
+	? floor(position[axis] / axisExtent[axis] * maxValue + 0.5)
+	: 0;
+      q[axis] = static_cast<uint64_t>(min(max(scaled, Real(0)), maxValue));
+    }
+
+    if (quantization_ == eQuantize16) {
+      vertices16_.push_back(static_cast<uint16_t>(q[0]));
+      vertices16_.push_back(static_cast<uint16_t>(q[1]));
+      vertices16_.push_back(static_cast<uint16_t>(q[2]));
+    } else {
+      vertices21_.push_back(q[0] | (q[1] << 21) | (q[2] << 42));
+    }
+  }
+
+  // Code the indices of each block, and find the block's bounds from its
+  // decoded vertices so that they contain the triangles as intersected
+  size_t numBlocks = (numTriangles_ + kBlockSize - 1) / kBlockSize;
+  vector<float> bounds(6 * numBlocks);
+  blocks_.resize(numBlocks);
+  size_t previous = 0;
+  for (size_t b = 0; b < numBlocks; b++) {
+    assert(indices_.size() <= 0xffffffff && previous <= 0xffffffff);
+    blocks_[b].offset = indices_.size();
+    blocks_[b].base = previous;
+
+    Vector3 blockLower = getVertex(sorted[3 * b * kBlockSize]);
+    Vector3 blockUpper = blockLower;
+    size_t end = min((b + 1) * kBlockSize, numTriangles_) * 3;
+    for (size_t i = 3 * b * kBlockSize; i < end; i++) {
+      PutDelta(indices_, sorted[i], previous);
+      previous = sorted[i];
+
+      Vector3 v = getVertex(sorted[i]);
+      blockLower = Vector3(min(blockLower.x, v.x), min(blockLower.y, v.y),
+                           min(blockLower.z, v.z));
+      blockUpper = Vector3(max(blockUpper.x, v.x), max(blockUpper.y, v.y),
+                           max(blockUpper.z, v.z));
+    }
+
+    float* box = &bounds[6 * b];
+    box[0] = RoundDown(blockLower.x);
+    box[1] = RoundDown(blockLower.y);
+    box[2] = RoundDown(blockLower.z);
+    box[3] = RoundUp(blockUpper.x);
+    box[4] = RoundUp(blockUpper.y);
+    box[5] = RoundUp(blockUpper.z);
+  }
+  indices_.shrink_to_fit();
+
+  hierarchy_.build(bounds);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+Base::Vector3 Base::CompressedMesh::getVertex(const size_t& index) const {
+  assert(index < numVertices_);
+  Real x, y, z;
+  if (quantization_ == eQuantize16) {
+    const uint16_t* q = &vertices16_[3 * index];
+    x = q[0];
+    y = q[1];
+    z = q[2];
+  } else {
+    uint64_t q = vertices21_[index];
+    x = static_cast<Real>(q & kMask21);
+    y = static_cast<Real>((q >> 21) & kMask21);
+    z = static_cast<Real>(q >> 42);
+  }
+
+  return Vector3(origin_.x + x * step_.x,
+                 origin_.y + y * step_.y,
+                 origin_.z + z * step_.z);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void Base::CompressedMesh::getTriangle(const size_t& triangle,
+                                       size_t indices[3]) const {
+  assert(triangle < numTriangles_);
+
+  // Decode the block up to the triangle
+  const Block& block = blocks_[triangle / kBlockSize];
+  const uint8_t* data = &indices_[block.offset];
+  size_t previous = block.base;
+  for (size_t i = 0; i <= triangle % kBlockSize; i++) {
+    for (int k = 0; k < 3; k++) {
+      previous = indices[k] = GetDelta(data, previous);
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+Base::CompressedMeshStats Base::CompressedMesh::stats() const {
+  CompressedMeshStats stats;
+  stats.triangles = numTriangles_;
+  stats.vertices = numVertices_;
+  stats.vertexBytes = vertices16_.size() * sizeof(uint16_t) +
+    vertices21_.size() * sizeof(uint64_t);
+  stats.indexBytes = indices_.size();
+  stats.hierarchyBytes = blocks_.size() * sizeof(Block) +
+    hierarchy_.memoryBytes();
+  stats.uncompressedBytes = numVertices_ * sizeof(Vector3) +
+    3 * numTriangles_ * sizeof(size_t);
+  return stats;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool Base::CompressedMesh::intersection(const Ray& ray, Hit& hit, Real tmin) {
+  return hierarchy_.intersect(ray, hit, tmin, [&](size_t block) {
+    return _intersectBlock(ray, hit, tmin, block);
+  });
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool Base::CompressedMesh::_intersectBlock(const Ray& ray, Hit& hit,
+                                           Real tmin,
+                                           const size_t& block) const {
+  const Vector3& d = ray.direction;
+  const uint8_t* data = &indices_[blocks_[block].offset];
+  size_t previous = blocks_[block].base;
+  size_t count = min(kBlockSize, numTriangles_ - block * kBlockSize);
+
+  // Find the closest triangle hit with the same arithmetic as
+  // Triangle::intersection, and only work out its normal at the end
+  Real closest = hit.getDistance();
+  Vector3 closestEb(0, 0, 0), closestEc(0, 0, 0);
+  bool found = false;
+  for (size_t i = 0; i < count; i++) {
+    size_t a = GetDelta(data, previous);
+    size_t b = GetDelta(data, a);
+    previous = GetDelta(data, b);
+
+    Vector3 v1 = getVertex(a);
+    Vector3 Eb = getVertex(b) - v1;
+    Vector3 Ec = getVertex(previous) - v1;
+    Vector3 nb = -Eb;
+    Vector3 nc = -Ec;
+
+    Real detA = Determinant(nb, nc, d);
+    if (detA == 0) {
+      continue;
+    }
+
+    Vector3 Ea = v1 - ray.origin;
+    Real dist = Determinant(nb, nc, Ea) / detA;
+    if (!(dist >= tmin && dist <= closest)) {
+      continue;
+    }
+
+    Real beta = Determinant(Ea, nc, d) / detA;
+    Real gamma = Determinant(nb, Ea, d) / detA;
+    if (beta >= 0 && gamma >= 0 && beta + gamma < 1.0) {
+      closest = dist;
+      closestEb = Eb;
+      closestEc = Ec;
+      found = true;
+    }
+  }
+
+  if (!found) {
+    return false;
+  }
+
+  hit.setDistance(closest);
+  hit.setMaterial(material);
+  hit.setNormal(-(closestEb.crossProduct(closestEc).normalize()));
+  return true;
+}
@@ -0,0 +1,187 @@
+////////////////////////////////////////////////////////////////////////////////
+// Base: A Simple Graphics Suite
+// Author: Eric Scrivner
+//
+// Time-stamp: <Last modified 2026-10-19 17:58:40 by Eric Scrivner>
+//
+// Description:
+//   A triangle mesh primitive with quantized vertex positions and
+//   delta-coded indices, decoded as it is intersected.
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef COMPRESSED_MESH_HPP__
+#define COMPRESSED_MESH_HPP__
+
+#include "bvh.hpp"
+#include "primitive.hpp"
+
+#include <iosfwd>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+namespace Base {
+  class Model;
+
+  //////////////////////////////////////////////////////////////////////////////
+  // Enum: eQuantization
+  //
+  // The number of bits kept of each coordinate of a compressed vertex. With
+  // 16 bits a vertex takes 6 bytes and is off by at most 1/131070 of the
+  // extent of the mesh along each axis. With 21 bits it takes 8 bytes and is
+  // off by at most 1/4194302 of the extent.
+  enum eQuantization {
+    eQuantize16,
+    eQuantize21
+  };
+
+  //////////////////////////////////////////////////////////////////////////////
+  // Function: ParseQuantization
+  //
+  // Parameters:
+  //   name - The number of bits, "16" or "21"
+  //   quantization - Set to the quantization named
+  //
+  // Returns false if the name is not that of a quantization
+  bool ParseQuantization(const std::string& name, eQuantization& quantization);
+
+  //////////////////////////////////////////////////////////////////////////////
+  // Struct: CompressedMeshStats
+  //
+  // The memory used by a compressed mesh
+  struct CompressedMeshStats {
+    size_t triangles;         // Triangles in the mesh
+    size_t vertices;          // Vertices in the mesh
+    size_t vertexBytes;       // Size of the quantized vertices
+    size_t indexBytes;        // Size of the delta-coded indices
+    size_t hierarchyBytes;    // Size of the blocks and hierarchy over them
+    size_t uncompressedBytes; // Size of the same mesh as Vector3 vertices and
+                              // size_t indices, as a Model keeps it
+
+    CompressedMeshStats()
+      : triangles(0), vertices(0), vertexBytes(0), indexBytes(0),
+        hierarchyBytes(0), uncompressedBytes(0)
+    { }
+
+    ////////////////////////////////////////////////////////////////////////////
+    // Function: totalBytes
+    //
+    // Returns the total size of the compressed mesh
+    size_t totalBytes() const
+    { return vertexBytes + indexBytes + hierarchyBytes; }
+  };
+
+  //////////////////////////////////////////////////////////////////////////////
+  // Function: operator <<
+  //
+  // Writes a one line summary of the given statistics to a stream
+  std::ostream& operator << (std::ostream& out,
+                             const CompressedMeshStats& stats);
+
+  //////////////////////////////////////////////////////////////////////////////
+  // Class: CompressedMesh
+  //
+  // A triangle mesh kept in a fraction of the memory of a Group of Triangle
+  // primitives, for scans too large to hold otherwise.
+  //
+  // Vertex positions are quantized to 16 or 21 bits per axis on a grid over
+  // the bounding box of the mesh. The triangles are sorted along a Morton
+  // curve and cut into blocks of kBlockSize, and the vertices renumbered in
+  // order of first use, so that the indices of a block are close together.
+  // Each index is stored as the variable-length difference from the index
+  // before it, which for most indices takes a single byte. A bounding volume
+  // hierarchy is kept over the blocks.
+  //
+  // A block is decoded only when a ray reaches it. Its triangles are then hit
+  // exactly as Triangle primitives with the decoded (quantized) vertices
+  // would be, so the mesh differs from the original by at most the
+  // quantization error of its vertices.
+  class CompressedMesh : public Primitive {
+  public:
+    ////////////////////////////////////////////////////////////////////////////
+    // Function: CompressedMesh
+    //
+    // Parameters:
+    //   model - The mesh to compress. Faces with more than three vertices are
+    //           split into a fan of triangles as by Model::toPrimitive.
+    //   mat - The material of the mesh
+    //   quantization - The number of bits kept of each coordinate
+    CompressedMesh(const Model& model,
+                   Material* mat,
+                   eQuantization quantization = eQuantize16);
+
+    ////////////////////////////////////////////////////////////////////////////
+    // Function: intersection
+    //
+    // Computes the closest intersection with the triangles of the mesh,
+    // visiting the nearer side of the hierarchy first and skipping any part
+    // whose box is beyond the closest hit. Safe to call from several threads
+    // at once.
+    bool intersection(const Ray& ray, Hit& hit, Real tmin);
+
+    ////////////////////////////////////////////////////////////////////////////
+    // Function: getVertex
+    //
+    // Returns the given vertex as decoded from its quantized position
+    Vector3 getVertex(const size_t& index) const;
+
+    ////////////////////////////////////////////////////////////////////////////
+    // Function: getTriangle
+    //
+    // Parameters:
+    //   triangle - The index of a triangle, in the sorted order
+    //   indices - Set to the indices of the triangle's three vertices
+    //
+    // Decodes the vertex indices of a triangle
+    void getTriangle(const size_t& triangle, size_t indices[3]) const;
+
+    ////////////////////////////////////////////////////////////////////////////
+    // Function: numTriangles, numVertices
+    //
+    // Returns the number of triangles or vertices in the mesh
+    size_t numTriangles() const { return numTriangles_; }
+    size_t numVertices() const { return numVertices_; }
+
+    ////////////////////////////////////////////////////////////////////////////
+    // Function: stats
+    //
+    // Returns the memory used by the mesh
+    CompressedMeshStats stats() const;
+  private:
+    static const size_t kBlockSize = 32; // Triangles per block
+
+    ////////////////////////////////////////////////////////////////////////////
+    // Struct: Block
+    //
+    // A run of kBlockSize triangles (fewer in the last block) whose indices
+    // are coded from offset in indices_. The first index of the block is
+    // coded relative to base, and each other index relative to the one
+    // before it.
+    struct Block {
+      uint32_t offset; // The first byte of the block's coded indices
+      uint32_t base;   // The index the first index is coded against
+    };
+
+    ////////////////////////////////////////////////////////////////////////////
+    // Function: _intersectBlock
+    //
+    // Decodes the triangles of a block and tests them against the ray,
+    // updating the hit as a Group of Triangle primitives would. Returns true
+    // on a hit.
+    bool _intersectBlock(const Ray& ray, Hit& hit, Real tmin,
+                         const size_t& block) const;
+
+    eQuantization         quantization_; // The bits kept of each coordinate
+    Vector3               origin_;       // The lower corner of the grid
+    Vector3               step_;         // The size of a grid cell
+    std::vector<uint16_t> vertices16_;   // Quantized positions, 3 per vertex
+    std::vector<uint64_t> vertices21_;   // Quantized positions, 1 per vertex
+    std::vector<uint8_t>  indices_;      // The delta-coded indices
+    std::vector<Block>    blocks_;       // Where each block's indices start
+    Bvh<float>            hierarchy_;    // The hierarchy over the blocks
+    size_t                numTriangles_; // The number of triangles
+    size_t                numVertices_;  // The number of vertices
+  };
+}
+
+#endif // COMPRESSED_MESH_HPP__
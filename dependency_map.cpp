@@ -0,0 +1,80 @@
+////////////////////////////////////////////////////////////////////////////////
+// Base: A Simple Graphics Suite
+// Author: Eric Scrivner
+//
+// Time-stamp: <Last modified 2026-10-19 18:52:13 by Eric Scrivner>
+//
+// Description:
+//   Records of which scene elements each tile of a traced image depends on,
+//   so that only the tiles affected by an edit need be traced again.
+////////////////////////////////////////////////////////////////////////////////
+
+#include "dependency_map.hpp"
+
+#include <algorithm>
+using namespace std;
+
+////////////////////////////////////////////////////////////////////////////////
+
+void Base::DependencyMap::reset(const size_t& width, const size_t& height,
+                                const size_t& tileSize,
+                                const size_t& numElements) {
+  assert(tileSize > 0);
+  width_ = width;
+  height_ = height;
+  tileSize_ = tileSize;
+  tilesX_ = (width + tileSize - 1) / tileSize;
+  tilesY_ = (height + tileSize - 1) / tileSize;
+  numWords_ = (numElements + 63) / 64;
+  numElements_ = numElements;
+  bits_.assign(numTiles() * numWords_, 0);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+Base::CameraTile Base::DependencyMap::tileAt(const size_t& x,
+                                             const size_t& y) const {
+  assert(x < width_ && y < height_);
+  return CameraTile(x, y, min(tileSize_, width_ - x),
+                    min(tileSize_, height_ - y), width_, height_);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void Base::DependencyMap::record(const CameraTile& tile,
+                                 const ElementSet& touched) {
+  assert(touched.size() == numElements_);
+  uint64_t* bits = &bits_[((tile.y / tileSize_) * tilesX_ +
+                           tile.x / tileSize_) * numWords_];
+  const uint64_t* words = touched.words();
+  copy(words, words + numWords_, bits);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void Base::DependencyMap::affectedTiles(const ElementSet& edited,
+                                        vector<CameraTile>& tiles) const {
+  assert(edited.size() == numElements_);
+  tiles.clear();
+
+  // Only the words with an edited element need be looked at
+  vector<size_t> editedWords;
+  const uint64_t* words = edited.words();
+  for (size_t i = 0; i < numWords_; i++) {
+    if (words[i] != 0) {
+      editedWords.push_back(i);
+    }
+  }
+
+  for (size_t ty = 0; ty < tilesY_; ty++) {
+    for (size_t tx = 0; tx < tilesX_; tx++) {
+      const uint64_t* bits = &bits_[(ty * tilesX_ + tx) * numWords_];
+      for (size_t i = 0; i < editedWords.size(); i++) {
+	if (bits[editedWords[i]] & words[editedWords[i]]) {
+	  tiles.push_back(tileAt(tx * tileSize_, ty * tileSize_));
+	  break;
+	}
+      }
+    }
+  }
+}
@@ -0,0 +1,180 @@
+////////////////////////////////////////////////////////////////////////////////
+// Base: A Simple Graphics Suite
+// Author: Eric Scrivner
+//
+// Time-stamp: <Last modified 2026-10-19 18:52:13 by Eric Scrivner>
+//
+// Description:
+//   Records of which scene elements each tile of a traced image depends on,
+//   so that only the tiles affected by an edit need be traced again.
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef DEPENDENCY_MAP_HPP__
+#define DEPENDENCY_MAP_HPP__
+
+#include "base.hpp"
+#include "camera.hpp"
+
+#include <stdint.h>
+#include <vector>
+
+namespace Base {
+  //////////////////////////////////////////////////////////////////////////////
+  // Class: ElementSet
+  //
+  // A set of scene elements (see Scene::numElements) kept as one bit per
+  // element.
+  class ElementSet {
+  public:
+    ////////////////////////////////////////////////////////////////////////////
+    // Function: ElementSet
+    //
+    // Parameters:
+    //   size - The number of elements which may be in the set
+    //
+    // Initializes an empty set
+    explicit ElementSet(const size_t& size = 0)
+      : words_((size + 63) / 64, 0), size_(size)
+    { }
+
+    ////////////////////////////////////////////////////////////////////////////
+    // Function: resize
+    //
+    // Empties the set and changes the number of elements it may hold
+    void resize(const size_t& size) {
+      words_.assign((size + 63) / 64, 0);
+      size_ = size;
+    }
+
+    ////////////////////////////////////////////////////////////////////////////
+    // Function: clear
+    //
+    // Removes every element from the set
+    void clear() { words_.assign(words_.size(), 0); }
+
+    ////////////////////////////////////////////////////////////////////////////
+    // Function: insert
+    //
+    // Adds an element to the set. Elements beyond the size of the set (such
+    // as kNoElement) are ignored.
+    void insert(const size_t& element) {
+      if (element < size_) {
+	words_[element / 64] |= uint64_t(1) << (element % 64);
+      }
+    }
+
+    ////////////////////////////////////////////////////////////////////////////
+    // Function: contains
+    //
+    // Returns true if the given element is in the set
+    bool contains(const size_t& element) const {
+      return element < size_ &&
+        (words_[element / 64] & (uint64_t(1) << (element % 64))) != 0;
+    }
+
+    ////////////////////////////////////////////////////////////////////////////
+    // Function: size
+    //
+    // Returns the number of elements which may be in the set
+    size_t size() const { return size_; }
+
+    ////////////////////////////////////////////////////////////////////////////
+    // Function: numWords, words
+    //
+    // Returns the number of 64-bit words holding the set, and the words
+    size_t numWords() const { return words_.size(); }
+    const uint64_t* words() const { return words_.data(); }
+  private:
+    std::vector<uint64_t> words_; // A bit for each element
+    size_t                size_;  // The number of elements
+  };
+
+  //////////////////////////////////////////////////////////////////////////////
+  // Class: DependencyMap
+  //
+  // For each square tile of an image, the set of scene elements touched by
+  // the rays traced for its pixels: the primitives hit by their primary,
+  // reflected, refracted and shadow rays, and the materials of the surfaces
+  // they hit. The sets are kept as one bitset per tile, in a single array.
+  //
+  // An edit to a set of elements can then only change the tiles whose sets
+  // contain one of them (see affectedTiles), with the limits described on
+  // RetraceScene.
+  class DependencyMap {
+  public:
+    DependencyMap()
+      : width_(0), height_(0), tileSize_(0), tilesX_(0), tilesY_(0),
+        numWords_(0), numElements_(0)
+    { }
+
+    ////////////////////////////////////////////////////////////////////////////
+    // Function: reset
+    //
+    // Parameters:
+    //   width, height - The size of the image in pixels
+    //   tileSize - The size of the side of each tile in pixels
+    //   numElements - The number of elements in the scene
+    //
+    // Forgets all recorded dependencies and sets up empty tiles
+    void reset(const size_t& width, const size_t& height,
+               const size_t& tileSize, const size_t& numElements);
+
+    ////////////////////////////////////////////////////////////////////////////
+    // Function: tileAt
+    //
+    // Returns the tile starting at the given pixel, clipped to the image
+    CameraTile tileAt(const size_t& x, const size_t& y) const;
+
+    ////////////////////////////////////////////////////////////////////////////
+    // Function: record
+    //
+    // Parameters:
+    //   tile - A tile returned by tileAt
+    //   touched - The elements the rays of all the tile's pixels touched
+    //
+    // Replaces the elements the tile depends on with the given ones
+    void record(const CameraTile& tile, const ElementSet& touched);
+
+    ////////////////////////////////////////////////////////////////////////////
+    // Function: affectedTiles
+    //
+    // Parameters:
+    //   edited - The elements which have been changed
+    //   tiles - Receives the tiles which depend on any of them
+    void affectedTiles(const ElementSet& edited,
+                       std::vector<CameraTile>& tiles) const;
+
+    ////////////////////////////////////////////////////////////////////////////
+    // Function: numTiles
+    //
+    // Returns the number of tiles in the map
+    size_t numTiles() const { return tilesX_ * tilesY_; }
+
+    ////////////////////////////////////////////////////////////////////////////
+    // Function: tileSize
+    //
+    // Returns the size of the side of each tile in pixels
+    size_t tileSize() const { return tileSize_; }
+
+    ////////////////////////////////////////////////////////////////////////////
+    // Function: numElements
+    //
+    // Returns the number of scene elements the map was set up for
+    size_t numElements() const { return numElements_; }
+
+    ////////////////////////////////////////////////////////////////////////////
+    // Function: memoryBytes
+    //
+    // Returns the size of the recorded sets in bytes
+    size_t memoryBytes() const { return bits_.size() * sizeof(uint64_t); }
+  private:
+    size_t                width_, height_;  // The size of the image
+    size_t                tileSize_;        // The side of a tile in pixels
+    size_t                tilesX_, tilesY_; // The number of tiles across
+    size_t                numWords_;        // Words in the set of each tile
+    size_t                numElements_;     // Elements in the scene
+    std::vector<uint64_t> bits_;            // The sets of the tiles, in order
+  };
+}
+
+#endif // DEPENDENCY_MAP_HPP__
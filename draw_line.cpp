@@ -8,151 +8,418 @@
 //  Defines line drawing algorithms and one circle drawing algorithm.
 ////////////////////////////////////////////////////////////////////////////////
 
-#include "plot.hpp"
 #include "draw_line.hpp"
+#include "image.hpp"
+#include "plot.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+  //////////////////////////////////////////////////////////////////////////////
+  // Class: ScreenTarget
+  //
+  // Sends the pixels of the drawing algorithms to the screen through Plot
+  class ScreenTarget {
+  public:
+    ScreenTarget(const Base::Color& color = Base::Color::White)
+      : color_(color)
+    { }
+
+    void point(int x, int y) {
+      Base::Plot(x, y, color_);
+    }
+
+    void span(int y, int x0, int x1) {
+      for (int x = x0; x < x1; x++) {
+	Base::Plot(x, y, color_);
+      }
+    }
+  private:
+    Base::Color color_; // The color of every pixel drawn
+  };
+
+  //////////////////////////////////////////////////////////////////////////////
+  // Class: ImageTarget
+  //
+  // Writes the pixels of the drawing algorithms into an image, clipping
+  // anything outside of it
+  class ImageTarget {
+  public:
+    ImageTarget(Base::Image& image, const Base::Color& color)
+      : image_(image), color_(color),
+        width_(image.width()), height_(image.height())
+    { }
+
+    void point(int x, int y) {
+      if (x >= 0 && x < width_ && y >= 0 && y < height_) {
+	image_.setPixel(x, y, color_);
+      }
+    }
+
+    void span(int y, int x0, int x1) {
+      image_.fillSpan(y, x0, x1, color_);
+    }
+  private:
+    Base::Image&       image_;  // The image drawn into
+    const Base::Color& color_;  // The color of every pixel drawn
+    int                width_;  // The width of the image
+    int                height_; // The height of the image
+  };
+
+  //////////////////////////////////////////////////////////////////////////////
+  // Class: SpanBuilder
+  //
+  // Collects individually generated points into horizontal runs, passing each
+  // run on to the target as a single span
+  template <typename Target>
+  class SpanBuilder {
+  public:
+    SpanBuilder(Target& target)
+      : target_(target), y_(0), x0_(0), x1_(0)
+    { }
+
+    ~SpanBuilder() {
+      flush();
+    }
+
+    void point(int x, int y) {
+      if (x0_ < x1_ && y == y_) {
+	// Extend the current run if the point is next to either end
+	if (x == x1_) {
+	  x1_++;
+	  return;
+	}
+	if (x == x0_ - 1) {
+	  x0_--;
+	  return;
+	}
+      }
+
+      flush();
+      y_ = y;
+      x0_ = x;
+      x1_ = x + 1;
+    }
+
+    void flush() {
+      if (x0_ < x1_) {
+	target_.span(y_, x0_, x1_);
+      }
+      x0_ = x1_ = 0;
+    }
+  private:
+    Target& target_; // Where complete runs are sent
+    int     y_;      // The row of the current run
+    int     x0_;     // The first column of the current run
+    int     x1_;     // One past the last column of the current run
+  };
+
+  //////////////////////////////////////////////////////////////////////////////
+  // Function: LineDDA
+  //
+  // The Digital Differential Analyzer (DDA) line algorithm (see DrawLineDDA)
+  template <typename Target>
+  void LineDDA(Target& target, Base::Real x1, Base::Real y1,
+               Base::Real x2, Base::Real y2) {
+    // First we compute the change in the x and y directions as the difference
+    // between the given x and y coordinates.
+    Base::Real dx = x2 - x1;
+    Base::Real dy = y2 - y1;
+    Base::Real x  = x1;
+    Base::Real y  = y1;
+
+    // If the coordinates change more rapidly in the x direction than in the y
+    // direction.
+    unsigned int steps = 0;
+
+    if (fabs(dx) > fabs(dy)) {
+      // Then change at unit intervals in the x direction
+      steps = static_cast<int>(fabs(dx));
+    } else {
+      // Otherwise, change at unit intervals in the y direction
+      steps = static_cast<int>(fabs(dy));
+    }
+
+    // Now we determine the increments in the x and y directions by dividing
+    // the change in the corresponding direction by the number of steps the
+    // line will be divided into. Notice that whichever direction is changing
+    // at unit intervals will have an increment of 1. For example if
+    // steps = dx then xIncrement = dx / steps = dx / dx = 1.
+    Base::Real xIncrement = dx / steps;
+    Base::Real yIncrement = dy / steps;
+
+    // Plot successive pixels until the line is completely drawn. Successive
+    // pixels on the same row are merged into spans.
+    SpanBuilder<Target> spans(target);
+    for (unsigned int k = 0; k < steps; k++) {
+      spans.point(round(x), round(y));
+      x += xIncrement;
+      y += yIncrement;
+    }
+  }
+
+  //////////////////////////////////////////////////////////////////////////////
+  // Function: LineBresenham
+  //
+  // Bresenham's midpoint line algorithm (see DrawLineBresenham)
+  template <typename Target>
+  void LineBresenham(Target& target, Base::Real x1, Base::Real y1,
+                     Base::Real x2, Base::Real y2) {
+    // Determine whether or not the line is steep (e.g. has a slope > 1.0)
+    bool steep = fabs(y2 - y1) > fabs(x2 - x1);
+
+    // If the line is steep then the x and y values should be swapped
+    if (steep) {
+      std::swap(x1, y1);
+      std::swap(x2, y2);
+    }
+
+    // If the x coordinates are decreasing then swap the starting x coordinates
+    // and then swap the y coordinates.
+    if (x1 > x2) {
+      std::swap(x2, x1);
+      std::swap(y2, y1);
+    }
+
+    // Initialize our line plotting variables
+    int	dx    = x2 - x1;
+    int	dy    = fabs(y2 - y1);
+    int	error = dx / 2;
+    int	ystep = -1;
+    int	y     = y1;
+    int	x     = x1;
+
+    // If the y coordinates are increasing then the ystep is one otherwise it
+    // is negative one
+    if (y1 < y2) {
+      ystep = 1;
+    }
+
+    // If the line was steep then we have swapped the y and x coordinates, and
+    // every pixel is on a row of its own
+    if (steep) {
+      while (x < x2) {
+	target.point(y, x);
+
+	// Update the error term, stepping in y when it goes negative
+	error -= dy;
+	if (error < 0) {
+	  y += ystep;
+	  error += dx;
+	}
+
+	x++;
+      }
+      return;
+    }
+
+    // Otherwise pixels are drawn in horizontal runs, each ending where the
+    // line steps in the y direction
+    int runStart = x;
+    while (x < x2) {
+      error -= dy;
+      x++;
+
+      if (error < 0) {
+	target.span(y, runStart, x);
+	y += ystep;
+	error += dx;
+	runStart = x;
+      }
+    }
+
+    if (runStart < x) {
+      target.span(y, runStart, x);
+    }
+  }
+
+  //////////////////////////////////////////////////////////////////////////////
+  // Function: HorizontalRuns
+  //
+  // Draws the four mirrored spans covering the columns [x0, x1] of row y in
+  // the flat octants of a circle centered at (x_c, y_c). Columns are rounded
+  // exactly as individually plotted points would be.
+  template <typename Target>
+  void HorizontalRuns(Target& target, const Base::Real& x_c,
+                      const Base::Real& y_c, int x0, int x1, int y) {
+    int top = static_cast<int>(y + y_c);
+    int bottom = static_cast<int>(-y + y_c);
+    int right0 = static_cast<int>(x0 + x_c);
+    int right1 = static_cast<int>(x1 + x_c) + 1;
+    int left0 = static_cast<int>(-x1 + x_c);
+    int left1 = static_cast<int>(-x0 + x_c) + 1;
+
+    target.span(top, right0, right1);
+    target.span(top, left0, left1);
+    target.span(bottom, left0, left1);
+    target.span(bottom, right0, right1);
+  }
+
+  //////////////////////////////////////////////////////////////////////////////
+  // Function: CircleMidpoint
+  //
+  // The midpoint circle algorithm (see DrawCircleMidpoint)
+  template <typename Target>
+  void CircleMidpoint(Target& target, const Base::Real& x_c,
+                      const Base::Real& y_c, const Base::Real& r) {
+    // Determine the initial coordinates and plot the first point
+    int  x = 0;
+    int  y = static_cast<int>(r);
+    Base::Real p = 1.25 - r; // The decision parameter
+
+    // In the octants next to the top and bottom of the circle x advances
+    // while y stays fixed, so their points are gathered into runs of columns
+    // [runStart, x] which are drawn as spans whenever y changes.
+    int runStart = 0;
+
+    // Now advance until x and y are equal
+    while (x < y) {
+      // Plot a single point in each of the other octants of the circle, and
+      // shift each point around the true center of the circle at (x_c, y_c).
+      target.point(y + x_c, x + y_c);
+      target.point(-y + x_c, x + y_c);
+      target.point(-y + x_c, -x + y_c);
+      target.point(y + x_c, -x + y_c);
+
+      // Now determine the decision paramter at the next step based on its
+      // previous value. If the decision parameter was less than zero then
+      // the previously plotted point was inside the circle and the y
+      // coordinate need not change. If, however, the decision parameter is
+      // greater than zero our previously plotted point was outside the circle
+      // and thus we should reduce y to compensate. If the previous decision
+      // parameter was equal to zero then we were exactly on the circle and
+      // any choice we make to modify y is equally accurate for plotting the
+      // next point.
+      bool stepY = (p > 0);
+      if (stepY) {
+	p = p + (2 * x + 2) + 1 - (2 * y - 2);
+      } else {
+	p = p + (2 * x + 2) + 1;
+      }
+
+      if (stepY || x + 1 >= y) {
+	HorizontalRuns(target, x_c, y_c, runStart, x, y);
+	runStart = x + 1;
+      }
+
+      x++;
+      if (stepY) {
+	y--;
+      }
+    }
+  }
+}
 
 void Base::DrawLine(const Base::Vector3& start,
                     const Base::Vector3& end,
                     const Base::Color& color) {
-	// Set the drawing color
-	glColor3f(color.r, color.g, color.b);
-
 	// Draw the line using the fastest algorithm we have
-	Base::DrawLineBresenham(start.x, start.y, end.x, end.y);
+	ScreenTarget screen(color);
+	LineBresenham(screen, start.x, start.y, end.x, end.y);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 
 void Base::DrawLineDDA(Real x1, Real y1, Real x2, Real y2) {
-  // First we compute the change in the x and y directions as the difference
-  // between the given x and y coordinates.
-  Real dx = x2 - x1;
-  Real dy = y2 - y1;
-  Real x  = x1;
-  Real y  = y1;
-
-  // If the coordinates change more rapidly in the x direction than in the y
-  // direction.
-  unsigned int steps = 0;
-
-  if (fabs(dx) > fabs(dy)) {
-    // Then change at unit intervals in the x direction
-    steps = static_cast<int>(fabs(dx));
-  } else {
-    // Otherwise, change at unit intervals in the y direction
-    steps = static_cast<int>(fabs(dy));
-  }
-
-  // Now we determine the increments in the x and y directions by dividing
-  // the change in the corresponding direction by the number of steps the
-  // line will be divided into. Notice that whichever direction is changing
-  // at unit intervals will have an increment of 1. For example if steps = dx
-  // then xIncrement = dx / steps = dx / dx = 1.
-  Real xIncrement = dx / steps;
-  Real yIncrement = dy / steps;
-
-  // Plot successive pixels onto the screen until the line is completely
-  // drawn.
-  for (unsigned int k = 0; k < steps; k++) {
-    Plot(round(x), round(y));
-    x += xIncrement;
-    y += yIncrement;
-  }
+  ScreenTarget screen;
+  LineDDA(screen, x1, y1, x2, y2);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 
 void Base::DrawLineBresenham(Real x1, Real y1, Real x2, Real y2) {
-  // Determine whether or not the line is steep (e.g. has a slope > 1.0)
-  bool steep = fabs(y2 - y1) > fabs(x2 - x1);
-	
-  // If the line is steep then the x and y values should be swapped
-  if (steep) {
-		std::swap(x1, y1);
-		std::swap(x2, y2);
-  }
+  ScreenTarget screen;
+  LineBresenham(screen, x1, y1, x2, y2);
+}
 
-  // If the x coordinates are decreasing then swap the starting x coordinates
-  // and then swap the y coordinates.
-  if (x1 > x2) {
-		std::swap(x2, x1);
-		std::swap(y2, y1);
-  }
+////////////////////////////////////////////////////////////////////////////////
 
-  // Initialize our line plotting variables
-  int	dx    = x2 - x1;
-  int	dy    = fabs(y2 - y1);
-  int	error = dx / 2;
-  int	ystep = -1;
-  int	y     = y1;
-  int   x     = x1;
-
-  // If the y coordinates are increasing then the ystep is one otherwise it
-  // is negative one
-  if (y1 < y2) {
-    ystep = 1;
-  }
+void Base::DrawCircleMidpoint(const Real& x_c, const Real& y_c, const Real& r) {
+  ScreenTarget screen;
+  CircleMidpoint(screen, x_c, y_c, r);
+}
 
-  // While we haven't reached the final x coordinate
-  while (x < x2) {
-    // If the line was steep then we have swapped the y and x coordinates
-    if (steep) {
-      Plot(y, x);
-    } else {
-      // Otherwise plot normally
-      Plot(x, y);
-    }
+////////////////////////////////////////////////////////////////////////////////
 
-    // Update the error term
-    error -= dy;
+bool Base::ClipLine(Real& x1, Real& y1, Real& x2, Real& y2,
+                    const Real& xMin, const Real& yMin,
+                    const Real& xMax, const Real& yMax) {
+  // The line is x1 + t * dx, y1 + t * dy for t on [0, 1]. Each side of the
+  // rectangle gives a bound p * t <= q on t; sides the line enters through
+  // (p < 0) raise the lower bound and sides it leaves through lower the
+  // upper bound.
+  Real dx = x2 - x1;
+  Real dy = y2 - y1;
+  const Real p[4] = { -dx, dx, -dy, dy };
+  const Real q[4] = { x1 - xMin, xMax - x1, y1 - yMin, yMax - y1 };
+  Real t0 = 0;
+  Real t1 = 1;
 
-    // If the error term is negative step in the y direction
-    if (error < 0) {
-      y++;
-      error += dx;
+  for (int i = 0; i < 4; i++) {
+    if (p[i] == 0) {
+      // Parallel to this side, so entirely inside or outside of it
+      if (q[i] < 0) {
+	return false;
+      }
+    } else {
+      Real t = q[i] / p[i];
+      if (p[i] < 0) {
+	t0 = std::max(t0, t);
+      } else {
+	t1 = std::min(t1, t);
+      }
+      if (t0 > t1) {
+	return false;
+      }
     }
+  }
 
-    // Update the x coordinate
-    x++;
+  Real startX = x1;
+  Real startY = y1;
+  if (t1 < 1) {
+    x2 = startX + t1 * dx;
+    y2 = startY + t1 * dy;
   }
+  if (t0 > 0) {
+    x1 = startX + t0 * dx;
+    y1 = startY + t0 * dy;
+  }
+  return true;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 
-void Base::DrawCircleMidpoint(const Real& x_c, const Real& y_c, const Real& r) {
-  // Determine the initial coordinates and plot the first point
-  int  x = 0;
-  int  y = static_cast<int>(r);
-  Real p = 1.25 - r; // The decision parameter
-
-  // Now advance until x and y are equal
-  while (x < y) {
-    // Plot a single point in each octant of the circle, and shift each
-    // point around the true center of the circle at (x_c, y_c).
-    Plot(x + x_c, y + y_c);
-    Plot(y + x_c, x + y_c);
-    Plot(-y + x_c, x + y_c);
-    Plot(-x + x_c, y + y_c);
-    Plot(-x + x_c, -y + y_c);
-    Plot(-y + x_c, -x + y_c);
-    Plot(y + x_c, -x + y_c);
-    Plot(x + x_c, -y + y_c);
-
-    // Now determine the decision paramter at the next step based on its
-    // previous value. If the decision parameter was less than zero then
-    // the previously plotted point was inside the circle and the y coordinate
-    // need not change. If, however, the decision parameter is greater than
-    // zero our previously plotted point was outside the circle and thus we
-    // should reduce y to compensate. If the previous decision parameter was
-    // equal to zero then we were exactly on the circle and any choice we make
-    // to modify y is equally accurate for plotting the next point.
-    if (p <= 0) {
-      p = p + (2 * x + 2) + 1;
-      x++;
-    } else {
-      p = p + (2 * x + 2) + 1 - (2 * y - 2);
-      x++;
-      y--;
-    }
-  }
+void Base::DrawLine(Image& image,
+                    const Vector3& start,
+                    const Vector3& end,
+                    const Color& color) {
+  DrawLineBresenham(image, start.x, start.y, end.x, end.y, color);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void Base::DrawLineDDA(Image& image,
+                       Real x1, Real y1, Real x2, Real y2,
+                       const Color& color) {
+  ImageTarget target(image, color);
+  LineDDA(target, x1, y1, x2, y2);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void Base::DrawLineBresenham(Image& image,
+                             Real x1, Real y1, Real x2, Real y2,
+                             const Color& color) {
+  ImageTarget target(image, color);
+  LineBresenham(target, x1, y1, x2, y2);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void Base::DrawCircleMidpoint(Image& image,
+                              const Real& x_c, const Real& y_c, const Real& r,
+                              const Color& color) {
+  ImageTarget target(image, color);
+  CircleMidpoint(target, x_c, y_c, r);
 }
@@ -16,6 +16,10 @@
 #include "vector3.hpp"
 
 namespace Base {
+  //////////////////////////////////////////////////////////////////////////////
+  // Forward definitions
+  class Image;
+
 	//////////////////////////////////////////////////////////////////////////////
 	// Function: DrawLine
 	//
@@ -24,7 +28,8 @@ namespace Base {
 	//   end - The ending vertex of the line
 	//   color - The color of the line
 	//
-	// Draws a line of the given color between two vertices
+	// Draws a line of the given color between two vertices, plotting the
+	// pixels chosen by Bresenham's algorithm (see DrawLineBresenham)
 	void DrawLine(const Vector3& start, const Vector3& end, const Color& color);
 
   //////////////////////////////////////////////////////////////////////////////
@@ -69,6 +74,66 @@ namespace Base {
   // Uses the midpoint circle algorithm to plot a circle of radius r centered at
   // the position (x, y).
   void DrawCircleMidpoint(const Real& x_c, const Real& y_c, const Real& r);
+
+  //////////////////////////////////////////////////////////////////////////////
+  // Function: ClipLine
+  //
+  // Parameters:
+  //   x1, y1 - The first endpoint, moved onto the rectangle if outside it
+  //   x2, y2 - The second endpoint, moved onto the rectangle if outside it
+  //   xMin, yMin - The lower left corner of the clipping rectangle
+  //   xMax, yMax - The upper right corner of the clipping rectangle
+  //
+  // Clips the line to the given rectangle using the Liang-Barsky algorithm.
+  // Returns false (leaving the endpoints unchanged) if no part of the line
+  // lies within the rectangle.
+  bool ClipLine(Real& x1, Real& y1, Real& x2, Real& y2,
+                const Real& xMin, const Real& yMin,
+                const Real& xMax, const Real& yMax);
+
+  //////////////////////////////////////////////////////////////////////////////
+  // Image targets
+  //
+  // The following draw the same pixels as the functions above, but write them
+  // straight into an image in memory rather than plotting them on the screen
+  // one at a time. Horizontal runs of pixels are written as single spans, and
+  // anything outside the image is clipped. Coordinates are image pixels.
+
+  //////////////////////////////////////////////////////////////////////////////
+  // Function: DrawLine
+  //
+  // Draws a line of the given color between two vertices into an image
+  void DrawLine(Image& image,
+                const Vector3& start,
+                const Vector3& end,
+                const Color& color);
+
+  //////////////////////////////////////////////////////////////////////////////
+  // Function: DrawLineDDA
+  //
+  // Draws the line from (x1, y1) to (x2, y2) into an image using the DDA
+  // algorithm.
+  void DrawLineDDA(Image& image,
+                   Real x1, Real y1, Real x2, Real y2,
+                   const Color& color);
+
+  //////////////////////////////////////////////////////////////////////////////
+  // Function: DrawLineBresenham
+  //
+  // Draws the line from (x1, y1) to (x2, y2) into an image using Bresenham's
+  // midpoint algorithm.
+  void DrawLineBresenham(Image& image,
+                         Real x1, Real y1, Real x2, Real y2,
+                         const Color& color);
+
+  //////////////////////////////////////////////////////////////////////////////
+  // Function: DrawCircleMidpoint
+  //
+  // Draws the circle of radius r centered at (x_c, y_c) into an image using
+  // the midpoint circle algorithm.
+  void DrawCircleMidpoint(Image& image,
+                          const Real& x_c, const Real& y_c, const Real& r,
+                          const Color& color);
 }
 
 #endif // DRAW_LINE_HPP__
@@ -0,0 +1,164 @@
+////////////////////////////////////////////////////////////////////////////////
+// Base: A Simple Graphics Suite
+// Author: Eric Scrivner
+//
+// Time-stamp: <Last modified 2026-10-19 15:58:20 by Eric Scrivner>
+//
+// Description:
+//   Selectable precision for shading, with fast approximations of pow, exp
+//   and inverse square roots.
+////////////////////////////////////////////////////////////////////////////////
+
+#include "fast_math.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <stdint.h>
+
+namespace {
+  //////////////////////////////////////////////////////////////////////////////
+  // The precision used by shading
+  Base::ePrecision gPrecision = Base::ePrecisionExact;
+
+  //////////////////////////////////////////////////////////////////////////////
+  // Polynomial fits on [0, 1] of log2(1 + t) (absolute error 1.7e-5) and of
+  // 2^t (relative error 8.7e-5), found by least squares at Chebyshev nodes.
+  const Base::Real kLog2Poly[] = { 1.4418798957806531, -0.7088652174915894,
+                                   0.4152455596733585, -0.19351652376624132,
+                                   0.04526829226342569 };
+  const Base::Real kExp2Poly[] = { 0.6951228927401651, 0.22764557917246941,
+                                   0.07705804610846154 };
+
+  //////////////////////////////////////////////////////////////////////////////
+  // Function: PowerOfTwo
+  //
+  // Returns 2^e for an integer e in [-1022, 1023] by building its bits
+  Base::Real PowerOfTwo(const int& e) {
+    uint64_t bits = static_cast<uint64_t>(e + 1023) << 52;
+    Base::Real result;
+    memcpy(&result, &bits, sizeof(result));
+    return result;
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void Base::SetPrecision(const ePrecision& precision) {
+  gPrecision = precision;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+Base::ePrecision Base::GetPrecision() {
+  return gPrecision;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool Base::ParsePrecision(const std::string& name, ePrecision& precision) {
+  if (name == "exact") {
+    precision = ePrecisionExact;
+  } else if (name == "fast") {
+    precision = ePrecisionFast;
+  } else if (name == "fastest") {
+    precision = ePrecisionFastest;
+  } else {
+    return false;
+  }
+
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+Base::Real Base::FastLog2(const Real& x) {
+  // Split x into 2^e * (1 + t) with t in [0, 1)
+  uint64_t bits;
+  memcpy(&bits, &x, sizeof(bits));
+  int e = static_cast<int>((bits >> 52) & 0x7FF) - 1023;
+  bits = (bits & ((static_cast<uint64_t>(1) << 52) - 1)) |
+         (static_cast<uint64_t>(1023) << 52);
+  Real m;
+  memcpy(&m, &bits, sizeof(m));
+  Real t = m - 1;
+
+  Real p = kLog2Poly[4];
+  for (int i = 3; i >= 0; i--) {
+    p = p * t + kLog2Poly[i];
+  }
+  return e + p * t;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+Base::Real Base::FastExp2(const Real& x) {
+  if (x < -1022) {
+    return 0;
+  }
+
+  // Split x into the integer e and fraction t in [0, 1)
+  Real clamped = std::min(x, 1023.0);
+  int e = static_cast<int>(floor(clamped));
+  Real t = clamped - e;
+
+  Real p = 1 + t * (kExp2Poly[0] + t * (kExp2Poly[1] + t * kExp2Poly[2]));
+  return p * PowerOfTwo(e);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+Base::Real Base::FastExp(const Real& x) {
+  return FastExp2(x * 1.4426950408889634);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+Base::Real Base::FastPow(const Real& x, const Real& y) {
+  if (x <= 0) {
+    return (y == 0) ? 1 : 0;
+  }
+
+  return FastExp2(y * FastLog2(x));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// SpecularTable
+
+Base::SpecularTable::SpecularTable(const Real& exponent)
+  : exponent_(exponent), samples_(kNumIntervals + 1)
+{
+  for (int i = 0; i <= kNumIntervals; i++) {
+    samples_[i] = pow(-1 + 2.0 * i / kNumIntervals, exponent);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+Base::Real Base::SpecularTable::lookup(const Real& x) const {
+  Real position = (std::min(std::max(x, -1.0), 1.0) + 1) * (kNumIntervals / 2);
+  int i = std::min(static_cast<int>(position), kNumIntervals - 1);
+  Real t = position - i;
+  return samples_[i] + t * (samples_[i + 1] - samples_[i]);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+Base::Real Base::SpecularPow(const Real& x, const Real& exponent,
+                             const SpecularTable& table,
+                             const ePrecision& precision) {
+  if (precision == ePrecisionFast && table.exponent() == exponent) {
+    return table.lookup(x);
+  }
+
+  if (precision == ePrecisionFastest) {
+    // Odd integer powers of negative cosines keep their sign, as with pow
+    Real power = FastPow(fabs(x), exponent);
+    if (x < 0 && fmod(exponent, 2) == 1) {
+      power = -power;
+    }
+    return power;
+  }
+
+  return pow(x, exponent);
+}
@@ -0,0 +1,196 @@
+////////////////////////////////////////////////////////////////////////////////
+// Base: A Simple Graphics Suite
+// Author: Eric Scrivner
+//
+// Time-stamp: <Last modified 2026-10-19 15:41:52 by Eric Scrivner>
+//
+// Description:
+//   Selectable precision for shading, with fast approximations of pow, exp
+//   and inverse square roots.
+////////////////////////////////////////////////////////////////////////////////
+#ifndef FAST_MATH_HPP__
+#define FAST_MATH_HPP__
+
+#include "base.hpp"
+#include "vector_math.hpp"
+
+#include <string>
+#include <vector>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace Base {
+  //////////////////////////////////////////////////////////////////////////////
+  // Enumeration: ePrecision
+  //
+  // How accurately shading is computed. The bounds below are for a single
+  // evaluation and were measured over the whole of each function's domain.
+  //
+  //   ePrecisionExact - The C library functions. Renders are unchanged.
+  //   ePrecisionFast - Specular powers are interpolated from a per-material
+  //                    table of 2049 samples of pow(x, n) over [-1, 1]; the
+  //                    absolute error is at most n(n - 1) / (8 * 1024^2), or
+  //                    2.9e-4 for n = 50. Vectors are normalized with an
+  //                    estimated inverse square root refined by one Newton
+  //                    step, for a relative error below 2e-7.
+  //   ePrecisionFastest - Specular powers use FastPow, with a relative error
+  //                       below 1.2e-5 * |n| + 8.7e-5 (6.7e-4 for n = 50),
+  //                       and vectors are normalized with the unrefined
+  //                       estimate, for a relative error below 3.7e-4.
+  //
+  // At 8 bits per component an error of 3.9e-3 is one step, so in practice
+  // either mode is off by at most a step here and there. A render at either
+  // mode is taken to be correct if no component is further than
+  // kPrecisionMaxError from an exact render and the whole image is within
+  // kPrecisionMinPsnr of it; CompareImages measures the difference on a real
+  // render, and the -compare option fails if these bounds are exceeded.
+  enum ePrecision {
+    ePrecisionExact,
+    ePrecisionFast,
+    ePrecisionFastest
+  };
+
+  //////////////////////////////////////////////////////////////////////////////
+  // Constants
+  const Real kPrecisionMaxError = 2.0 / 255; // Two 8-bit steps
+  const Real kPrecisionMinPsnr  = 60;        // In dB
+
+  //////////////////////////////////////////////////////////////////////////////
+  // Function: SetPrecision
+  //
+  // Sets the precision used by shading. This is read by every rendering
+  // thread and must only be changed between renders.
+  void SetPrecision(const ePrecision& precision);
+
+  //////////////////////////////////////////////////////////////////////////////
+  // Function: GetPrecision
+  //
+  // Returns the precision used by shading (ePrecisionExact by default)
+  ePrecision GetPrecision();
+
+  //////////////////////////////////////////////////////////////////////////////
+  // Function: ParsePrecision
+  //
+  // Parameters:
+  //   name - One of "exact", "fast" or "fastest"
+  //   precision - Receives the named precision
+  //
+  // Returns true if the name was recognized, false otherwise.
+  bool ParsePrecision(const std::string& name, ePrecision& precision);
+
+  //////////////////////////////////////////////////////////////////////////////
+  // Function: FastLog2
+  //
+  // Returns an approximation of log2(x) for normal, finite x > 0, with an
+  // absolute error below 1.7e-5.
+  Real FastLog2(const Real& x);
+
+  //////////////////////////////////////////////////////////////////////////////
+  // Function: FastExp2
+  //
+  // Returns an approximation of 2^x, with a relative error below 8.7e-5.
+  // Results underflow to zero below -1022 and saturate above 1023.
+  Real FastExp2(const Real& x);
+
+  //////////////////////////////////////////////////////////////////////////////
+  // Function: FastExp
+  //
+  // Returns an approximation of e^x, with the relative error of FastExp2
+  Real FastExp(const Real& x);
+
+  //////////////////////////////////////////////////////////////////////////////
+  // Function: FastPow
+  //
+  // Returns an approximation of pow(x, y) for x >= 0, with a relative error
+  // below 1.2e-5 * |y| + 8.7e-5 (from the errors of FastLog2 and FastExp2).
+  Real FastPow(const Real& x, const Real& y);
+
+  //////////////////////////////////////////////////////////////////////////////
+  // Class: SpecularTable
+  //
+  // Samples of pow(x, exponent) over [-1, 1] for looking up specular powers
+  // by linear interpolation. Each material builds its own table once, when
+  // it is constructed.
+  class SpecularTable {
+  public:
+    ////////////////////////////////////////////////////////////////////////////
+    // Function: SpecularTable
+    //
+    // Parameters:
+    //   exponent - The exponent the table is sampled for
+    explicit SpecularTable(const Real& exponent);
+
+    ////////////////////////////////////////////////////////////////////////////
+    // Function: exponent
+    //
+    // Returns the exponent the table was sampled for
+    const Real& exponent() const { return exponent_; }
+
+    ////////////////////////////////////////////////////////////////////////////
+    // Function: lookup
+    //
+    // Returns pow(x, exponent()) interpolated from the table, with x clamped
+    // to [-1, 1]
+    Real lookup(const Real& x) const;
+  private:
+    static const int kNumIntervals = 2048; // Intervals covering [-1, 1]
+
+    Real              exponent_; // The exponent the table was sampled for
+    std::vector<Real> samples_;  // The kNumIntervals + 1 samples
+  };
+
+  //////////////////////////////////////////////////////////////////////////////
+  // Function: SpecularPow
+  //
+  // Parameters:
+  //   x - The cosine raised to the power
+  //   exponent - The specular exponent
+  //   table - The specular table of the material
+  //   precision - The precision to compute the power with
+  //
+  // Returns pow(x, exponent) at the given precision. The table is only used
+  // if it was sampled for the given exponent.
+  Real SpecularPow(const Real& x, const Real& exponent,
+                   const SpecularTable& table, const ePrecision& precision);
+
+  //////////////////////////////////////////////////////////////////////////////
+  // Function: InvSqrt
+  //
+  // Returns 1 / sqrt(x) at the given precision, for x > 0 and (unless exact)
+  // within the range of a float
+  inline Real InvSqrt(const Real& x, const ePrecision& precision) {
+#ifdef __SSE2__
+    if (precision != ePrecisionExact) {
+      // Estimate in single precision, which is good to about 12 bits
+      float xf = static_cast<float>(x);
+      Real y = _mm_cvtss_f32(_mm_rsqrt_ss(_mm_set_ss(xf)));
+      if (precision == ePrecisionFast) {
+	y = y * (1.5 - 0.5 * x * y * y);
+      }
+      return y;
+    }
+#endif
+    return 1 / sqrt(x);
+  }
+
+  //////////////////////////////////////////////////////////////////////////////
+  // Function: Normalize
+  //
+  // Returns the given vector scaled to unit length at the given precision, or
+  // zero if it has no length. In exact precision this is v.normalize().
+  inline Vec4 Normalize(const Vec4& v, const ePrecision& precision) {
+    if (precision == ePrecisionExact) {
+      return v.normalize();
+    }
+
+    Real length2 = v.dot(v);
+    if (length2 == 0) {
+      return Vec4(0, 0, 0);
+    }
+    return v * InvSqrt(length2, precision);
+  }
+}
+
+#endif // FAST_MATH_HPP__
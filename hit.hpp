@@ -19,6 +19,10 @@ namespace Base {
   // Forward definitions
   class Material;
 
+  //////////////////////////////////////////////////////////////////////////////
+  // Constants
+  const size_t kNoElement = static_cast<size_t>(-1); // Hit nothing in a scene
+
   //////////////////////////////////////////////////////////////////////////////
   // Class: Hit
   //
@@ -26,26 +30,38 @@ namespace Base {
   class Hit {
   public:
     Hit()
-      : distance_(0), normal_(Vector3(0,0,0)), material_(0)
+      : distance_(0), normal_(Vector3(0,0,0)), material_(0),
+        element_(kNoElement)
     { }
 
     Hit(const Real& distance,
         const Vector3& normal,
 	Material* material)
-      : distance_(distance), normal_(normal), material_(material)
+      : distance_(distance), normal_(normal), material_(material),
+        element_(kNoElement)
     { }
 
     Real getDistance() const { return distance_; }
     Vector3 getNormal() const { return normal_; }
     Material* getMaterial() const { return material_; }
 
+    ////////////////////////////////////////////////////////////////////////////
+    // Function: getElement
+    //
+    // Returns the index within the scene's group of the primitive hit (for a
+    // primitive within a nested group, the index of the outermost group), or
+    // kNoElement if it is not known
+    size_t getElement() const { return element_; }
+
     void setDistance(const Real& d) { distance_ = d; }
     void setNormal(const Vector3& n) { normal_ = n; }
     void setMaterial(Material* m) { material_ = m; }
+    void setElement(const size_t& e) { element_ = e; }
   private:
     Real distance_;  // The distance from the origin to the hit
     Vector3 normal_; // The surface normal
     Material* material_;  // The material properties of the surface hit
+    size_t element_; // The scene element hit
   };
 }
 
@@ -11,20 +11,188 @@
 #include "image.hpp"
 #include "plot.hpp"
 
+#include <algorithm>
+#include <cmath>
 #include <fstream>
 using namespace std;
 
 void Base::Image::draw(const int& xMin, const int& yMin) {
-  for (int y = 0; y < height_; y++) {
-    for (int x = 0; x < width_; x++) {
-      Plot(xMin + x, yMin + y, pixelAt(x, y));
+  // Points and lines plotted before the image are drawn beneath it
+  FlushPlots();
+
+  // The texture is created on first draw since no GL context may exist yet
+  // when the image is constructed.
+  if (texture_ == 0) {
+    glGenTextures(1, &texture_);
+    glBindTexture(GL_TEXTURE_2D, texture_);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    textureStale_ = true;
+  } else {
+    glBindTexture(GL_TEXTURE_2D, texture_);
+  }
+
+  if (textureStale_) {
+    // Upload the entire image
+    _uploadRegion(0, 0, width_, height_, true);
+    textureStale_ = false;
+  } else {
+    // Upload only the dirty span of each band
+    for (size_t band = 0; band < dirtyMin_.size(); band++) {
+      if (dirtyMin_[band] < dirtyMax_[band]) {
+	int y0 = band * kDirtyRowHeight;
+	int y1 = std::min(y0 + kDirtyRowHeight, height_);
+	_uploadRegion(dirtyMin_[band], y0, dirtyMax_[band], y1, false);
+      }
+    }
+  }
+
+  dirtyMin_.assign(dirtyMin_.size(), width_);
+  dirtyMax_.assign(dirtyMax_.size(), 0);
+
+  // Draw the image as a single textured quad
+  glEnable(GL_TEXTURE_2D);
+  glTexEnvi(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_REPLACE);
+
+  glBegin(GL_QUADS);
+  glTexCoord2i(0, 0);
+  glVertex2i(xMin, yMin);
+  glTexCoord2i(1, 0);
+  glVertex2i(xMin + width_, yMin);
+  glTexCoord2i(1, 1);
+  glVertex2i(xMin + width_, yMin + height_);
+  glTexCoord2i(0, 1);
+  glVertex2i(xMin, yMin + height_);
+  glEnd();
+
+  glDisable(GL_TEXTURE_2D);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void Base::Image::_uploadRegion(int x0, int y0, int x1, int y1,
+                                bool respecify) {
+  int regionWidth = x1 - x0;
+  int regionHeight = y1 - y0;
+
+  // Convert the region into tightly packed RGB bytes
+  uploadBuffer_.resize(regionWidth * regionHeight * 3);
+  if (uploadBuffer_.empty()) {
+    return;
+  }
+
+  Byte* out = &uploadBuffer_[0];
+
+  ImageView pixels = view();
+  rowBuffer_.resize(regionWidth);
+
+  for (int y = y0; y < y1; y++) {
+    pixels.copyRow(y, x0, x1, &rowBuffer_[0]);
+    for (int x = 0; x < regionWidth; x++) {
+      *out++ = ColorToByte(rowBuffer_[x].r);
+      *out++ = ColorToByte(rowBuffer_[x].g);
+      *out++ = ColorToByte(rowBuffer_[x].b);
     }
   }
+
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+  if (respecify) {
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB8, width_, height_, 0,
+                 GL_RGB, GL_UNSIGNED_BYTE, &uploadBuffer_[0]);
+  } else {
+    glTexSubImage2D(GL_TEXTURE_2D, 0, x0, y0, regionWidth, regionHeight,
+                    GL_RGB, GL_UNSIGNED_BYTE, &uploadBuffer_[0]);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void Base::Image::fillSpan(const int& y, int x0, int x1, const Color& color) {
+  // Clip the span to the image
+  if (y < 0 || y >= height_) {
+    return;
+  }
+  x0 = std::max(x0, 0);
+  x1 = std::min(x1, width_);
+  if (x0 >= x1) {
+    return;
+  }
+
+  if (layout_ == eRowMajor) {
+    Color* row = data_ + y * width_;
+    std::fill(row + x0, row + x1, color);
+  } else {
+    // Fill the span one tile-width run at a time
+    int x = x0;
+    while (x < x1) {
+      int runEnd = std::min((x | kImageTileMask) + 1, x1);
+      Color* run = data_ + PixelOffset(layout_, stride_, x, y);
+      std::fill(run, run + (runEnd - x), color);
+      x = runEnd;
+    }
+  }
+
+  markDirty(x0, y);
+  markDirty(x1 - 1, y);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void Base::Image::writeRow(const int& y, const int& x0, const int& x1,
+                           const Color* pixels) {
+  assert(y >= 0 && y < height_);
+  assert(x0 >= 0 && x0 <= x1 && x1 <= width_);
+  if (x0 == x1) {
+    return;
+  }
+
+  if (layout_ == eRowMajor) {
+    std::copy(pixels, pixels + (x1 - x0), data_ + y * width_ + x0);
+  } else {
+    // Copy the row one tile-width run at a time
+    int x = x0;
+    while (x < x1) {
+      int runEnd = std::min((x | kImageTileMask) + 1, x1);
+      Color* run = data_ + PixelOffset(layout_, stride_, x, y);
+      std::copy(pixels, pixels + (runEnd - x), run);
+      pixels += runEnd - x;
+      x = runEnd;
+    }
+  }
+
+  markDirty(x0, y);
+  markDirty(x1 - 1, y);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void Base::ImageView::copyRow(const int& y, const int& x0, const int& x1,
+                              Color* out) const {
+  assert(y >= 0 && y < height_);
+  assert(x0 >= 0 && x0 <= x1 && x1 <= width_);
+
+  if (layout_ == eRowMajor) {
+    const Color* row = data_ + y * width_;
+    std::copy(row + x0, row + x1, out);
+    return;
+  }
+
+  // Copy the row one tile-width run at a time
+  int x = x0;
+  while (x < x1) {
+    int runEnd = std::min((x | kImageTileMask) + 1, x1);
+    const Color* run = data_ + PixelOffset(layout_, stride_, x, y);
+    out = std::copy(run, run + (runEnd - x), out);
+    x = runEnd;
+  }
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 
-void Base::Image::saveAsTga(string fileName) {
+void Base::SaveAsTga(const ImageView& image, string fileName) {
   // If we were not given a filename
   if (fileName.length() == 0) {
     // Exit
@@ -32,13 +200,14 @@ void Base::Image::saveAsTga(string fileName) {
   }
 
   // If the file does not have the proper extension
-  if (fileName.substr(fileName.length() - 4, 4) != ".tga") {
+  if (fileName.length() < 4 ||
+      fileName.substr(fileName.length() - 4, 4) != ".tga") {
     // Add the .tga extension
     fileName += ".tga";
   }
 
   // Attempt to open the file
-  ofstream tgaOut(fileName.c_str());
+  ofstream tgaOut(fileName.c_str(), ios::out | ios::binary);
 
   // If the file couldn't be opened
   assert(tgaOut.is_open());
@@ -47,6 +216,9 @@ void Base::Image::saveAsTga(string fileName) {
     return;
   }
 
+  int width = image.width();
+  int height = image.height();
+
   tgaOut.put(0); // No image ID
   tgaOut.put(0); // No color map
   tgaOut.put(2); // Uncompressed, true color
@@ -59,22 +231,174 @@ void Base::Image::saveAsTga(string fileName) {
   tgaOut.put(0);
   tgaOut.put(0); // Y-Origin at 0
   tgaOut.put(0);
-  tgaOut.put(width_ & 0xFF); // Width (Little Endian)
-  tgaOut.put((width_ >> 8) & 0xFF);
-  tgaOut.put(height_ & 0xFF); // Height (Little Endian)
-  tgaOut.put((height_ >> 8) & 0xFF);
+  tgaOut.put(width & 0xFF); // Width (Little Endian)
+  tgaOut.put((width >> 8) & 0xFF);
+  tgaOut.put(height & 0xFF); // Height (Little Endian)
+  tgaOut.put((height >> 8) & 0xFF);
   tgaOut.put(24); // 24 bits-per-pixel
   tgaOut.put(0); // No alpha
 
-  // Output all the pixel colors in the image
-  for (int y = 0; y < height_; y++) {
-    for (int x = 0; x < width_; x++) {
-      Color c = pixelAt(x, y);
-      tgaOut.put(ColorToByte(c.b));
-      tgaOut.put(ColorToByte(c.g));
-      tgaOut.put(ColorToByte(c.r));
+  // Output all the pixel colors in the image a row at a time
+  std::vector<char> rowBytes(width * 3);
+  std::vector<Color> row(width);
+  for (int y = 0; y < height; y++) {
+    image.copyRow(y, 0, width, &row[0]);
+    for (int x = 0; x < width; x++) {
+      rowBytes[x * 3 + 0] = ColorToByte(row[x].b);
+      rowBytes[x * 3 + 1] = ColorToByte(row[x].g);
+      rowBytes[x * 3 + 2] = ColorToByte(row[x].r);
     }
+    tgaOut.write(&rowBytes[0], rowBytes.size());
   }
 
   tgaOut.close();
 }
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool Base::LoadTga(const string& fileName, Image& image) {
+  ifstream tgaIn(fileName.c_str(), ios::in | ios::binary);
+  if (!tgaIn.is_open()) {
+    return false;
+  }
+
+  unsigned char header[18];
+  if (!tgaIn.read(reinterpret_cast<char*>(header), sizeof(header))) {
+    return false;
+  }
+
+  int idLength = header[0];
+  int colorMapType = header[1];
+  int imageType = header[2];
+  int width = header[12] | (header[13] << 8);
+  int height = header[14] | (header[15] << 8);
+  int bytesPerPixel = header[16] / 8;
+  bool topOrigin = (header[17] & 0x20) != 0;
+
+  // Only true color images, uncompressed (2) or run-length encoded (10)
+  if (colorMapType != 0 || (imageType != 2 && imageType != 10) ||
+      (bytesPerPixel != 3 && bytesPerPixel != 4)) {
+    return false;
+  }
+  if (width <= 0 || height <= 0 || width > kMaxTgaSize ||
+      height > kMaxTgaSize) {
+    return false;
+  }
+  tgaIn.ignore(idLength);
+
+  // Read the pixels, expanding runs
+  size_t numBytes = static_cast<size_t>(width) * height * bytesPerPixel;
+  std::vector<unsigned char> bytes(numBytes);
+  if (imageType == 2) {
+    tgaIn.read(reinterpret_cast<char*>(&bytes[0]), numBytes);
+  } else {
+    size_t filled = 0;
+    while (filled < numBytes && tgaIn) {
+      int packet = tgaIn.get();
+      size_t count = ((packet & 0x7f) + 1) * bytesPerPixel;
+      count = min(count, numBytes - filled);
+      if (packet & 0x80) {
+	// One pixel repeated
+	unsigned char pixel[4];
+	tgaIn.read(reinterpret_cast<char*>(pixel), bytesPerPixel);
+	for (size_t i = 0; i < count; i++) {
+	  bytes[filled + i] = pixel[i % bytesPerPixel];
+	}
+      } else {
+	tgaIn.read(reinterpret_cast<char*>(&bytes[filled]), count);
+      }
+      filled += count;
+    }
+  }
+
+  if (!tgaIn) {
+    return false;
+  }
+
+  Image result(width, height);
+  for (int y = 0; y < height; y++) {
+    const unsigned char* row =
+      &bytes[static_cast<size_t>(topOrigin ? height - 1 - y : y) *
+             width * bytesPerPixel];
+    for (int x = 0; x < width; x++) {
+      const unsigned char* pixel = row + x * bytesPerPixel;
+      result.setPixel(x, y, Color(pixel[2] / 255.0, pixel[1] / 255.0,
+                                  pixel[0] / 255.0));
+    }
+  }
+
+  image = std::move(result);
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+namespace {
+  //////////////////////////////////////////////////////////////////////////////
+  // Function: Clamp
+  //
+  // Clamps a color component to [0, 1] as ColorToByte does
+  Base::Real Clamp(const Base::Real& c) {
+    return std::min(std::max(c, 0.0), 1.0);
+  }
+}
+
+Base::ImageDifference Base::CompareImages(const ImageView& image,
+                                          const ImageView& reference) {
+  assert(image.width() == reference.width());
+  assert(image.height() == reference.height());
+
+  ImageDifference diff;
+  int width = image.width();
+  int height = image.height();
+  diff.numPixels = static_cast<size_t>(width) * height;
+  if (diff.numPixels == 0) {
+    diff.psnr = RealLimits::infinity();
+    return diff;
+  }
+
+  std::vector<Color> row(width), referenceRow(width);
+  Real sumError = 0;
+  Real sumSquaredError = 0;
+  for (int y = 0; y < height; y++) {
+    image.copyRow(y, 0, width, &row[0]);
+    reference.copyRow(y, 0, width, &referenceRow[0]);
+    for (int x = 0; x < width; x++) {
+      const Color& a = row[x];
+      const Color& b = referenceRow[x];
+      Real error[3] = { fabs(Clamp(a.r) - Clamp(b.r)),
+                        fabs(Clamp(a.g) - Clamp(b.g)),
+                        fabs(Clamp(a.b) - Clamp(b.b)) };
+      for (int i = 0; i < 3; i++) {
+	diff.maxError = std::max(diff.maxError, error[i]);
+	sumError += error[i];
+	sumSquaredError += error[i] * error[i];
+      }
+
+      if (ColorToByte(a.r) != ColorToByte(b.r) ||
+          ColorToByte(a.g) != ColorToByte(b.g) ||
+          ColorToByte(a.b) != ColorToByte(b.b)) {
+	diff.differingPixels++;
+      }
+    }
+  }
+
+  Real numSamples = 3.0 * diff.numPixels;
+  diff.meanError = sumError / numSamples;
+  if (sumSquaredError == 0) {
+    diff.psnr = RealLimits::infinity();
+  } else {
+    diff.psnr = -10 * log10(sumSquaredError / numSamples);
+  }
+
+  return diff;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+ostream& Base::operator << (ostream& out, const ImageDifference& diff) {
+  out << diff.differingPixels << " of " << diff.numPixels
+      << " pixels differ, max error " << diff.maxError << ", mean error "
+      << diff.meanError << ", PSNR " << diff.psnr << " dB";
+  return out;
+}
@@ -14,46 +14,333 @@
 #include "base.hpp"
 #include "color.hpp"
 
+#include <algorithm>
+#include <ostream>
 #include <string>
+#include <utility>
+#include <vector>
 
 namespace Base {
+  //////////////////////////////////////////////////////////////////////////////
+  // Forward definitions
+  class Image;
+
+  //////////////////////////////////////////////////////////////////////////////
+  // Enumeration: eImageLayout
+  //
+  // The order in which the pixels of an image are stored in memory.
+  //
+  //   eRowMajor - Rows of pixels are stored one after another from the bottom
+  //               of the image to the top.
+  //   eTiled    - The image is split into kImageTileSize x kImageTileSize
+  //               tiles which are stored one after another in row-major order,
+  //               each holding its own pixels in row-major order. A tile of
+  //               pixels is contiguous in memory, so renderers and filters
+  //               working on small blocks touch far fewer cache lines and
+  //               pages. The storage is padded to whole tiles.
+  enum eImageLayout {
+    eRowMajor,
+    eTiled
+  };
+
+  //////////////////////////////////////////////////////////////////////////////
+  // Constants
+  const int kImageTileShift = 3; // log2 of the tile size
+  const int kImageTileSize  = 1 << kImageTileShift; // Tile edge in pixels
+  const int kImageTileMask  = kImageTileSize - 1;
+  const int kMaxTgaSize     = 16384; // Largest width or height LoadTga reads
+
+  //////////////////////////////////////////////////////////////////////////////
+  // Function: ImageStride
+  //
+  // Parameters:
+  //   layout - The storage layout of the image
+  //   width - The width of the image in pixels
+  //
+  // Returns the stride used by PixelOffset: the width of the image for
+  // row-major images and the number of tiles in a row for tiled images.
+  inline int ImageStride(const eImageLayout& layout, const int& width) {
+    if (layout == eTiled) {
+      return (width + kImageTileMask) >> kImageTileShift;
+    }
+    return width;
+  }
+
+  //////////////////////////////////////////////////////////////////////////////
+  // Function: ImageStorageSize
+  //
+  // Returns the number of pixels which must be allocated to store an image of
+  // the given dimensions in the given layout.
+  inline size_t ImageStorageSize(const eImageLayout& layout,
+                                 const int& width, const int& height) {
+    if (layout == eTiled) {
+      size_t tilesY = (height + kImageTileMask) >> kImageTileShift;
+      return ImageStride(layout, width) * tilesY *
+        kImageTileSize * kImageTileSize;
+    }
+    return static_cast<size_t>(width) * height;
+  }
+
+  //////////////////////////////////////////////////////////////////////////////
+  // Function: PixelOffset
+  //
+  // Parameters:
+  //   layout - The storage layout of the image
+  //   stride - The stride of the image as returned by ImageStride
+  //   x, y - The pixel coordinates
+  //
+  // Returns the index of the pixel (x, y) in the image storage.
+  inline size_t PixelOffset(const eImageLayout& layout, const int& stride,
+                            const int& x, const int& y) {
+    if (layout == eTiled) {
+      size_t tile = (y >> kImageTileShift) * stride + (x >> kImageTileShift);
+      return (tile << (2 * kImageTileShift)) |
+        ((y & kImageTileMask) << kImageTileShift) | (x & kImageTileMask);
+    }
+    return static_cast<size_t>(y) * stride + x;
+  }
+
+  //////////////////////////////////////////////////////////////////////////////
+  // Class: ImageView
+  //
+  // A non-owning, read-only window onto the pixels of an image. Views are
+  // cheap to copy and are used to hand a frame to a consumer (such as a file
+  // writer) without copying the pixel data.
+  class ImageView {
+  public:
+    ImageView(const Color* data, const int& w, const int& h,
+              const eImageLayout& layout = eRowMajor)
+      : width_(w), height_(h), stride_(ImageStride(layout, w)),
+        layout_(layout), data_(data)
+    { }
+
+    ////////////////////////////////////////////////////////////////////////////
+    // Function: width
+    //
+    // Returns the width of the viewed image in pixels
+    int width() const { return width_; }
+
+    ////////////////////////////////////////////////////////////////////////////
+    // Function: height
+    //
+    // Returns the height of the viewed image in pixels
+    int height() const { return height_; }
+
+    ////////////////////////////////////////////////////////////////////////////
+    // Function: layout
+    //
+    // Returns the storage layout of the viewed pixels
+    eImageLayout layout() const { return layout_; }
+
+    ////////////////////////////////////////////////////////////////////////////
+    // Function: row
+    //
+    // Returns a pointer to the first of width() contiguous pixels in row y.
+    // Only row-major images store their rows contiguously; use copyRow for
+    // images of any layout.
+    const Color* row(const int& y) const {
+      assert(layout_ == eRowMajor);
+      assert(y >= 0 && y < height_);
+      return data_ + y * width_;
+    }
+
+    ////////////////////////////////////////////////////////////////////////////
+    // Function: pixelAt
+    //
+    // Returns the color of the pixel at the given coordinates
+    const Color& pixelAt(const int& x, const int& y) const {
+      assert(x >= 0 && x < width_);
+      assert(y >= 0 && y < height_);
+      return data_[PixelOffset(layout_, stride_, x, y)];
+    }
+
+    ////////////////////////////////////////////////////////////////////////////
+    // Function: copyRow
+    //
+    // Parameters:
+    //   y - The row to be copied
+    //   x0, x1 - The range of columns [x0, x1) to be copied
+    //   out - Receives the (x1 - x0) pixels in left to right order
+    //
+    // Copies part of a row into linear order regardless of the image layout.
+    // Tiled rows are copied a tile-width run at a time.
+    void copyRow(const int& y, const int& x0, const int& x1, Color* out) const;
+  private:
+    int          width_;  // The width of the image
+    int          height_; // The height of the image
+    int          stride_; // The stride passed to PixelOffset
+    eImageLayout layout_; // The order of the pixels in memory
+    const Color* data_;   // The borrowed pixel data
+  };
+
+  //////////////////////////////////////////////////////////////////////////////
+  // Function: SaveAsTga
+  //
+  // Parameters:
+  //   image - The pixels to be saved
+  //   fileName - The name of the file to which the image will be saved
+  //
+  // Saves the given pixels to a file in Truevision-TGA format.
+  void SaveAsTga(const ImageView& image, std::string fileName);
+
+  //////////////////////////////////////////////////////////////////////////////
+  // Function: LoadTga
+  //
+  // Parameters:
+  //   fileName - The name of the Truevision-TGA file to load
+  //   image - Receives the pixels of the file
+  //
+  // Loads an uncompressed or run-length encoded true color image of 24 or 32
+  // bits per pixel (any alpha is ignored), with row 0 at the bottom as
+  // SaveAsTga writes it. Returns false if the file cannot be read, or if the
+  // image is empty or wider or taller than kMaxTgaSize.
+  bool LoadTga(const std::string& fileName, Image& image);
+
+  //////////////////////////////////////////////////////////////////////////////
+  // Struct: ImageDifference
+  //
+  // How far one image is from another, with color components clamped to
+  // [0, 1] as they are when saved.
+  struct ImageDifference {
+    size_t numPixels;       // Pixels compared
+    size_t differingPixels; // Pixels which would be saved differently
+    Real   maxError;        // Largest difference in any component
+    Real   meanError;       // Mean difference over all components
+    Real   psnr;            // Peak signal-to-noise ratio in dB (inf if equal)
+
+    ImageDifference()
+      : numPixels(0), differingPixels(0), maxError(0), meanError(0), psnr(0)
+    { }
+  };
+
+  //////////////////////////////////////////////////////////////////////////////
+  // Function: CompareImages
+  //
+  // Parameters:
+  //   image - The image to be measured
+  //   reference - The image it is measured against (of the same size)
+  //
+  // Returns the difference between two images of the same size
+  ImageDifference CompareImages(const ImageView& image,
+                                const ImageView& reference);
+
+  //////////////////////////////////////////////////////////////////////////////
+  // Function: operator <<
+  //
+  // Writes a one line summary of an image difference to a stream
+  std::ostream& operator << (std::ostream& out, const ImageDifference& diff);
+
   //////////////////////////////////////////////////////////////////////////////
   // Class: Image
   //
   // Represents an image as an array of colored pixels and allows for saving
-  // the image into the TGA file format (not copy or exception safe).
+  // the image into the TGA file format. Images are movable, so a finished
+  // frame can be handed from the renderer to its consumers without copying.
+  //
+  // For display the image is mirrored in an OpenGL texture which is uploaded
+  // lazily by draw. Pixel writes mark the rows they touch as dirty so that only
+  // the changed region is re-uploaded on the next redraw.
+  //
+  // Pixels are stored row-major unless the image is created with the eTiled
+  // layout; either way they are accessed through the same interface.
   class Image {
   public:
-    Image(const int& w, const int& h)
-      : width_(w), height_(h), data_(new Color[width_ * height_])
+    Image()
+      : width_(0), height_(0), stride_(0), layout_(eRowMajor), data_(0),
+        texture_(0), textureStale_(true)
     { }
 
+    Image(const int& w, const int& h, const eImageLayout& layout = eRowMajor)
+      : width_(w), height_(h), stride_(ImageStride(layout, w)),
+        layout_(layout), data_(new Color[ImageStorageSize(layout, w, h)]),
+        texture_(0), textureStale_(true),
+        dirtyMin_(NumDirtyRows(h), w), dirtyMax_(NumDirtyRows(h), 0)
+    { }
+
+    Image(const Image& copy)
+      : width_(copy.width_), height_(copy.height_), stride_(copy.stride_),
+        layout_(copy.layout_), data_(new Color[copy.storageSize()]),
+        texture_(0), textureStale_(true),
+        dirtyMin_(NumDirtyRows(height_), width_),
+        dirtyMax_(NumDirtyRows(height_), 0)
+    {
+      std::copy(copy.data_, copy.data_ + copy.storageSize(), data_);
+    }
+
+    ////////////////////////////////////////////////////////////////////////////
+    // Function: Image
+    //
+    // Takes ownership of the pixels (and display texture) of another image
+    // without copying them. The other image is left empty.
+    Image(Image&& other)
+      : width_(other.width_), height_(other.height_), stride_(other.stride_),
+        layout_(other.layout_), data_(other.data_),
+        texture_(other.texture_), textureStale_(other.textureStale_),
+        dirtyMin_(std::move(other.dirtyMin_)),
+        dirtyMax_(std::move(other.dirtyMax_)),
+        uploadBuffer_(std::move(other.uploadBuffer_)),
+        rowBuffer_(std::move(other.rowBuffer_))
+    {
+      other.width_ = other.height_ = other.stride_ = 0;
+      other.data_ = 0;
+      other.texture_ = 0;
+      other.textureStale_ = true;
+    }
+
     ~Image() {
+      if (texture_ != 0) {
+	glDeleteTextures(1, &texture_);
+      }
+
       delete [] data_;
     }
 
     Image& operator = (const Image& rhs) {
-      Color* tmpData = 0;
-
-      try {
-	tmpData = new Color[rhs.width_ * rhs.height_];
-	memcpy(tmpData, rhs.data_, sizeof(Color) * rhs.width_ * rhs.height_);
-      } catch (...) {
-	delete [] tmpData;
-	throw;
-      }
-      
-      if (data_ != 0) {
-	delete [] data_;
-      }
-
-      data_ = tmpData;
-      width_ = rhs.width_;
-      height_ = rhs.height_;
+      Image tmp(rhs);
+      swap(tmp);
+      return *this;
+    }
 
+    Image& operator = (Image&& rhs) {
+      // Our old pixels are released along with tmp
+      Image tmp(std::move(rhs));
+      swap(tmp);
       return *this;
     }
 
+    ////////////////////////////////////////////////////////////////////////////
+    // Function: swap
+    //
+    // Exchanges the contents of this image with another in constant time
+    void swap(Image& other) {
+      std::swap(width_, other.width_);
+      std::swap(height_, other.height_);
+      std::swap(stride_, other.stride_);
+      std::swap(layout_, other.layout_);
+      std::swap(data_, other.data_);
+      std::swap(texture_, other.texture_);
+      std::swap(textureStale_, other.textureStale_);
+      dirtyMin_.swap(other.dirtyMin_);
+      dirtyMax_.swap(other.dirtyMax_);
+      uploadBuffer_.swap(other.uploadBuffer_);
+      rowBuffer_.swap(other.rowBuffer_);
+    }
+
+    ////////////////////////////////////////////////////////////////////////////
+    // Function: view
+    //
+    // Returns a read-only view of the pixels of this image. The view borrows
+    // the pixels and is invalidated when the image is destroyed, moved from or
+    // assigned to.
+    ImageView view() const {
+      return ImageView(data_, width_, height_, layout_);
+    }
+
+    ////////////////////////////////////////////////////////////////////////////
+    // Function: layout
+    //
+    // Returns the order in which the pixels of this image are stored
+    eImageLayout layout() const { return layout_; }
 
     ////////////////////////////////////////////////////////////////////////////
     // Function: width
@@ -75,10 +362,10 @@ namespace Base {
     //   y - The y coordinate (should be positive)
     //
     // Returns the color of the pixel at the given coordinates
-    const Color pixelAt(const int& x, const int& y) {
+    const Color pixelAt(const int& x, const int& y) const {
       assert(x >= 0 && x < width_);
       assert(y >= 0 && y < height_);
-      return data_[y * width_ + x];
+      return data_[PixelOffset(layout_, stride_, x, y)];
     }
 
     ////////////////////////////////////////////////////////////////////////////
@@ -86,9 +373,9 @@ namespace Base {
     //
     // Sets all the pixels in the image to the given color
     void fill(const Color& color) {
-      for (int i = 0; i < width_ * height_; i++) {
-	data_[i] = color;
-      }
+      std::fill(data_, data_ + storageSize(), color);
+
+      textureStale_ = true;
     }
 
     ////////////////////////////////////////////////////////////////////////////
@@ -98,13 +385,42 @@ namespace Base {
     void setPixel(const int& x, const int& y, const Color& color) {
       assert(x >= 0 && x < width_);
       assert(y >= 0 && y < height_);
-      data_[y * width_ + x] = color;
+      data_[PixelOffset(layout_, stride_, x, y)] = color;
+      markDirty(x, y);
     }
 
+    ////////////////////////////////////////////////////////////////////////////
+    // Function: fillSpan
+    //
+    // Parameters:
+    //   y - The row of the span
+    //   x0, x1 - The span covers the columns [x0, x1)
+    //   color - The color the span is set to
+    //
+    // Sets a horizontal run of pixels to the given color. The span is clipped
+    // to the image, so it may lie partly or wholly outside of it.
+    void fillSpan(const int& y, int x0, int x1, const Color& color);
+
+    ////////////////////////////////////////////////////////////////////////////
+    // Function: writeRow
+    //
+    // Parameters:
+    //   y - The row to be written
+    //   x0, x1 - The columns [x0, x1) to be written (must lie in the image)
+    //   pixels - The x1 - x0 colors to store
+    //
+    // Copies a run of pixels into a row of the image; the counterpart of
+    // ImageView::copyRow.
+    void writeRow(const int& y, const int& x0, const int& x1,
+                  const Color* pixels);
+
     ////////////////////////////////////////////////////////////////////////////
     // Function: draw
     // 
-    // Draws the image onto the screen starting at position (xMin, yMin).
+    // Draws the image onto the screen starting at position (xMin, yMin). The
+    // image is drawn as a single textured quad, and only the regions changed
+    // since the last draw are uploaded to the texture. Any points and lines
+    // still waiting to be plotted (see FlushPlots) are drawn first.
     void draw(const int& xMin, const int& yMin);
 
     ////////////////////////////////////////////////////////////////////////////
@@ -114,11 +430,69 @@ namespace Base {
     //   fileName - The name of the file to which the image will be saved
     //
     // Saves this image to a file in Truevision-TGA format.
-    void saveAsTga(std::string fileName);
+    void saveAsTga(std::string fileName) const {
+      SaveAsTga(view(), fileName);
+    }
   private:
+    ////////////////////////////////////////////////////////////////////////////
+    // Constants
+    static const int kDirtyRowHeight = 32; // Pixel rows per dirty band
+
+    ////////////////////////////////////////////////////////////////////////////
+    // Function: NumDirtyRows
+    //
+    // Returns the number of dirty bands needed to cover an image of the given
+    // height.
+    static int NumDirtyRows(const int& height) {
+      return (height + kDirtyRowHeight - 1) / kDirtyRowHeight;
+    }
+
+    ////////////////////////////////////////////////////////////////////////////
+    // Function: storageSize
+    //
+    // Returns the number of pixels allocated for the image, including any
+    // padding needed by the layout.
+    size_t storageSize() const {
+      return ImageStorageSize(layout_, width_, height_);
+    }
+
+    ////////////////////////////////////////////////////////////////////////////
+    // Function: markDirty
+    //
+    // Widens the dirty span of the band containing row y to include column x.
+    void markDirty(const int& x, const int& y) {
+      int band = y / kDirtyRowHeight;
+      if (x < dirtyMin_[band]) {
+	dirtyMin_[band] = x;
+      }
+      if (x >= dirtyMax_[band]) {
+	dirtyMax_[band] = x + 1;
+      }
+    }
+
+    ////////////////////////////////////////////////////////////////////////////
+    // Function: _uploadRegion
+    //
+    // Converts the pixels in the region [x0, x1) x [y0, y1) to bytes and
+    // uploads them to the bound texture. If respecify is true the texture
+    // storage is (re)created from the whole image instead.
+    void _uploadRegion(int x0, int y0, int x1, int y1, bool respecify);
+
+    typedef std::vector<int>  SpanListT;
+    typedef std::vector<Byte> ByteListT;
+
     int width_; // The width of the image
     int height_; // The height of the image
+    int stride_; // The stride passed to PixelOffset
+    eImageLayout layout_; // The order of the pixels in memory
     Color* data_; // The image data itself
+
+    GLuint    texture_;      // The texture mirroring the image (0 if none)
+    bool      textureStale_; // Whether the whole texture must be respecified
+    SpanListT dirtyMin_;     // First dirty column in each band
+    SpanListT dirtyMax_;     // One past the last dirty column in each band
+    ByteListT uploadBuffer_; // Scratch space for converting pixels to bytes
+    std::vector<Color> rowBuffer_; // Scratch space for linearizing a row
   };
 }
 
@@ -5,7 +5,8 @@
 // Time-stamp: <Last modified 2009-12-04 19:50:27 by Eric Scrivner>
 //
 // Description:
-//   Defines a simple point light source model
+//   Defines a simple point light source model, and lights with an area which
+//   cast soft shadows
 ////////////////////////////////////////////////////////////////////////////////
 
 #ifndef LIGHT_HPP__
@@ -28,15 +29,140 @@ namespace Base {
       : color_(col), direction_(dir)
     { }
 
-    void illuminationAt(const Vector3& pnt, Vector3& dir,
-                        Color& col) {
+    virtual ~Light()
+    { }
+
+    ////////////////////////////////////////////////////////////////////////////
+    // Function: illuminationAt
+    //
+    // Parameters:
+    //   pnt - A point in the scene
+    //   dir - Set to the direction from the point towards the light
+    //   col - Set to the color of the light reaching the point, unshadowed
+    virtual void illuminationAt(const Vector3& pnt, Vector3& dir,
+                                Color& col) {
       col = color_;
       dir = -1.0 * direction_;
     } 
+
+    ////////////////////////////////////////////////////////////////////////////
+    // Function: getColor
+    //
+    // Returns the color of the light
+    const Color& getColor() const { return color_; }
   private:
     Color   color_;
     Vector3 direction_;
   };
+
+  //////////////////////////////////////////////////////////////////////////////
+  // Class: AreaLight
+  //
+  // A light with a surface, which casts soft shadows. A point is lit by the
+  // fraction of the light's surface it can see, estimated by the ray-tracer
+  // from shadow rays to points chosen with samplePoint. Shading uses the
+  // direction to the center of the light. Like the directional light, the
+  // light does not fall off with distance.
+  class AreaLight : public Light {
+  public:
+    AreaLight(const Color& col)
+      : Light(col, Vector3(0, 0, 0))
+    { }
+
+    void illuminationAt(const Vector3& pnt, Vector3& dir, Color& col) {
+      col = getColor();
+      dir = (getCenter() - pnt).normalize();
+    }
+
+    ////////////////////////////////////////////////////////////////////////////
+    // Function: getCenter
+    //
+    // Returns the center of the light's surface
+    virtual Vector3 getCenter() const = 0;
+
+    ////////////////////////////////////////////////////////////////////////////
+    // Function: samplePoint
+    //
+    // Parameters:
+    //   pnt - The point being lit
+    //   u, v - A sample point on [0, 1)
+    //
+    // Returns the point of the light's surface, as seen from pnt, which the
+    // given sample point maps to. Evenly spread sample points give evenly
+    // spread points of the surface.
+    virtual Vector3 samplePoint(const Vector3& pnt,
+                                const Real& u, const Real& v) const = 0;
+  };
+
+  //////////////////////////////////////////////////////////////////////////////
+  // Class: RectangleLight
+  //
+  // A parallelogram shaped light, such as a window or a ceiling panel
+  class RectangleLight : public AreaLight {
+  public:
+    ////////////////////////////////////////////////////////////////////////////
+    // Function: RectangleLight
+    //
+    // Parameters:
+    //   col - The color of the light
+    //   corner - A corner of the light
+    //   edgeU, edgeV - The edges of the light leaving the corner
+    RectangleLight(const Color& col, const Vector3& corner,
+                   const Vector3& edgeU, const Vector3& edgeV)
+      : AreaLight(col), corner_(corner), edgeU_(edgeU), edgeV_(edgeV)
+    { }
+
+    Vector3 getCenter() const {
+      return corner_ + 0.5 * edgeU_ + 0.5 * edgeV_;
+    }
+
+    Vector3 samplePoint(const Vector3& pnt,
+                        const Real& u, const Real& v) const {
+      return corner_ + u * edgeU_ + v * edgeV_;
+    }
+  private:
+    Vector3 corner_;        // A corner of the light
+    Vector3 edgeU_, edgeV_; // The edges leaving the corner
+  };
+
+  //////////////////////////////////////////////////////////////////////////////
+  // Class: SphereLight
+  //
+  // A spherical light, such as a bulb. The sphere is sampled over the disk
+  // it presents to the point being lit (through its center, facing the
+  // point), which is close to its true outline for points well away from it.
+  class SphereLight : public AreaLight {
+  public:
+    ////////////////////////////////////////////////////////////////////////////
+    // Function: SphereLight
+    //
+    // Parameters:
+    //   col - The color of the light
+    //   center - The center of the light
+    //   radius - The radius of the light
+    SphereLight(const Color& col, const Vector3& center, const Real& radius)
+      : AreaLight(col), center_(center), radius_(radius)
+    { }
+
+    Vector3 getCenter() const { return center_; }
+
+    Vector3 samplePoint(const Vector3& pnt,
+                        const Real& u, const Real& v) const {
+      // Find two axes across the direction to the point
+      Vector3 w = (pnt - center_).normalize();
+      Vector3 axis = (fabs(w.x) > 0.5) ? Vector3(0, 1, 0) : Vector3(1, 0, 0);
+      Vector3 a = axis.crossProduct(w).normalize();
+      Vector3 b = w.crossProduct(a);
+
+      // Map the sample onto the disk, keeping the area even
+      Real r = radius_ * sqrt(u);
+      Real phi = 2 * M_PI * v;
+      return center_ + (r * cos(phi)) * a + (r * sin(phi)) * b;
+    }
+  private:
+    Vector3 center_; // The center of the light
+    Real    radius_; // The radius of the light
+  };
 }
 
 #endif // LIGHT_HPP__
@@ -11,18 +11,33 @@
 #include <iostream>
 using namespace std;
 
+#include <algorithm>
 #include <cstdlib>
 #include <ctime>
+#include <utility>
+#include <vector>
 
 #include "base.hpp"
 #include "camera.hpp"
+#include "compressed_mesh.hpp"
+#include "dependency_map.hpp"
+#include "fast_math.hpp"
 #include "image.hpp"
 #include "light.hpp"
 #include "material.hpp"
+#include "mesh_cleanup.hpp"
+#include "mesh_lod.hpp"
+#include "mesh_order.hpp"
 #include "model.hpp"
+#include "paged_mesh.hpp"
+#include "plot.hpp"
 #include "primitive.hpp"
+#include "rasterizer.hpp"
 #include "ray_tracer.hpp"
 #include "scene.hpp"
+#include "sphere_set.hpp"
+#include "texture.hpp"
+#include "textured_material.hpp"
 using namespace Base;
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -30,13 +45,16 @@ using namespace Base;
 unsigned int kWindowWidth  = 400;
 unsigned int kWindowHeight = 200;
 const char*  kWindowTitle  = "Symphony App";
+const size_t kTileSize     = 16; // The side of the square tiles traced
+const Real   kMaxCoverageError = 0.005; // Pixels the rasterizer may miss
+const Real   kParticleSpread = 0.6; // Particle radius times cube root of count
 
 const int kXMax = (kWindowWidth / 2);
 const int kYMax = (kWindowHeight / 2);
 const int kXMin = -kXMax;
 const int kYMin = -kYMax;
 
-Image gImage(kWindowWidth, kWindowHeight);
+Image gImage; // The most recently rendered frame, displayed by Redraw
 
 ////////////////////////////////////////////////////////////////////////////////
 // Function: Redraw
@@ -49,6 +67,9 @@ void Redraw() {
   // Draw the image
   gImage.draw(kXMin, kYMin);
 
+  // Draw any points and lines still waiting in their batch
+  FlushPlots();
+
   // Swap the redraw buffer onto the screen
   glutSwapBuffers();
 }
@@ -88,26 +109,6 @@ void OnKeyPress(unsigned char key, int, int) {
   glutPostRedisplay();
 }
 
-////////////////////////////////////////////////////////////////////////////////
-// Function: ToPixelX
-//
-// Translates the given real coordinate value on [0, 1] to a pixel position
-// in terms of the number of horizontal and vertical pixels on the screen.
-int ToPixelX(const Real& coord) {
-  // Need to add rounding to avoid floating-point to int conversion errors
-  int result = static_cast<int>(roundf((coord - 0.5) * kWindowWidth + kXMax));
-  return (result >= (int)kWindowWidth) ? (kWindowWidth - 1) : result;
-}
-
-////////////////////////////////////////////////////////////////////////////////
-// Function: ToPixelY
-//
-// Same as ToPixelY but for the y pixel coordinates.
-int ToPixelY(const Real& coord) {
-  int result =  static_cast<int>(roundf((coord - 0.5) * kWindowHeight + kYMax));
-  return (result >= (int)kWindowHeight) ? (kWindowHeight - 1) : result;
-}
-
 ////////////////////////////////////////////////////////////////////////////////
 // Function: Update
 //
@@ -135,22 +136,51 @@ void InitGlut(int& argc, char* argv[]) {
   glutIdleFunc(Update);
 }
 
+////////////////////////////////////////////////////////////////////////////////
+// Function: TraceTile
+//
+// Parameters:
+//   rayTracer - The ray-tracer to trace the scene with
+//   tile - The pixels to trace
+//   rays - Space for the rays of the tile
+//   image - The image the pixels are written to
+//   touched - If given, receives the scene elements the pixels depend on
+//
+// Traces each pixel of a tile of the image
+void TraceTile(const RayTracer& rayTracer, const CameraTile& tile,
+               std::vector<Ray>& rays, Image& image, ElementSet* touched) {
+  Hit rayHit;
+
+  // Generate the rays from the camera for the pixels of the tile
+  rayTracer.getScene()->getCamera()->generateRays(tile, rays);
+
+  // Compute the shading of each pixel
+  for (size_t j = 0; j < tile.height; j++) {
+    for (size_t i = 0; i < tile.width; i++) {
+      Color pixelColor = rayTracer.traceRay(rays[j * tile.width + i], 0, 0.001,
+                                            1.0F, 1.0F, rayHit, touched);
+      image.setPixel(tile.x + i, tile.y + j, pixelColor);
+    }
+  }
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 // Function: TraceScene
 //
-// Uses the given ray-tracer to ray-trace a scene which is then saved to the
-// given output file if given.
-void TraceScene(const RayTracer& rayTracer,
-                const size_t& sceneSize,
-                Image& image) {
-  // Compute the step size for the scene
-  Real stepSize = 1.0F / (Real)sceneSize;
-  
+// Uses the given ray-tracer to ray-trace a scene into the given image. The
+// image is traced a square tile of pixels at a time, each pixel once. If a
+// dependency map is given, it is reset to record the scene elements each
+// tile depends on.
+void TraceScene(const RayTracer& rayTracer, Image& image,
+                DependencyMap* dependencies = 0) {
   // Create some useful variables for this procedure
-  Camera* sceneCam = rayTracer.getScene()->getCamera();
-  Ray nextRay(Vector3(0,0,0), Vector3(0,0,0));
-  Hit rayHit;
-  Color pixelColor;
+  const Scene* scene = rayTracer.getScene();
+  std::vector<Ray> rays;
+  ElementSet touched(scene->numElements());
+  if (dependencies != 0) {
+    dependencies->reset(image.width(), image.height(), kTileSize,
+                        scene->numElements());
+  }
 
   // Give the user some indication that things are happening
   cout << "Ray-tracing scene...";
@@ -160,15 +190,21 @@ void TraceScene(const RayTracer& rayTracer,
   clock_t start, stop;
   start = clock();
 
-  // For each pixel in the scene
-  for (Real y = 0.0F; y < 1.0F; y += stepSize) {
-    for (Real x = 0.0F; x < 1.0F; x += stepSize) {
-      // Generate the ray from the camera for the current pixel
-      nextRay = sceneCam->generateRay(Vector2(x, y));
-      
-      // Compute the shading on the current pixel
-      pixelColor = rayTracer.traceRay(nextRay, 0, 0.001, 1.0F, 1.0F, rayHit);
-      image.setPixel(ToPixelX(x), ToPixelY(y), pixelColor);
+  // For each tile of the image
+  for (size_t y = 0; y < image.height(); y += kTileSize) {
+    for (size_t x = 0; x < image.width(); x += kTileSize) {
+      CameraTile tile(x, y,
+                      std::min(kTileSize, image.width() - x),
+                      std::min(kTileSize, image.height() - y),
+                      image.width(), image.height());
+
+      if (dependencies != 0) {
+	touched.clear();
+	TraceTile(rayTracer, tile, rays, image, &touched);
+	dependencies->record(tile, touched);
+      } else {
+	TraceTile(rayTracer, tile, rays, image, 0);
+      }
     }
   }
 
@@ -184,19 +220,243 @@ void TraceScene(const RayTracer& rayTracer,
   printf("Ellapsed Time %02d:%02d\n", (int)numMins, (int)numSecs);
 }
 
+////////////////////////////////////////////////////////////////////////////////
+// Function: RetraceScene
+//
+// Parameters:
+//   rayTracer - The ray-tracer the image was traced with
+//   image - An image traced by TraceScene
+//   dependencies - The dependencies recorded by that trace, which are
+//                  updated for the tiles traced again
+//   edited - The scene elements which have been changed since
+//
+// Traces again only the tiles of the image whose rays touched an edited
+// element, and returns the number of tiles traced. An element is a primitive
+// added directly to the scene's group or a material (see Scene), so editing
+// one triangle of a model's mesh marks the whole mesh as edited.
+//
+// The scene's primitives are compiled again first, so edits made to them in
+// place are traced. This gives the same image as a full trace for edits to
+// materials, and for edits to primitives which only change what is seen by
+// rays which touched them before (such as changing a primitive's material).
+// Whole traces are needed when primitives or materials are added, when a
+// primitive is moved or grown to where a camera, shadow or secondary ray
+// which missed it before would now hit it, and when a light, the camera,
+// the ambient light or the background changes.
+size_t RetraceScene(const RayTracer& rayTracer, Image& image,
+                    DependencyMap& dependencies, const ElementSet& edited) {
+  const Scene* scene = rayTracer.getScene();
+  assert(dependencies.numElements() == scene->numElements());
+  rayTracer.compile();
+
+  std::vector<CameraTile> tiles;
+  dependencies.affectedTiles(edited, tiles);
+
+  std::vector<Ray> rays;
+  ElementSet touched(scene->numElements());
+  for (size_t i = 0; i < tiles.size(); i++) {
+    touched.clear();
+    TraceTile(rayTracer, tiles[i], rays, image, &touched);
+    dependencies.record(tiles[i], touched);
+  }
+
+  return tiles.size();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Function: CompareCoverage
+//
+// Parameters:
+//   rayTracer - The ray-tracer the scene is traced with
+//   model - The model, as placed in the scene
+//   material - The material of the model's primitive in the scene
+//   camera - The camera of the scene
+//   width, height - The size of the image
+//
+// Rasterizes the model and returns the fraction of pixels on which it
+// disagrees with the traced scene over which pixels the model covers, taken
+// as those whose camera rays first hit something of the model's material.
+// Both sample the same point of each pixel, so only pixels whose centers
+// lie within rounding of a silhouette edge should differ, along with any
+// where another primitive hides the model or the traced primitive is a
+// simplified (-lod) or quantized (-compress) copy of the model.
+Real CompareCoverage(const RayTracer& rayTracer, const Model& model,
+                     const Material* material,
+                     const PerspectiveCamera& camera,
+                     size_t width, size_t height) {
+  // Draw the model in flat white on black
+  RasterOptions options;
+  options.ambient = 1;
+  Image raster(width, height);
+  clock_t start = clock();
+  RasterStats stats = RasterizeModel(model, camera, raster, options);
+  cout << "Rasterized model: " << stats << " in "
+       << (Real)(clock() - start) / CLOCKS_PER_SEC << "s" << endl;
+
+  // Mark the pixels whose rays first hit the model
+  Image traced(width, height);
+  std::vector<Ray> rays;
+  rayTracer.getScene()->getCamera()->generateRays(
+    CameraTile(0, 0, width, height, width, height), rays);
+  for (size_t y = 0; y < height; y++) {
+    for (size_t x = 0; x < width; x++) {
+      Hit hit;
+      bool covered = rayTracer.closestHit(rays[y * width + x], 0.001, hit) &&
+	hit.getMaterial() == material;
+      traced.setPixel(x, y, covered ? Color::White : Color::Black);
+    }
+  }
+
+  ImageDifference difference = CompareImages(raster.view(), traced.view());
+  return static_cast<Real>(difference.differingPixels) / difference.numPixels;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Function: MakeParticleScene
+//
+// Parameters:
+//   centers - The centers of the particles
+//   radius - The radius of every particle
+//   material - The material of the particles
+//   floor - The material of the floor
+//   useSet - Whether to gather the particles into a SphereSet
+//
+// Builds a scene of spherical particles over the floor, seen and lit as the
+// model's scene is without soft shadows. The particles are either added to
+// the scene's group one Sphere at a time or gathered into a single SphereSet.
+Scene* MakeParticleScene(const std::vector<Vector3>& centers, Real radius,
+                         Material* material, Material* floor, bool useSet) {
+  Scene* scene = new Scene(new PerspectiveCamera(Vector3(0, 2, 8),
+                                                 Vector3(0, 0, -1),
+                                                 Vector3(0, 1, 0),
+                                                 kWindowHeight,
+                                                 2,
+                                                 60));
+  scene->setAmbient(Color(0.1, 0.1, 0.1));
+  scene->setBackgroundColor(Color(0.2, 0.1, 0.6));
+  scene->addLight(new Light(Color(0.9, 0.9, 0.9), Vector3(-1, -2, 0)));
+  scene->addLight(new Light(Color(0.6, 0.6, 0.6), Vector3(1, -2, 0)));
+
+  Arena* arena = scene->getArena();
+  Group* group = scene->getPrimitives();
+  group->addPrimitive(arena->create<Plane>(Vector3(0, 1, 0), 1, floor));
+  if (useSet) {
+    SphereSet* particles = arena->create<SphereSet>(material);
+    particles->reserve(centers.size());
+    for (size_t i = 0; i < centers.size(); i++) {
+      particles->addSphere(centers[i], radius);
+    }
+    particles->build();
+    group->addPrimitive(particles);
+  } else {
+    group->reserve(centers.size() + 1);
+    for (size_t i = 0; i < centers.size(); i++) {
+      group->addPrimitive(arena->create<Sphere>(centers[i], radius, material));
+    }
+  }
+
+  return scene;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Function: CompareParticles
+//
+// Parameters:
+//   count - The number of particles
+//   material - The material of the particles
+//   floor - The material of the floor
+//   width, height - The size of the images
+//
+// Scatters particles through the space above the floor and traces them
+// twice, once as separate Sphere primitives and once as a SphereSet,
+// reporting the time each takes. Returns the difference between the two
+// images, which should be none as the set hits exactly as its spheres do.
+ImageDifference CompareParticles(const size_t& count, Material* material,
+                                 Material* floor,
+                                 size_t width, size_t height) {
+  // The same particles every run, from a fixed linear congruential sequence
+  std::vector<Vector3> centers(count);
+  uint32_t state = 12345;
+  Real coordinates[3];
+  for (size_t i = 0; i < count; i++) {
+    for (int axis = 0; axis < 3; axis++) {
+      state = state * 1664525 + 1013904223;
+      coordinates[axis] = static_cast<Real>(state) / 4294967296.0;
+    }
+    centers[i] = Vector3(6 * coordinates[0] - 3,
+                         3.8 * coordinates[1] - 0.8,
+                         4 * coordinates[2] - 3);
+  }
+  Real radius = kParticleSpread / cbrt(static_cast<Real>(count));
+
+  Image images[2] = { Image(width, height), Image(width, height) };
+  for (int useSet = 0; useSet < 2; useSet++) {
+    clock_t start = clock();
+    RayTracer rayTracer(MakeParticleScene(centers, radius, material, floor,
+                                          useSet != 0),
+                        3, 0.01);
+    TraceScene(rayTracer, images[useSet]);
+    cout << count << " particles as " << (useSet ? "a SphereSet" : "Spheres")
+         << " built and traced in " << (Real)(clock() - start) / CLOCKS_PER_SEC
+         << "s" << endl;
+  }
+
+  return CompareImages(images[1].view(), images[0].view());
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Function: PrintUsage
+//
+// Displays the command line arguments understood by the ray-tracer
+void PrintUsage() {
+  cout << "Usage: raytrace [modelfile] [-output filename] [-size dimension]"
+       << " [-precision exact|fast|fastest] [-compare] [-compress 16|21]"
+       << " [-edit] [-softshadows] [-texture filename] [-cache] [-stats]"
+       << " [-lod] [-paged] [-raster] [-particles count]" << endl;
+  cout << "  - output : Will write a TGA file with the ray traced scene." << endl;
+  cout << "  - size : Sets the size of the square output image" << endl;
+  cout << "  - precision : Trades shading accuracy for speed (default exact)" << endl;
+  cout << "  - compare : Also traces at exact precision and reports the difference," << endl;
+  cout << "              failing if it exceeds the bounds of the precision" << endl;
+  cout << "  - compress : Keeps the model quantized to the given bits per axis" << endl;
+  cout << "  - edit : Recolors the model and retraces only the tiles it affects" << endl;
+  cout << "  - softshadows : Lights the scene with area lights" << endl;
+  cout << "  - texture : Tiles the floor with the given TGA file" << endl;
+  cout << "  - cache : Keeps a binary copy of the model next to it for faster loads" << endl;
+  cout << "  - stats : Reports the mesh cleanup and scene memory use" << endl;
+  cout << "  - lod : Traces the model at the detail of each ray's footprint" << endl;
+  cout << "  - paged : Traces the model from a paged mesh file next to it (.bpm)," << endl;
+  cout << "            writing it from the cleaned up model when out of date" << endl;
+  cout << "  - raster : Also rasterizes the model and checks it covers the pixels" << endl;
+  cout << "             it covers in the ray traced scene" << endl;
+  cout << "  - particles : Also traces the given number of spherical particles as" << endl;
+  cout << "                Spheres and as a SphereSet, checking they look the same" << endl;
+}
+
 int main(int argc, char* argv[]) {
   // If there were not enough command line arguments
   if (argc < 2) {
     // Display the usage message and abort
-    cout << "Usage: raytrace [modelfile] [-output filename] [-size dimension]" << endl;
-    cout << "  - output : Will write a TGA file with the ray traced scene." << endl;
-    cout << "  - size : Sets the size of the square output image" << endl;
+    PrintUsage();
     return 1;
   }
 
   // Parse the model filename from the command line arguments
   string modelFile = argv[1];
   string outputFile;
+  ePrecision precision = ePrecisionExact;
+  bool compare = false;
+  bool compress = false;
+  bool edit = false;
+  bool softShadows = false;
+  string textureFile;
+  bool useCache = false;
+  bool showStats = false;
+  bool useLod = false;
+  bool usePaged = false;
+  bool raster = false;
+  size_t numParticles = 0;
+  eQuantization quantization = eQuantize16;
 
   // Check for additional command line arguments
   if (argc > 2) {
@@ -218,21 +478,100 @@ int main(int argc, char* argv[]) {
 	  kWindowWidth = kWindowHeight = atoi(argv[i + 1]);
 	  i += 2;
 	}
+      } else if (std::string(argv[i]) == "-precision") { // Shading precision
+	if (argc < (i + 2) || !ParsePrecision(argv[i + 1], precision)) {
+	  cout << "Error, -precision requires one of exact, fast or fastest" << endl;
+	  return 1;
+	} else {
+	  i += 2;
+	}
+      } else if (std::string(argv[i]) == "-compare") { // Compare to exact
+	compare = true;
+	i++;
+      } else if (std::string(argv[i]) == "-compress") { // Compressed model
+	if (argc < (i + 2) || !ParseQuantization(argv[i + 1], quantization)) {
+	  cout << "Error, -compress requires 16 or 21 bits" << endl;
+	  return 1;
+	} else {
+	  compress = true;
+	  i += 2;
+	}
+      } else if (std::string(argv[i]) == "-edit") { // Incremental retrace
+	edit = true;
+	i++;
+      } else if (std::string(argv[i]) == "-softshadows") { // Area lights
+	softShadows = true;
+	i++;
+      } else if (std::string(argv[i]) == "-texture") { // Textured floor
+	if (argc < (i + 2)) { // No texture file name
+	  cout << "Error, -texture requires a TGA filename" << endl;
+	  return 1;
+	} else {
+	  textureFile = argv[i + 1];
+	  i += 2;
+	}
+      } else if (std::string(argv[i]) == "-cache") { // Binary model cache
+	useCache = true;
+	i++;
+      } else if (std::string(argv[i]) == "-stats") { // Report statistics
+	showStats = true;
+	i++;
+      } else if (std::string(argv[i]) == "-lod") { // Levels of detail
+	useLod = true;
+	i++;
+      } else if (std::string(argv[i]) == "-paged") { // Paged from disk
+	usePaged = true;
+	i++;
+      } else if (std::string(argv[i]) == "-raster") { // Rasterizer check
+	raster = true;
+	i++;
+      } else if (std::string(argv[i]) == "-particles") { // Sphere set check
+	if (argc < (i + 2) || atoi(argv[i + 1]) <= 0) {
+	  cout << "Error, -particles requires a positive number of particles"
+	       << endl;
+	  return 1;
+	} else {
+	  numParticles = atoi(argv[i + 1]);
+	  i += 2;
+	}
+      } else { // Unknown argument
+	cout << "Error, unknown command line argument " << argv[i] << endl;
+	PrintUsage();
+	return 1;
       }
     }
   }
 
+  if (raster && usePaged) {
+    cout << "Error, -raster needs the model in memory and cannot be -paged"
+         << endl;
+    return 1;
+  }
+
   // Camera setup
-  Camera* cam  = new PerspectiveCamera(Vector3(0, 2, 8),
-                                       Vector3(0, 0, -1),
-                                       Vector3(0, 1, 0),
-                                       kWindowHeight,
-                                       2,
-                                       60);
+  PerspectiveCamera* cam = new PerspectiveCamera(Vector3(0, 2, 8),
+                                                 Vector3(0, 0, -1),
+                                                 Vector3(0, 1, 0),
+                                                 kWindowHeight,
+                                                 2,
+                                                 60);
   
-  // Load the model file(s)
+  // Load the model file(s). A paged model is only loaded to write its paged
+  // mesh, which is kept while the model file's size and time are unchanged.
+  string pagedFile = modelFile + ".bpm";
+  bool pagedCurrent = usePaged && PagedMeshIsCurrent(pagedFile, modelFile);
   Model model;
-  model.load(modelFile);
+  if (!pagedCurrent) {
+    if (!model.load(modelFile, useCache)) {
+      cout << "Error, could not load model " << modelFile << endl;
+      return 1;
+    }
+    MeshCleanupStats cleanup = CleanupMesh(model);
+    if (showStats) {
+      cout << modelFile << ": " << cleanup << endl;
+    }
+    ReorderMesh(model);
+  }
   Model bunny;
   bunny.load("./data/bunny_200.obj");
 
@@ -241,9 +580,34 @@ int main(int argc, char* argv[]) {
   scene->setAmbient(Color(0.1, 0.1, 0.1));
   scene->setBackgroundColor(Color(0.2, 0.1, 0.6));
 
-  // Scene lights
-  scene->addLight(new Light(Color(0.9, 0.9, 0.9), Vector3(-1, -2, 0)));
-  scene->addLight(new Light(Color(0.6, 0.6, 0.6), Vector3(1, -2, 0)));
+  // Scene lights, in the same directions either way
+  if (softShadows) {
+    scene->addLight(new RectangleLight(Color(0.9, 0.9, 0.9),
+                                       Vector3(3, 8, -1),
+                                       Vector3(2, 0, 0),
+                                       Vector3(0, 0, 2)));
+    scene->addLight(new SphereLight(Color(0.6, 0.6, 0.6),
+                                    Vector3(-4, 8, 0),
+                                    1));
+  } else {
+    scene->addLight(new Light(Color(0.9, 0.9, 0.9), Vector3(-1, -2, 0)));
+    scene->addLight(new Light(Color(0.6, 0.6, 0.6), Vector3(1, -2, 0)));
+  }
+
+  // Floor texture, repeating every two units
+  Texture floorTexture;
+  if (textureFile.length()) {
+    if (!floorTexture.load(textureFile)) {
+      cout << "Error, could not load texture " << textureFile << endl;
+      return 1;
+    }
+    cout << "Texture: " << floorTexture.width() << "x"
+         << floorTexture.height() << ", " << floorTexture.numLevels()
+         << " levels in " << floorTexture.memoryBytes() / 1024 << " KB"
+         << endl;
+  }
+  PlanarMapping floorMapping(Vector3(0, 0, 0), Vector3(2, 0, 0),
+                             Vector3(0, 0, 2));
 
   // Scene materials
   PhongMaterial sphereOne(Color(0.1, 0.1, 0.1),
@@ -258,12 +622,15 @@ int main(int argc, char* argv[]) {
                           Color::Black,
                           Color(0.9, 0.1, 0.1),
                           1.2);
-  PhongMaterial plane(Color(0.3, 0.3, 0.3),
-                      Color::Black,
-                      0,
-                      Color::Black,
-                      Color::Black,
-                      1);
+  TexturedMaterial plane(&floorMapping,
+                         textureFile.length() ? &floorTexture : 0,
+                         0,
+                         Color(0.3, 0.3, 0.3),
+                         Color::Black,
+                         0,
+                         Color::Black,
+                         Color::Black,
+                         1);
 
   PhongMaterial trashcan(Color(0.1, 0.1, 0.1),
                       Color::White,
@@ -277,12 +644,15 @@ int main(int argc, char* argv[]) {
                          Color::Black,//Color(0.9, 0.9, 0.9),
                          Color::Black,
                          1);
+  scene->addMaterial(&plane);
+  scene->addMaterial(&bunnyMat);
                       
-  // Scene primitives
+  // Scene primitives, allocated from the scene's arena
+  Arena* arena = scene->getArena();
   Group* group = scene->getPrimitives();
-  //group->addPrimitive(new Sphere(Vector3(-2.3, 1.2, 2.0), 2, &sphereOne));
-  //group->addPrimitive(new Sphere(Vector3(-5.2, 2, 0.2), 1, &sphereTwo));
-  group->addPrimitive(new Plane(Vector3(0, 1, 0), 1, &plane));
+  //group->addPrimitive(arena->create<Sphere>(Vector3(-2.3, 1.2, 2.0), 2, &sphereOne));
+  //group->addPrimitive(arena->create<Sphere>(Vector3(-5.2, 2, 0.2), 1, &sphereTwo));
+  group->addPrimitive(arena->create<Plane>(Vector3(0, 1, 0), 1, &plane));
 
   //x Translate the model provided.
   Matrix44 trans;
@@ -293,21 +663,121 @@ int main(int argc, char* argv[]) {
   //model.transform(trans);
   //bunny.transform(scale);
 
-  group->addPrimitive(model.toPrimitive(&bunnyMat));
+  PagedMesh* pagedMesh = 0;
+  if (usePaged) {
+    // Page the model as cleaned up and placed above, so it traces the same
+    // triangles as it would in memory
+    pagedMesh = arena->create<PagedMesh>(&bunnyMat);
+    if ((!pagedCurrent && !SavePagedMesh(model, pagedFile, modelFile)) ||
+        !pagedMesh->open(pagedFile)) {
+      cout << "Error, could not page model " << modelFile << endl;
+      return 1;
+    }
+    cout << "Paged model: " << pagedMesh->numTriangles() << " triangles in "
+         << pagedMesh->numChunks() << " chunks"
+         << (pagedCurrent ? " (reused)" : "") << endl;
+    group->addPrimitive(pagedMesh);
+  } else if (useLod) {
+    LodMesh* mesh = arena->create<LodMesh>(model, &bunnyMat);
+    cout << "Model levels of detail: " << mesh->chain().numLevels() << endl;
+    group->addPrimitive(mesh);
+  } else if (compress) {
+    CompressedMesh* mesh =
+      arena->create<CompressedMesh>(model, &bunnyMat, quantization);
+    cout << "Compressed model: " << mesh->stats() << endl;
+    group->addPrimitive(mesh);
+  } else {
+    group->addPrimitive(model.toPrimitive(&bunnyMat, arena));
+  }
+  if (showStats) {
+    cout << "Scene arena: " << arena->stats() << endl;
+  }
   //group->addPrimitive(bunny.toPrimitive(&bunnyMat));
 
   // Ray-trace the given scene
   Image image(kWindowWidth, kWindowHeight);
   RayTracer rayTracer(scene, 3, 0.01);
 
-  TraceScene(rayTracer, kWindowWidth, image);
+  DependencyMap dependencies;
+  SetPrecision(precision);
+  TraceScene(rayTracer, image, edit ? &dependencies : 0);
+  if (textureFile.length()) {
+    cout << "Texel cache: " << GetTexelCacheStats() << endl;
+  }
+  if (pagedMesh != 0) {
+    cout << "Paged model: " << pagedMesh->stats() << endl;
+  }
+
+  // Measure the error of a faster precision against an exact trace
+  if (compare && precision != ePrecisionExact) {
+    Image reference(kWindowWidth, kWindowHeight);
+    SetPrecision(ePrecisionExact);
+    TraceScene(rayTracer, reference);
+    SetPrecision(precision);
+    ImageDifference difference = CompareImages(image.view(), reference.view());
+    cout << "Difference from exact: " << difference << endl;
+    if (difference.maxError > kPrecisionMaxError ||
+        difference.psnr < kPrecisionMinPsnr) {
+      cout << "Error, the difference exceeds the bounds of the precision"
+           << " (max error " << kPrecisionMaxError << ", PSNR "
+           << kPrecisionMinPsnr << " dB)" << endl;
+      return 1;
+    }
+  }
+
+  // Check that the rasterizer covers the pixels the model does when traced
+  if (raster) {
+    Real coverageError = CompareCoverage(rayTracer, model, &bunnyMat, *cam,
+                                         kWindowWidth, kWindowHeight);
+    cout << "Raster coverage differs from the trace on "
+         << coverageError * 100 << "% of pixels" << endl;
+    if (coverageError > kMaxCoverageError) {
+      cout << "Error, the raster coverage differs on more than "
+           << kMaxCoverageError * 100 << "% of pixels" << endl;
+      return 1;
+    }
+  }
+
+  // Check that a SphereSet traces its particles as separate spheres do
+  if (numParticles > 0) {
+    PhongMaterial particleMat(Color(0.9, 0.6, 0.1),
+                              Color::White,
+                              20,
+                              Color::Black,
+                              Color(0.2, 0.2, 0.2),
+                              1);
+    ImageDifference difference =
+      CompareParticles(numParticles, &particleMat, &plane,
+                       kWindowWidth, kWindowHeight);
+    cout << "Difference between the particles as Spheres and as a SphereSet: "
+         << difference << endl;
+    if (difference.differingPixels != 0) {
+      cout << "Error, the SphereSet does not trace as its spheres do" << endl;
+      return 1;
+    }
+  }
+
+  // Recolor the model and trace again only the tiles which saw it
+  if (edit) {
+    bunnyMat.diffuse = Color(0.1, 0.5, 0.1);
+    ElementSet edited(scene->numElements());
+    edited.insert(scene->materialElement(&bunnyMat));
+
+    clock_t start = clock();
+    size_t retraced = RetraceScene(rayTracer, image, dependencies, edited);
+    cout << "Retraced " << retraced << " of " << dependencies.numTiles()
+         << " tiles in " << (Real)(clock() - start) / CLOCKS_PER_SEC
+         << "s (" << dependencies.memoryBytes() << " bytes of dependencies)"
+         << endl;
+  }
 
   // If an image file was given save the image
   if (outputFile.length()) {
     image.saveAsTga(outputFile);
   }
 
-  gImage = image;
+  // Hand the finished frame over to the display without copying it
+  gImage = std::move(image);
 
   InitGlut(argc, argv);
   glutMainLoop();
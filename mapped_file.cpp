@@ -0,0 +1,63 @@
+////////////////////////////////////////////////////////////////////////////////
+// Base: A Simple Graphics Suite
+// Author: Eric Scrivner
+//
+// Time-stamp: <Last modified 2026-10-19 10:12:31 by Eric Scrivner>
+//
+// Description:
+//   Read-only memory mapping of a file.
+////////////////////////////////////////////////////////////////////////////////
+
+#include "mapped_file.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+bool Base::MappedFile::open(const std::string& fileName) {
+  close();
+
+  // Attempt to open the given file
+  int fd = ::open(fileName.c_str(), O_RDONLY);
+  if (fd < 0) {
+    return false;
+  }
+
+  // Determine the size of the mapping
+  struct stat info;
+  if (fstat(fd, &info) != 0 || !S_ISREG(info.st_mode)) {
+    ::close(fd);
+    return false;
+  }
+
+  // Empty files cannot be mapped, but are still valid
+  if (info.st_size > 0) {
+    void* mapping = mmap(0, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (mapping == MAP_FAILED) {
+      ::close(fd);
+      return false;
+    }
+
+    // The file will be read from front to back
+    madvise(mapping, info.st_size, MADV_SEQUENTIAL);
+
+    data_ = static_cast<const char*>(mapping);
+    size_ = info.st_size;
+  }
+
+  // The mapping remains valid after the descriptor is closed
+  ::close(fd);
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void Base::MappedFile::close() {
+  if (data_ != 0) {
+    munmap(const_cast<char*>(data_), size_);
+  }
+
+  data_ = 0;
+  size_ = 0;
+}
@@ -0,0 +1,71 @@
+////////////////////////////////////////////////////////////////////////////////
+// Base: A Simple Graphics Suite
+// Author: Eric Scrivner
+//
+// Time-stamp: <Last modified 2026-10-19 10:12:31 by Eric Scrivner>
+//
+// Description:
+//   Read-only memory mapping of a file.
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef MAPPED_FILE_HPP__
+#define MAPPED_FILE_HPP__
+
+#include "base.hpp"
+
+#include <string>
+
+namespace Base {
+  //////////////////////////////////////////////////////////////////////////////
+  // Class: MappedFile
+  //
+  // Maps the contents of a file read-only into memory so that it can be
+  // parsed in place without copying it into user buffers. The mapping is
+  // released when the object is destroyed (not copyable).
+  class MappedFile {
+  public:
+    MappedFile()
+      : data_(0), size_(0)
+    { }
+
+    ~MappedFile() {
+      close();
+    }
+
+    ////////////////////////////////////////////////////////////////////////////
+    // Function: open
+    //
+    // Parameters:
+    //   fileName - The name of the file to be mapped
+    //
+    // Maps the given file into memory, returning true if the file was mapped
+    // and false otherwise. Any previously mapped file is released first.
+    bool open(const std::string& fileName);
+
+    ////////////////////////////////////////////////////////////////////////////
+    // Function: close
+    //
+    // Releases the mapping, if any.
+    void close();
+
+    ////////////////////////////////////////////////////////////////////////////
+    // Function: data
+    //
+    // Returns a pointer to the first byte of the file (0 if the file is empty)
+    const char* data() const { return data_; }
+
+    ////////////////////////////////////////////////////////////////////////////
+    // Function: size
+    //
+    // Returns the size of the mapped file in bytes
+    size_t size() const { return size_; }
+  private:
+    MappedFile(const MappedFile&);
+    MappedFile& operator = (const MappedFile&);
+
+    const char* data_; // The first byte of the mapping
+    size_t      size_; // The length of the mapping in bytes
+  };
+}
+
+#endif // MAPPED_FILE_HPP__
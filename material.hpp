@@ -13,8 +13,10 @@
 
 #include "base.hpp"
 #include "color.hpp"
+#include "fast_math.hpp"
 #include "hit.hpp"
 #include "ray.hpp"
+#include "vector_math.hpp"
 
 namespace Base {
   //////////////////////////////////////////////////////////////////////////////
@@ -40,7 +42,8 @@ namespace Base {
       : diffuse(diffuseColor),
         refraction(refractionColor),
         reflection(reflectionColor),
-        indexOfRefraction(indexOfRefraction)
+        indexOfRefraction(indexOfRefraction),
+        sceneIndex(kNoElement)
     { }
 
     virtual ~Material()
@@ -62,6 +65,19 @@ namespace Base {
                         const Vector3& dirToLight,
                         const Color& lightColor) const = 0;
 
+    ////////////////////////////////////////////////////////////////////////////
+    // Function: diffuseAt
+    //
+    // Parameters:
+    //   ray - The ray which hit this material
+    //   hit - The information about the hit
+    //
+    // Returns the diffuse color of this material at the point hit, which is
+    // the same everywhere unless the material is textured
+    virtual Color diffuseAt(const Ray& ray, const Hit& hit) const {
+      return diffuse;
+    }
+
     ////////////////////////////////////////////////////////////////////////////
     // Function: isTransparent
     //
@@ -74,8 +90,9 @@ namespace Base {
     // Indicates whether or not this material reflects light
     bool isReflective() { return (reflection > Color::Black); }
 
-    Color diffuse, refraction, reflection;
-    Real  indexOfRefraction;
+    Color  diffuse, refraction, reflection;
+    Real   indexOfRefraction;
+    size_t sceneIndex; // The index given by Scene::addMaterial, if added
   };
 
   //////////////////////////////////////////////////////////////////////////////
@@ -95,34 +112,52 @@ namespace Base {
                  reflectionColor,
                  indexOfRefraction),
         specular(specularColor),
-        shininess(fShininess)
+        shininess(fShininess),
+        specularTable_(fShininess)
     { }
 
     ////////////////////////////////////////////////////////////////////////////
     // Function: shade
     //
-    // Shades the material according to the Phong shading model.
+    // Shades the material according to the Phong shading model, at the
+    // precision selected with SetPrecision.
     Color shade(const Ray& ray,
                 const Hit& hit,
                 const Vector3& dirToLight,
                 const Color& lightColor) const {
+      ePrecision precision = GetPrecision();
+
       // Diffuse lighting as C_d * (L . N)
-      Vector3 l = dirToLight.normalize();
-      Vector3 n = hit.getNormal();
-      Color result = lightColor * diffuse * (l.dotProduct(n));
+      Vec4 l = Normalize(dirToLight, precision);
+      Vec4 n = hit.getNormal();
+      Vec4 light = lightColor;
+      Vec4 result = light * Vec4(diffuseAt(ray, hit)) * l.dot(n);
 
       // Specular lighting as C_s * (V . R)^(alpha)
-      if (specular > Color::Black) {
-	Vector3 v = -ray.direction;
-	Vector3 r = (l - (2 * l.dotProduct(n)) * n).normalize();
-	result += lightColor * specular * pow(v.dotProduct(r), shininess);
+      Color specularColor = specularAt(ray, hit);
+      if (specularColor > Color::Black) {
+	Vec4 v = -Vec4(ray.direction);
+	Vec4 r = Normalize(l.reflect(n), precision);
+	result += light * Vec4(specularColor) *
+	          SpecularPow(v.dot(r), shininess, specularTable_, precision);
       }
 
-      return result;
+      return result.toColor();
+    }
+
+    ////////////////////////////////////////////////////////////////////////////
+    // Function: specularAt
+    //
+    // Returns the specular color of this material at the point hit (see
+    // diffuseAt)
+    virtual Color specularAt(const Ray& ray, const Hit& hit) const {
+      return specular;
     }
 
     Color specular;
     Real  shininess;
+  private:
+    SpecularTable specularTable_; // Powers of cosines for the fast precision
   };
 }
 
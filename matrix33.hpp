@@ -10,6 +10,8 @@
 #ifndef MATRIX33_HPP__
 #define MATRIX33_HPP__
 
+#include "vector3.hpp"
+
 namespace Base {
   //////////////////////////////////////////////////////////////////////////////
   // Class: Matrix33
@@ -59,6 +61,19 @@ namespace Base {
         m[0][2] * (m[1][0] * m[2][1] - m[2][0] * m[1][1]);
     }
   };
+
+  //////////////////////////////////////////////////////////////////////////////
+  // Function: Determinant
+  //
+  // Returns the determinant of the 3x3 matrix with the given columns, with
+  // the same arithmetic as Matrix33::determinant
+  inline Real Determinant(const Vector3& c0,
+                          const Vector3& c1,
+                          const Vector3& c2) {
+    return c0.x * (c1.y * c2.z - c1.z * c2.y) -
+      c1.x * (c0.y * c2.z - c0.z * c2.y) +
+      c2.x * (c0.y * c1.z - c0.z * c1.y);
+  }
 }
 
 #endif // MATRIX33_HPP__
@@ -0,0 +1,291 @@
+////////////////////////////////////////////////////////////////////////////////
+// Base: A Simple Graphics Suite
+// Author: Eric Scrivner
+//
+// Time-stamp: <Last modified 2026-10-19 11:02:47 by Eric Scrivner>
+//
+// Description:
+//   Binary cache of the vertex and face data of a loaded OBJ model.
+//
+//   A cache file consists of a fixed-size header followed by three arrays:
+//   the vertices (three doubles each), the face indices and the face offsets
+//   (4 or 8 bytes each, as recorded in the header). Everything is stored in
+//   the byte order of the machine which wrote it.
+////////////////////////////////////////////////////////////////////////////////
+
+#include "mapped_file.hpp"
+#include "mesh_cache.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <stdint.h>
+#include <vector>
+
+#include <sys/stat.h>
+using namespace std;
+
+namespace {
+  //////////////////////////////////////////////////////////////////////////////
+  // Constants
+  const char     kCacheMagic[4] = { 'B', 'M', 'S', 'H' };
+  const uint32_t kCacheVersion  = 3;
+  const uint32_t kByteOrderMark = 0x01020304;
+  const size_t   kSampleSize    = 64 * 1024; // Bytes hashed at either end
+
+  //////////////////////////////////////////////////////////////////////////////
+  // Struct: CacheHeader
+  //
+  // The header at the start of every cache file. The source fields form the
+  // key identifying the version of the OBJ file the cache was built from.
+  struct CacheHeader {
+    char     magic[4];     // Always kCacheMagic
+    uint32_t version;      // Always kCacheVersion
+    uint32_t byteOrder;    // kByteOrderMark as written by the creator
+    uint32_t indexSize;    // Size of each stored index in bytes (4 or 8)
+    uint64_t sourceSize;   // Size of the OBJ file in bytes
+    int64_t  sourceMtime;  // Modification time of the OBJ file in ns
+    uint64_t sampleHash;   // Hash of the start and end of the OBJ file
+    uint64_t sourceHash;   // Hash of the whole contents of the OBJ file
+    uint64_t numVertices;  // Number of vertices stored
+    uint64_t numIndices;   // Number of face indices stored
+    uint64_t numFaces;     // Number of faces stored
+  };
+
+  //////////////////////////////////////////////////////////////////////////////
+  // Function: HashContents
+  //
+  // Returns a 64-bit hash of the given bytes. The FNV-1a step is applied to
+  // eight bytes at a time, so hashing a file costs a small fraction of
+  // parsing it.
+  uint64_t HashContents(const char* data, size_t size) {
+    const uint64_t kPrime = 1099511628211ULL;
+    uint64_t hash = 14695981039346656037ULL ^ size;
+
+    size_t i = 0;
+    for (; i + sizeof(uint64_t) <= size; i += sizeof(uint64_t)) {
+      uint64_t word;
+      memcpy(&word, data + i, sizeof(word));
+      hash = (hash ^ word) * kPrime;
+      hash ^= hash >> 29;
+    }
+    for (; i < size; i++) {
+      hash = (hash ^ static_cast<unsigned char>(data[i])) * kPrime;
+    }
+    return hash;
+  }
+
+  //////////////////////////////////////////////////////////////////////////////
+  // Function: SourceKey
+  //
+  // Fills in the source fields of the header from the given OBJ file. The
+  // key is the size and modification time of the file and a hash of its
+  // first and last kSampleSize bytes, which costs the same whatever the
+  // size of the file. The whole file is only read and hashed into
+  // sourceHash when hashContents is set.
+  bool SourceKey(const string& objFileName, CacheHeader& header,
+                 bool hashContents) {
+    struct stat info;
+    if (stat(objFileName.c_str(), &info) != 0) {
+      return false;
+    }
+
+    header.sourceSize = info.st_size;
+    header.sourceMtime = static_cast<int64_t>(info.st_mtim.tv_sec) *
+      1000000000 + info.st_mtim.tv_nsec;
+
+    // Read the start of the file and whatever of the end it did not cover
+    ifstream in(objFileName.c_str(), ios::in | ios::binary);
+    size_t size = info.st_size;
+    size_t headSize = std::min(size, kSampleSize);
+    size_t tailStart = std::max(headSize, size - std::min(size, kSampleSize));
+    vector<char> sample(headSize + (size - tailStart));
+    in.read(sample.data(), headSize);
+    in.seekg(tailStart);
+    in.read(sample.data() + headSize, size - tailStart);
+    if (!in) {
+      return false;
+    }
+    header.sampleHash = HashContents(sample.data(), sample.size());
+
+    header.sourceHash = 0;
+    if (hashContents) {
+      Base::MappedFile source;
+      if (!source.open(objFileName)) {
+	return false;
+      }
+      header.sourceHash = HashContents(source.data(), source.size());
+    }
+    return true;
+  }
+
+  //////////////////////////////////////////////////////////////////////////////
+  // Function: ReadIndices
+  //
+  // Widens count stored indices of the given size into the output list
+  template <typename T>
+  void ReadIndices(const char* data, size_t count, Base::IndexList& out) {
+    out.resize(count);
+    for (size_t i = 0; i < count; i++) {
+      T index;
+      memcpy(&index, data + i * sizeof(T), sizeof(T));
+      out[i] = index;
+    }
+  }
+
+  //////////////////////////////////////////////////////////////////////////////
+  // Function: WriteIndices
+  //
+  // Narrows the given indices to the stored type and writes them out in
+  // blocks.
+  template <typename T>
+  void WriteIndices(ofstream& out, const Base::IndexList& indices) {
+    const size_t kBlockSize = 4096;
+    T block[kBlockSize];
+
+    for (size_t i = 0; i < indices.size(); i += kBlockSize) {
+      size_t count = std::min(kBlockSize, indices.size() - i);
+      for (size_t j = 0; j < count; j++) {
+	block[j] = static_cast<T>(indices[i + j]);
+      }
+      out.write(reinterpret_cast<const char*>(block), count * sizeof(T));
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+string Base::MeshCacheName(const string& objFileName) {
+  return objFileName + ".bmesh";
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool Base::LoadMeshCache(const string& objFileName,
+                         VertexList& vertices,
+                         IndexList& indices,
+                         IndexList& faceStart,
+                         bool verify) {
+  // Compute the key of the current OBJ file
+  CacheHeader expected;
+  if (!SourceKey(objFileName, expected, verify)) {
+    return false;
+  }
+
+  // Attempt to map the cache
+  MappedFile cache;
+  if (!cache.open(MeshCacheName(objFileName)) ||
+      cache.size() < sizeof(CacheHeader)) {
+    return false;
+  }
+
+  CacheHeader header;
+  memcpy(&header, cache.data(), sizeof(header));
+
+  // Reject caches from other versions, machines or source files
+  if (memcmp(header.magic, kCacheMagic, sizeof(kCacheMagic)) != 0 ||
+      header.version != kCacheVersion ||
+      header.byteOrder != kByteOrderMark ||
+      (header.indexSize != 4 && header.indexSize != 8) ||
+      header.sourceSize != expected.sourceSize ||
+      header.sourceMtime != expected.sourceMtime ||
+      header.sampleHash != expected.sampleHash ||
+      (verify && header.sourceHash != expected.sourceHash)) {
+    return false;
+  }
+
+  // Ensure the arrays are all present
+  uint64_t vertexBytes = header.numVertices * 3 * sizeof(double);
+  uint64_t indexBytes = header.numIndices * header.indexSize;
+  uint64_t faceBytes = (header.numFaces + 1) * header.indexSize;
+  if (cache.size() != sizeof(header) + vertexBytes + indexBytes + faceBytes) {
+    return false;
+  }
+
+  // Copy the vertices out of the mapping. Model keeps its mesh in vectors,
+  // which cleanup, reordering and transforms change in place, so the mesh is
+  // deliberately copied out rather than used from the mapping; the copy is
+  // a single pass and the parse is still skipped.
+  const char* data = cache.data() + sizeof(header);
+  vertices.resize(header.numVertices);
+  for (size_t i = 0; i < vertices.size(); i++) {
+    double xyz[3];
+    memcpy(xyz, data + i * sizeof(xyz), sizeof(xyz));
+    vertices[i] = Vertex(xyz[0], xyz[1], xyz[2]);
+  }
+  data += vertexBytes;
+
+  // Followed by the indices and face offsets
+  if (header.indexSize == 4) {
+    ReadIndices<uint32_t>(data, header.numIndices, indices);
+    ReadIndices<uint32_t>(data + indexBytes, header.numFaces + 1, faceStart);
+  } else {
+    ReadIndices<uint64_t>(data, header.numIndices, indices);
+    ReadIndices<uint64_t>(data + indexBytes, header.numFaces + 1, faceStart);
+  }
+
+  // A damaged cache must not hand out indices outside the mesh
+  return ValidMesh(vertices.size(), indices, faceStart);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool Base::SaveMeshCache(const string& objFileName,
+                         const VertexList& vertices,
+                         const IndexList& indices,
+                         const IndexList& faceStart) {
+  assert(!faceStart.empty());
+
+  CacheHeader header;
+  memset(&header, 0, sizeof(header));
+  if (!SourceKey(objFileName, header, true)) {
+    return false;
+  }
+
+  // Use 32-bit indices whenever every index and offset fits in them
+  size_t largest = faceStart.back();
+  for (size_t i = 0; i < indices.size(); i++) {
+    largest = std::max(largest, indices[i]);
+  }
+
+  memcpy(header.magic, kCacheMagic, sizeof(kCacheMagic));
+  header.version = kCacheVersion;
+  header.byteOrder = kByteOrderMark;
+  header.indexSize = (largest <= 0xFFFFFFFFULL) ? 4 : 8;
+  header.numVertices = vertices.size();
+  header.numIndices = indices.size();
+  header.numFaces = faceStart.size() - 1;
+
+  // Write to a temporary file which is renamed over the cache when complete
+  string cacheName = MeshCacheName(objFileName);
+  string tempName = cacheName + ".tmp";
+  ofstream out(tempName.c_str(), ios::out | ios::binary | ios::trunc);
+  if (!out.is_open()) {
+    // Probably don't have write access to the model directory
+    return false;
+  }
+
+  out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+  for (size_t i = 0; i < vertices.size(); i++) {
+    double xyz[3] = { vertices[i].x, vertices[i].y, vertices[i].z };
+    out.write(reinterpret_cast<const char*>(xyz), sizeof(xyz));
+  }
+
+  if (header.indexSize == 4) {
+    WriteIndices<uint32_t>(out, indices);
+    WriteIndices<uint32_t>(out, faceStart);
+  } else {
+    WriteIndices<uint64_t>(out, indices);
+    WriteIndices<uint64_t>(out, faceStart);
+  }
+
+  out.close();
+  if (out.fail() || rename(tempName.c_str(), cacheName.c_str()) != 0) {
+    remove(tempName.c_str());
+    return false;
+  }
+
+  return true;
+}
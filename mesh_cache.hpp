@@ -0,0 +1,67 @@
+////////////////////////////////////////////////////////////////////////////////
+// Base: A Simple Graphics Suite
+// Author: Eric Scrivner
+//
+// Time-stamp: <Last modified 2026-10-19 11:02:47 by Eric Scrivner>
+//
+// Description:
+//   Binary cache of the vertex and face data of a loaded OBJ model.
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef MESH_CACHE_HPP__
+#define MESH_CACHE_HPP__
+
+#include "model.hpp"
+
+#include <string>
+
+namespace Base {
+  //////////////////////////////////////////////////////////////////////////////
+  // Function: MeshCacheName
+  //
+  // Returns the name of the cache file kept alongside the given OBJ file
+  std::string MeshCacheName(const std::string& objFileName);
+
+  //////////////////////////////////////////////////////////////////////////////
+  // Function: LoadMeshCache
+  //
+  // Parameters:
+  //   objFileName - The name of the OBJ file whose cache should be loaded
+  //   vertices - Receives the cached vertices
+  //   indices - Receives the cached face indices
+  //   faceStart - Receives the cached face offsets
+  //   verify - Whether to check the cache against the whole OBJ file
+  //
+  // Maps the cache file of the given OBJ file and copies the mesh out of it,
+  // returning true on success. The cache is rejected (and false returned) if
+  // it is missing, was written by a different cache version or machine
+  // layout, or holds a face index outside the mesh (see ValidMesh). It is
+  // also rejected if the size or modification time (to the nanosecond) of
+  // the OBJ file has changed, or the first or last 64 KB of its contents,
+  // so checking the cache does not read the whole OBJ file. With verify set
+  // the whole file is read and its hash compared as well, catching any edit
+  // which keeps the size and time of the file.
+  bool LoadMeshCache(const std::string& objFileName,
+                     VertexList& vertices,
+                     IndexList& indices,
+                     IndexList& faceStart,
+                     bool verify = false);
+
+  //////////////////////////////////////////////////////////////////////////////
+  // Function: SaveMeshCache
+  //
+  // Parameters:
+  //   objFileName - The name of the OBJ file the mesh was loaded from
+  //   vertices, indices, faceStart - The mesh to be cached
+  //
+  // Writes the cache file for the given OBJ file, returning true on success.
+  // The whole OBJ file is hashed for a later LoadMeshCache with verify set.
+  // The cache is written to a temporary file and renamed into place so that
+  // concurrent readers never see a partial cache.
+  bool SaveMeshCache(const std::string& objFileName,
+                     const VertexList& vertices,
+                     const IndexList& indices,
+                     const IndexList& faceStart);
+}
+
+#endif // MESH_CACHE_HPP__
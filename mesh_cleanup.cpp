@@ -0,0 +1,382 @@
+////////////////////////////////////////////////////////////////////////////////
+// Base: A Simple Graphics Suite
+// Author: Eric Scrivner
+//
+// Time-stamp: <Last modified 2026-10-19 11:40:05 by Eric Scrivner>
+//
+// Description:
+//   Preprocessing pass which turns a loaded model into a clean triangle mesh.
+////////////////////////////////////////////////////////////////////////////////
+
+#include "mesh_cleanup.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <ostream>
+#include <unordered_map>
+#include <unordered_set>
+#include <stdint.h>
+using namespace std;
+
+namespace {
+  //////////////////////////////////////////////////////////////////////////////
+  // Function: HashCombine
+  //
+  // Mixes value into the given hash
+  inline size_t HashCombine(size_t hash, uint64_t value) {
+    value *= 0x9E3779B97F4A7C15ULL;
+    value ^= value >> 32;
+    return hash ^ (value + 0x9E3779B9 + (hash << 6) + (hash >> 2));
+  }
+
+  //////////////////////////////////////////////////////////////////////////////
+  // Struct: Key3
+  //
+  // Three 64-bit values used as the key for both vertex positions and
+  // triangles.
+  struct Key3 {
+    uint64_t k[3];
+
+    bool operator == (const Key3& rhs) const {
+      return k[0] == rhs.k[0] && k[1] == rhs.k[1] && k[2] == rhs.k[2];
+    }
+  };
+
+  struct Key3Hash {
+    size_t operator () (const Key3& key) const {
+      return HashCombine(HashCombine(HashCombine(0, key.k[0]), key.k[1]),
+                         key.k[2]);
+    }
+  };
+
+  //////////////////////////////////////////////////////////////////////////////
+  // Function: PositionKey
+  //
+  // Returns the key under which a vertex is welded with no weld distance:
+  // the bit pattern of the coordinates, with -0 folded into +0
+  Key3 PositionKey(const Base::Vertex& v) {
+    Base::Real xyz[3] = { v.x + 0.0, v.y + 0.0, v.z + 0.0 };
+    Key3 key;
+    memcpy(key.k, xyz, sizeof(key.k));
+    return key;
+  }
+
+  //////////////////////////////////////////////////////////////////////////////
+  // Function: CellKey
+  //
+  // Returns the key of the grid cell of the given size containing a vertex,
+  // offset by the given number of cells along each axis
+  Key3 CellKey(const Base::Vertex& v, const Base::Real& cellSize,
+               const int* offset) {
+    Base::Real xyz[3] = { v.x, v.y, v.z };
+    Key3 key;
+    for (int i = 0; i < 3; i++) {
+      key.k[i] = static_cast<uint64_t>(
+        static_cast<int64_t>(floor(xyz[i] / cellSize)) + offset[i]);
+    }
+    return key;
+  }
+
+  //////////////////////////////////////////////////////////////////////////////
+  // Function: WeldVertices
+  //
+  // Maps each vertex of the model to the vertex it is welded to, counting the
+  // welded vertices. Each vertex is welded to the first earlier vertex left
+  // in place which is closer than weldDistance along every axis. Those
+  // vertices are kept in a grid of cells weldDistance wide, so only the cell
+  // of a vertex and its 26 neighbours need be searched.
+  void WeldVertices(const Base::Model& model, const Base::Real& weldDistance,
+                    Base::IndexList& weld, size_t& welded) {
+    weld.resize(model.numVertices());
+
+    // Only bit-identical positions are merged with no weld distance
+    if (weldDistance <= 0) {
+      unordered_map<Key3, size_t, Key3Hash> firstAt;
+      firstAt.reserve(model.numVertices());
+      for (size_t i = 0; i < model.numVertices(); i++) {
+	Key3 key = PositionKey(model.vertex(i));
+	weld[i] = firstAt.insert(make_pair(key, i)).first->second;
+	if (weld[i] != i) {
+	  welded++;
+	}
+      }
+      return;
+    }
+
+    typedef unordered_multimap<Key3, size_t, Key3Hash> GridT;
+    GridT grid;
+    grid.reserve(model.numVertices());
+    const int kHere[3] = { 0, 0, 0 };
+
+    for (size_t i = 0; i < model.numVertices(); i++) {
+      const Base::Vertex& v = model.vertex(i);
+      weld[i] = i;
+
+      for (int n = 0; n < 27; n++) {
+	int offset[3] = { n % 3 - 1, n / 3 % 3 - 1, n / 9 - 1 };
+	pair<GridT::iterator, GridT::iterator> cell =
+	  grid.equal_range(CellKey(v, weldDistance, offset));
+	for (GridT::iterator it = cell.first; it != cell.second; ++it) {
+	  const Base::Vertex& kept = model.vertex(it->second);
+	  if (fabs(kept.x - v.x) < weldDistance &&
+	      fabs(kept.y - v.y) < weldDistance &&
+	      fabs(kept.z - v.z) < weldDistance &&
+	      it->second < weld[i]) {
+	    weld[i] = it->second;
+	  }
+	}
+      }
+
+      if (weld[i] == i) {
+	grid.insert(make_pair(CellKey(v, weldDistance, kHere), i));
+      } else {
+	welded++;
+      }
+    }
+  }
+
+  //////////////////////////////////////////////////////////////////////////////
+  // Class: TriangleSink
+  //
+  // Receives the triangles produced by triangulation, dropping degenerate and
+  // duplicate ones and counting them.
+  class TriangleSink {
+  public:
+    TriangleSink(const Base::Model& model, const Base::Real& minArea,
+                 Base::IndexList& indices, Base::MeshCleanupStats& stats)
+      : model_(model), minArea_(minArea), indices_(indices), stats_(stats)
+    { }
+
+    void add(size_t a, size_t b, size_t c) {
+      // Triangles which reuse a vertex or have no area are degenerate
+      if (a == b || b == c || c == a) {
+	stats_.degenerateTriangles++;
+	return;
+      }
+
+      const Base::Vertex& va = model_.vertex(a);
+      Base::Vector3 n = (model_.vertex(b) - va).crossProduct(model_.vertex(c) - va);
+      if (0.5 * n.magnitude() <= minArea_) {
+	stats_.degenerateTriangles++;
+	return;
+      }
+
+      // Triangles over the same three vertices in the same winding are
+      // duplicates; the vertices are rotated to start with the smallest so
+      // that every rotation has the same key. Opposite windings are kept, as
+      // they are the two sides of a thin sheet.
+      Key3 key = { { a, b, c } };
+      if (b < a && b < c) {
+	key.k[0] = b; key.k[1] = c; key.k[2] = a;
+      } else if (c < a && c < b) {
+	key.k[0] = c; key.k[1] = a; key.k[2] = b;
+      }
+      if (!seen_.insert(key).second) {
+	stats_.duplicateTriangles++;
+	return;
+      }
+
+      indices_.push_back(a);
+      indices_.push_back(b);
+      indices_.push_back(c);
+    }
+  private:
+    const Base::Model&               model_;   // Source of the positions
+    Base::Real                       minArea_; // Degenerate area threshold
+    Base::IndexList&                 indices_; // The triangles kept
+    Base::MeshCleanupStats&          stats_;   // Counts of dropped triangles
+    unordered_set<Key3, Key3Hash>    seen_;    // The triangles kept so far
+  };
+
+  //////////////////////////////////////////////////////////////////////////////
+  // Function: Cross2
+  //
+  // Returns the z component of (b - a) x (c - a) in the projection plane
+  inline Base::Real Cross2(const Base::Real* a, const Base::Real* b,
+                           const Base::Real* c) {
+    return (b[0] - a[0]) * (c[1] - a[1]) - (b[1] - a[1]) * (c[0] - a[0]);
+  }
+
+  //////////////////////////////////////////////////////////////////////////////
+  // Function: EarClip
+  //
+  // Parameters:
+  //   model - Source of the vertex positions
+  //   polygon - The vertex indices of the polygon, in order
+  //   sink - Receives the triangles
+  //
+  // Splits a simple (possibly concave) planar polygon into triangles by
+  // repeatedly clipping ears in the plane of its dominant axis. Polygons which
+  // are not simple fall back to a fan for whatever remains.
+  void EarClip(const Base::Model& model, const vector<size_t>& polygon,
+               TriangleSink& sink) {
+    size_t n = polygon.size();
+
+    // Compute the polygon normal using Newell's method
+    Base::Vector3 normal(0, 0, 0);
+    for (size_t i = 0; i < n; i++) {
+      const Base::Vertex& cur = model.vertex(polygon[i]);
+      const Base::Vertex& next = model.vertex(polygon[(i + 1) % n]);
+      normal.x += (cur.y - next.y) * (cur.z + next.z);
+      normal.y += (cur.z - next.z) * (cur.x + next.x);
+      normal.z += (cur.x - next.x) * (cur.y + next.y);
+    }
+
+    // Project onto the plane perpendicular to the dominant axis, choosing the
+    // axis order so that the polygon winds counter-clockwise.
+    int u = 1, v = 2;
+    Base::Real dominant = normal.x;
+    if (fabs(normal.y) > fabs(dominant)) {
+      u = 2; v = 0; dominant = normal.y;
+    }
+    if (fabs(normal.z) > fabs(dominant)) {
+      u = 0; v = 1; dominant = normal.z;
+    }
+    if (dominant < 0) {
+      std::swap(u, v);
+    }
+
+    vector<Base::Real> points(2 * n);
+    for (size_t i = 0; i < n; i++) {
+      const Base::Vertex& p = model.vertex(polygon[i]);
+      Base::Real xyz[3] = { p.x, p.y, p.z };
+      points[2 * i + 0] = xyz[u];
+      points[2 * i + 1] = xyz[v];
+    }
+
+    // Clip ears until a single triangle remains
+    vector<size_t> remaining(n);
+    for (size_t i = 0; i < n; i++) {
+      remaining[i] = i;
+    }
+
+    size_t misses = 0;
+    size_t i = 0;
+    while (remaining.size() > 3 && misses < remaining.size()) {
+      size_t count = remaining.size();
+      size_t prev = remaining[(i + count - 1) % count];
+      size_t cur = remaining[i % count];
+      size_t next = remaining[(i + 1) % count];
+      const Base::Real* a = &points[2 * prev];
+      const Base::Real* b = &points[2 * cur];
+      const Base::Real* c = &points[2 * next];
+
+      // An ear is a convex corner containing no other remaining vertex
+      bool isEar = Cross2(a, b, c) > 0;
+      for (size_t j = 0; isEar && j < count; j++) {
+	size_t k = remaining[j];
+	if (k == prev || k == cur || k == next) {
+	  continue;
+	}
+	const Base::Real* p = &points[2 * k];
+	if (Cross2(a, b, p) >= 0 && Cross2(b, c, p) >= 0 && Cross2(c, a, p) >= 0) {
+	  isEar = false;
+	}
+      }
+
+      if (isEar) {
+	sink.add(polygon[prev], polygon[cur], polygon[next]);
+	remaining.erase(remaining.begin() + (i % count));
+	misses = 0;
+      } else {
+	i++;
+	misses++;
+      }
+      i %= remaining.size();
+    }
+
+    // Fan whatever is left (a single triangle unless the polygon is not simple)
+    for (size_t j = 1; j + 1 < remaining.size(); j++) {
+      sink.add(polygon[remaining[0]], polygon[remaining[j]],
+               polygon[remaining[j + 1]]);
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+Base::MeshCleanupStats Base::CleanupMesh(Model& model,
+                                         const MeshCleanupOptions& options) {
+  MeshCleanupStats stats;
+  stats.inputVertices = model.numVertices();
+  stats.inputFaces = model.numFaces();
+
+  // Weld vertices, mapping each vertex to the one it is merged into
+  IndexList weld;
+  WeldVertices(model, options.weldDistance, weld, stats.weldedVertices);
+
+  // Triangulate each face exactly once
+  IndexList triangles;
+  triangles.reserve(model.numFaces() * 3);
+  TriangleSink sink(model, options.minArea, triangles, stats);
+  vector<size_t> polygon;
+
+  for (size_t f = 0; f < model.numFaces(); f++) {
+    const size_t* face = model.faceIndices(f);
+    size_t size = model.faceSize(f);
+
+    // Weld the face, dropping repeated consecutive vertices
+    polygon.clear();
+    for (size_t i = 0; i < size; i++) {
+      size_t index = weld[face[i]];
+      if (polygon.empty() || polygon.back() != index) {
+	polygon.push_back(index);
+      }
+    }
+    while (polygon.size() > 1 && polygon.back() == polygon.front()) {
+      polygon.pop_back();
+    }
+
+    if (polygon.size() < 3) {
+      stats.degenerateTriangles++;
+    } else if (polygon.size() == 3) {
+      sink.add(polygon[0], polygon[1], polygon[2]);
+    } else {
+      stats.polygonsSplit++;
+      EarClip(model, polygon, sink);
+    }
+  }
+
+  // Compact the vertices in order of first use
+  const size_t kUnused = static_cast<size_t>(-1);
+  IndexList compact(model.numVertices(), kUnused);
+  VertexList vertices;
+
+  for (size_t i = 0; i < triangles.size(); i++) {
+    size_t& index = triangles[i];
+    if (compact[index] == kUnused) {
+      compact[index] = vertices.size();
+      vertices.push_back(model.vertex(index));
+    }
+    index = compact[index];
+  }
+
+  IndexList faceStart(triangles.size() / 3 + 1);
+  for (size_t i = 0; i < faceStart.size(); i++) {
+    faceStart[i] = 3 * i;
+  }
+
+  stats.outputVertices = vertices.size();
+  stats.unusedVertices = stats.inputVertices - stats.weldedVertices -
+    stats.outputVertices;
+  stats.outputTriangles = triangles.size() / 3;
+
+  model.setMesh(vertices, triangles, faceStart);
+  return stats;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+std::ostream& Base::operator << (std::ostream& out,
+                                 const MeshCleanupStats& stats) {
+  return out << stats.inputVertices << " vertices, "
+             << stats.inputFaces << " faces -> "
+             << stats.outputVertices << " vertices, "
+             << stats.outputTriangles << " triangles ("
+             << stats.weldedVertices << " welded, "
+             << stats.unusedVertices << " unused, "
+             << stats.polygonsSplit << " polygons split, "
+             << stats.degenerateTriangles << " degenerate, "
+             << stats.duplicateTriangles << " duplicate)";
+}
@@ -0,0 +1,80 @@
+////////////////////////////////////////////////////////////////////////////////
+// Base: A Simple Graphics Suite
+// Author: Eric Scrivner
+//
+// Time-stamp: <Last modified 2026-10-19 11:40:05 by Eric Scrivner>
+//
+// Description:
+//   Preprocessing pass which turns a loaded model into a clean triangle mesh.
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef MESH_CLEANUP_HPP__
+#define MESH_CLEANUP_HPP__
+
+#include "model.hpp"
+
+#include <iosfwd>
+
+namespace Base {
+  //////////////////////////////////////////////////////////////////////////////
+  // Struct: MeshCleanupOptions
+  //
+  // Controls the cleanup performed by CleanupMesh.
+  struct MeshCleanupOptions {
+    Real weldDistance; // A vertex closer than this along every axis to an
+                       // earlier unmerged vertex is merged into it; zero
+                       // merges only bit-identical positions
+    Real minArea;      // Triangles with this area or less are degenerate
+
+    MeshCleanupOptions()
+      : weldDistance(0), minArea(0)
+    { }
+  };
+
+  //////////////////////////////////////////////////////////////////////////////
+  // Struct: MeshCleanupStats
+  //
+  // Counts of the work done by CleanupMesh.
+  struct MeshCleanupStats {
+    size_t inputVertices;       // Vertices before cleanup
+    size_t weldedVertices;      // Vertices merged into another vertex
+    size_t unusedVertices;      // Vertices referenced by no face
+    size_t outputVertices;      // Vertices after cleanup
+    size_t inputFaces;          // Faces before cleanup
+    size_t polygonsSplit;       // Faces with more than three vertices
+    size_t degenerateTriangles; // Triangles dropped as degenerate
+    size_t duplicateTriangles;  // Triangles dropped as duplicates
+    size_t outputTriangles;     // Triangles after cleanup
+
+    MeshCleanupStats()
+      : inputVertices(0), weldedVertices(0), unusedVertices(0),
+        outputVertices(0), inputFaces(0), polygonsSplit(0),
+        degenerateTriangles(0), duplicateTriangles(0), outputTriangles(0)
+    { }
+  };
+
+  //////////////////////////////////////////////////////////////////////////////
+  // Function: CleanupMesh
+  //
+  // Parameters:
+  //   model - The model to be cleaned up
+  //   options - Tolerances used by the cleanup
+  //
+  // Converts the model into a clean triangle mesh, returning counts of what
+  // was changed. Duplicate vertices are welded, every polygon is split into
+  // triangles exactly once (by ear clipping, so concave polygons are handled),
+  // degenerate triangles and repeats of a triangle in the same winding are
+  // dropped and unreferenced vertices are removed. Should be run after
+  // Model::load and before the model is converted into primitives.
+  MeshCleanupStats CleanupMesh(Model& model,
+                               const MeshCleanupOptions& options =
+                               MeshCleanupOptions());
+
+  //////////////////////////////////////////////////////////////////////////////
+  // Function: operator <<
+  //
+  // Writes a one line summary of the given statistics to a stream
+  std::ostream& operator << (std::ostream& out, const MeshCleanupStats& stats);
+}
+
+#endif // MESH_CLEANUP_HPP__
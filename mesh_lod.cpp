@@ -0,0 +1,544 @@
+////////////////////////////////////////////////////////////////////////////////
+// Base: A Simple Graphics Suite
+// Author: Eric Scrivner
+//
+// Time-stamp: <Last modified 2026-10-19 12:31:18 by Eric Scrivner>
+//
+// Description:
+//   Quadric error mesh simplification and level-of-detail chains.
+////////////////////////////////////////////////////////////////////////////////
+
+#include "mesh_lod.hpp"
+#include "compressed_mesh.hpp"
+#include "matrix33.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <functional>
+#include <queue>
+using namespace std;
+
+namespace {
+  //////////////////////////////////////////////////////////////////////////////
+  // Constants
+  const Base::Real kBoundaryWeight = 1000; // Weight of boundary constraints
+
+  //////////////////////////////////////////////////////////////////////////////
+  // Class: Quadric
+  //
+  // A symmetric 4x4 matrix Q measuring the summed squared distance v^T Q v of
+  // a point v to a set of planes. Only the upper triangle is stored.
+  class Quadric {
+  public:
+    Quadric() {
+      fill(q_, q_ + 10, 0.0);
+    }
+
+    ////////////////////////////////////////////////////////////////////////////
+    // Function: addPlane
+    //
+    // Adds the plane ax + by + cz + d = 0, scaled by the given weight
+    void addPlane(Base::Real a, Base::Real b, Base::Real c, Base::Real d,
+                  Base::Real weight) {
+      q_[0] += weight * a * a; q_[1] += weight * a * b;
+      q_[2] += weight * a * c; q_[3] += weight * a * d;
+      q_[4] += weight * b * b; q_[5] += weight * b * c;
+      q_[6] += weight * b * d; q_[7] += weight * c * c;
+      q_[8] += weight * c * d; q_[9] += weight * d * d;
+    }
+
+    Quadric& operator += (const Quadric& rhs) {
+      for (int i = 0; i < 10; i++) {
+	q_[i] += rhs.q_[i];
+      }
+      return *this;
+    }
+
+    Quadric operator + (const Quadric& rhs) const {
+      Quadric result(*this);
+      result += rhs;
+      return result;
+    }
+
+    ////////////////////////////////////////////////////////////////////////////
+    // Function: error
+    //
+    // Returns v^T Q v for the point v
+    Base::Real error(const Base::Vector3& v) const {
+      return q_[0] * v.x * v.x + 2 * q_[1] * v.x * v.y + 2 * q_[2] * v.x * v.z +
+        2 * q_[3] * v.x + q_[4] * v.y * v.y + 2 * q_[5] * v.y * v.z +
+        2 * q_[6] * v.y + q_[7] * v.z * v.z + 2 * q_[8] * v.z + q_[9];
+    }
+
+    ////////////////////////////////////////////////////////////////////////////
+    // Function: minimum
+    //
+    // Finds the point minimizing the error, returning false if the quadric is
+    // (nearly) singular and no unique minimum exists.
+    bool minimum(Base::Vector3& result) const {
+      Base::Matrix33 A(q_[0], q_[1], q_[2],
+                       q_[1], q_[4], q_[5],
+                       q_[2], q_[5], q_[7]);
+      Base::Real det = A.determinant();
+      Base::Real scale = q_[0] + q_[4] + q_[7];
+      if (fabs(det) <= 1e-12 * scale * scale * scale) {
+	return false;
+      }
+
+      // Solve A v = -b by Cramer's rule
+      Base::Real bx = -q_[3], by = -q_[6], bz = -q_[8];
+      Base::Matrix33 X(bx, q_[1], q_[2], by, q_[4], q_[5], bz, q_[5], q_[7]);
+      Base::Matrix33 Y(q_[0], bx, q_[2], q_[1], by, q_[5], q_[2], bz, q_[7]);
+      Base::Matrix33 Z(q_[0], q_[1], bx, q_[1], q_[4], by, q_[2], q_[5], bz);
+      result = Base::Vector3(X.determinant() / det,
+                             Y.determinant() / det,
+                             Z.determinant() / det);
+      return true;
+    }
+  private:
+    Base::Real q_[10]; // Upper triangle of Q in row-major order
+  };
+
+  //////////////////////////////////////////////////////////////////////////////
+  // Struct: Collapse
+  //
+  // A candidate edge collapse. The versions of both vertices are recorded so
+  // that candidates made stale by later collapses can be recognized.
+  struct Collapse {
+    Base::Real    cost;     // The quadric error of the collapse
+    size_t        a, b;     // The edge; b is merged into a
+    size_t        versionA; // The version of a when the cost was computed
+    size_t        versionB; // The version of b when the cost was computed
+    Base::Vector3 target;   // The position of the merged vertex
+
+    bool operator > (const Collapse& rhs) const {
+      return cost > rhs.cost;
+    }
+  };
+
+  //////////////////////////////////////////////////////////////////////////////
+  // Class: Simplifier
+  //
+  // The working state of a single SimplifyMesh call.
+  class Simplifier {
+  public:
+    Simplifier(const Base::Model& model);
+
+    ////////////////////////////////////////////////////////////////////////////
+    // Function: run
+    //
+    // Collapses edges until at most target triangles remain (or no collapse
+    // is possible) and returns the result.
+    Base::Model run(const size_t& target);
+  private:
+    void _pushCollapse(size_t a, size_t b);
+    bool _adjacent(size_t a, size_t b) const;
+    bool _flips(size_t moved, size_t other, const Base::Vector3& target) const;
+    void _collapse(const Collapse& c);
+
+    Base::VertexList           positions_; // Current vertex positions
+    vector<Quadric>            quadrics_;  // Accumulated vertex quadrics
+    vector<size_t>             versions_;  // Bumped whenever a vertex changes
+    vector<bool>               removed_;   // Vertices merged away
+    Base::IndexList            triangles_; // Three vertex indices per face
+    vector<bool>               dead_;      // Faces collapsed away
+    vector< vector<size_t> >   faces_;     // Faces around each vertex
+    size_t                     live_;      // Number of faces not dead
+    priority_queue<Collapse, vector<Collapse>, greater<Collapse> > heap_;
+  };
+
+  //////////////////////////////////////////////////////////////////////////////
+
+  Simplifier::Simplifier(const Base::Model& model)
+    : quadrics_(model.numVertices()),
+      versions_(model.numVertices(), 0),
+      removed_(model.numVertices(), false),
+      faces_(model.numVertices()),
+      live_(0) {
+    positions_.reserve(model.numVertices());
+    for (size_t i = 0; i < model.numVertices(); i++) {
+      positions_.push_back(model.vertex(i));
+    }
+
+    // Gather the triangles, splitting larger faces into fans, and the faces
+    // around each vertex
+    for (size_t f = 0; f < model.numFaces(); f++) {
+      const size_t* face = model.faceIndices(f);
+      for (size_t j = 2; j < model.faceSize(f); j++) {
+	size_t triangle[3] = { face[0], face[j - 1], face[j] };
+	for (int k = 0; k < 3; k++) {
+	  faces_[triangle[k]].push_back(live_);
+	  triangles_.push_back(triangle[k]);
+	}
+	live_++;
+      }
+    }
+    dead_.assign(live_, false);
+
+    // Each vertex starts with the (area weighted) planes of its faces
+    vector< pair<size_t, size_t> > edges;
+    vector<Base::Vector3> normals(live_);
+    for (size_t f = 0; f < live_; f++) {
+      const size_t* t = &triangles_[3 * f];
+      Base::Vector3 n = (positions_[t[1]] - positions_[t[0]]).crossProduct(
+        positions_[t[2]] - positions_[t[0]]);
+      Base::Real area = 0.5 * n.magnitude();
+      n = n.normalize();
+      normals[f] = n;
+
+      Base::Real d = -n.dotProduct(positions_[t[0]]);
+      for (int k = 0; k < 3; k++) {
+	quadrics_[t[k]].addPlane(n.x, n.y, n.z, d, area);
+	size_t a = t[k], b = t[(k + 1) % 3];
+	edges.push_back(make_pair(min(a, b), max(a, b)));
+      }
+    }
+
+    // Edges with a single face are on the boundary; constrain them to move
+    // only within the plane through the edge perpendicular to the face.
+    sort(edges.begin(), edges.end());
+    for (size_t f = 0; f < live_; f++) {
+      const size_t* t = &triangles_[3 * f];
+      for (int k = 0; k < 3; k++) {
+	size_t a = t[k], b = t[(k + 1) % 3];
+	pair<size_t, size_t> e(min(a, b), max(a, b));
+	size_t count = upper_bound(edges.begin(), edges.end(), e) -
+	  lower_bound(edges.begin(), edges.end(), e);
+	if (count == 1) {
+	  Base::Vector3 along = positions_[b] - positions_[a];
+	  Base::Vector3 n = along.crossProduct(normals[f]).normalize();
+	  Base::Real d = -n.dotProduct(positions_[a]);
+	  Base::Real weight = kBoundaryWeight * along.dotProduct(along);
+	  quadrics_[a].addPlane(n.x, n.y, n.z, d, weight);
+	  quadrics_[b].addPlane(n.x, n.y, n.z, d, weight);
+	}
+      }
+    }
+
+    // Seed the heap with every edge
+    edges.erase(unique(edges.begin(), edges.end()), edges.end());
+    for (size_t i = 0; i < edges.size(); i++) {
+      _pushCollapse(edges[i].first, edges[i].second);
+    }
+  }
+
+  //////////////////////////////////////////////////////////////////////////////
+
+  void Simplifier::_pushCollapse(size_t a, size_t b) {
+    Quadric q = quadrics_[a] + quadrics_[b];
+    Collapse c;
+    c.a = a;
+    c.b = b;
+    c.versionA = versions_[a];
+    c.versionB = versions_[b];
+
+    // Use the optimal point if there is one, otherwise the best of the
+    // endpoints and the midpoint.
+    if (q.minimum(c.target)) {
+      c.cost = q.error(c.target);
+    } else {
+      Base::Vector3 candidates[3] = {
+	positions_[a], positions_[b], 0.5 * (positions_[a] + positions_[b])
+      };
+      c.target = candidates[0];
+      c.cost = q.error(candidates[0]);
+      for (int i = 1; i < 3; i++) {
+	Base::Real cost = q.error(candidates[i]);
+	if (cost < c.cost) {
+	  c.cost = cost;
+	  c.target = candidates[i];
+	}
+      }
+    }
+
+    heap_.push(c);
+  }
+
+  //////////////////////////////////////////////////////////////////////////////
+
+  bool Simplifier::_adjacent(size_t a, size_t b) const {
+    const vector<size_t>& around = faces_[a];
+    for (size_t i = 0; i < around.size(); i++) {
+      const size_t* t = &triangles_[3 * around[i]];
+      if (!dead_[around[i]] && (t[0] == b || t[1] == b || t[2] == b)) {
+	return true;
+      }
+    }
+    return false;
+  }
+
+  //////////////////////////////////////////////////////////////////////////////
+
+  bool Simplifier::_flips(size_t moved, size_t other,
+                          const Base::Vector3& target) const {
+    const vector<size_t>& around = faces_[moved];
+    for (size_t i = 0; i < around.size(); i++) {
+      size_t f = around[i];
+      const size_t* t = &triangles_[3 * f];
+
+      // Faces on the collapsing edge disappear and cannot flip
+      if (dead_[f] || t[0] == other || t[1] == other || t[2] == other) {
+	continue;
+      }
+
+      Base::Vector3 p[3], q[3];
+      for (int k = 0; k < 3; k++) {
+	p[k] = positions_[t[k]];
+	q[k] = (t[k] == moved) ? target : p[k];
+      }
+
+      Base::Vector3 before = (p[1] - p[0]).crossProduct(p[2] - p[0]);
+      Base::Vector3 after = (q[1] - q[0]).crossProduct(q[2] - q[0]);
+      if (before.dotProduct(after) <= 0) {
+	return true;
+      }
+    }
+    return false;
+  }
+
+  //////////////////////////////////////////////////////////////////////////////
+
+  void Simplifier::_collapse(const Collapse& c) {
+    size_t a = c.a, b = c.b;
+
+    positions_[a] = c.target;
+    quadrics_[a] += quadrics_[b];
+    removed_[b] = true;
+    versions_[a]++;
+    versions_[b]++;
+
+    // Faces on the edge die; the rest of b's faces now use a
+    for (size_t i = 0; i < faces_[b].size(); i++) {
+      size_t f = faces_[b][i];
+      if (dead_[f]) {
+	continue;
+      }
+
+      size_t* t = &triangles_[3 * f];
+      if (t[0] == a || t[1] == a || t[2] == a) {
+	dead_[f] = true;
+	live_--;
+      } else {
+	for (int k = 0; k < 3; k++) {
+	  if (t[k] == b) {
+	    t[k] = a;
+	  }
+	}
+	faces_[a].push_back(f);
+      }
+    }
+    vector<size_t>().swap(faces_[b]);
+
+    // Drop dead faces from a's list and requeue the edges around a
+    vector<size_t>& around = faces_[a];
+    size_t kept = 0;
+    vector<size_t> neighbors;
+    for (size_t i = 0; i < around.size(); i++) {
+      if (dead_[around[i]]) {
+	continue;
+      }
+      around[kept++] = around[i];
+      const size_t* t = &triangles_[3 * around[i]];
+      for (int k = 0; k < 3; k++) {
+	if (t[k] != a) {
+	  neighbors.push_back(t[k]);
+	}
+      }
+    }
+    around.resize(kept);
+
+    sort(neighbors.begin(), neighbors.end());
+    neighbors.erase(unique(neighbors.begin(), neighbors.end()), neighbors.end());
+    for (size_t i = 0; i < neighbors.size(); i++) {
+      _pushCollapse(a, neighbors[i]);
+    }
+  }
+
+  //////////////////////////////////////////////////////////////////////////////
+
+  Base::Model Simplifier::run(const size_t& target) {
+    while (live_ > target && !heap_.empty()) {
+      Collapse c = heap_.top();
+      heap_.pop();
+
+      // Skip candidates made stale by earlier collapses
+      if (removed_[c.a] || removed_[c.b] ||
+          versions_[c.a] != c.versionA || versions_[c.b] != c.versionB ||
+          !_adjacent(c.a, c.b)) {
+	continue;
+      }
+
+      // Skip collapses which would fold the surface over
+      if (_flips(c.a, c.b, c.target) || _flips(c.b, c.a, c.target)) {
+	continue;
+      }
+
+      _collapse(c);
+    }
+
+    // Gather the surviving faces and the vertices they use
+    const size_t kUnused = static_cast<size_t>(-1);
+    vector<size_t> remap(positions_.size(), kUnused);
+    Base::VertexList vertices;
+    Base::IndexList indices;
+    for (size_t f = 0; f < dead_.size(); f++) {
+      if (dead_[f]) {
+	continue;
+      }
+      for (int k = 0; k < 3; k++) {
+	size_t v = triangles_[3 * f + k];
+	if (remap[v] == kUnused) {
+	  remap[v] = vertices.size();
+	  vertices.push_back(positions_[v]);
+	}
+	indices.push_back(remap[v]);
+      }
+    }
+
+    Base::IndexList faceStart(indices.size() / 3 + 1);
+    for (size_t i = 0; i < faceStart.size(); i++) {
+      faceStart[i] = 3 * i;
+    }
+
+    Base::Model result;
+    result.setMesh(vertices, indices, faceStart);
+    return result;
+  }
+
+  //////////////////////////////////////////////////////////////////////////////
+  // Function: MeanEdgeLength
+  //
+  // Returns the mean length of the triangle edges of a model
+  Base::Real MeanEdgeLength(const Base::Model& model) {
+    Base::Real total = 0;
+    size_t count = 0;
+    for (size_t f = 0; f < model.numFaces(); f++) {
+      const size_t* face = model.faceIndices(f);
+      size_t size = model.faceSize(f);
+      for (size_t k = 0; k < size; k++) {
+	total += (model.vertex(face[(k + 1) % size]) -
+	          model.vertex(face[k])).magnitude();
+	count++;
+      }
+    }
+    return (count > 0) ? total / count : 0;
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+Base::Model Base::SimplifyMesh(const Model& model,
+                               const size_t& targetTriangles) {
+  Simplifier simplifier(model);
+  return simplifier.run(targetTriangles);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// LodChain
+
+Base::LodChain::LodChain(const Model& model,
+                         const size_t& maxLevels,
+                         const size_t& minTriangles)
+  : center_(0, 0, 0), radius_(0) {
+  // Find the bounding sphere about the centroid of the vertices
+  for (size_t i = 0; i < model.numVertices(); i++) {
+    center_ += model.vertex(i);
+  }
+  if (model.numVertices() > 0) {
+    center_ = center_ / model.numVertices();
+  }
+  for (size_t i = 0; i < model.numVertices(); i++) {
+    radius_ = max(radius_, (model.vertex(i) - center_).magnitude());
+  }
+
+  // Simplify each level from the one before it
+  levels_.push_back(model);
+  edgeLengths_.push_back(MeanEdgeLength(model));
+
+  while (levels_.size() < maxLevels) {
+    size_t current = levels_.back().numFaces();
+    size_t target = current / 4;
+    if (target < minTriangles) {
+      break;
+    }
+
+    Model next = SimplifyMesh(levels_.back(), target);
+    if (next.numFaces() >= current) {
+      // Nothing more could be collapsed
+      break;
+    }
+
+    edgeLengths_.push_back(MeanEdgeLength(next));
+    levels_.push_back(next);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+size_t Base::LodChain::selectByFootprint(const Real& footprint) const {
+  size_t best = 0;
+  for (size_t i = 1; i < edgeLengths_.size(); i++) {
+    if (edgeLengths_[i] <= footprint) {
+      best = i;
+    }
+  }
+  return best;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+size_t Base::LodChain::selectByScreenSize(const Real& pixels) const {
+  if (pixels <= 0) {
+    return edgeLengths_.size() - 1;
+  }
+  return selectByFootprint(2 * radius_ / pixels);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// LodMesh
+
+Base::LodMesh::LodMesh(const Model& model,
+                       Material* mat,
+                       const size_t& maxLevels,
+                       const size_t& minTriangles)
+  : Primitive(mat), chain_(model, maxLevels, minTriangles) {
+  for (size_t i = 0; i < chain_.numLevels(); i++) {
+    meshes_.push_back(new CompressedMesh(chain_.level(i), mat, eQuantize21));
+  }
+  chain_.releaseMeshes();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+Base::LodMesh::~LodMesh() {
+  for (size_t i = 0; i < meshes_.size(); i++) {
+    delete meshes_[i];
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool Base::LodMesh::intersection(const Ray& ray, Hit& hit, Real tmin) {
+  // Find where the ray enters the bounding sphere, if it does so before the
+  // closest hit so far
+  Vector3 offset = ray.origin - chain_.center();
+  Real a = ray.direction.dotProduct(ray.direction);
+  Real b = offset.dotProduct(ray.direction);
+  Real c = offset.dotProduct(offset) - chain_.radius() * chain_.radius();
+  Real discriminant = b * b - a * c;
+  if (discriminant < 0 || a == 0) {
+    return false;
+  }
+
+  Real root = sqrt(discriminant);
+  Real enter = (-b - root) / a;
+  Real leave = (-b + root) / a;
+  if (leave < tmin || enter > hit.getDistance()) {
+    return false;
+  }
+
+  Real footprint = ray.widthAtTime(max(enter, static_cast<Real>(0)));
+  size_t level = chain_.selectByFootprint(footprint);
+  return meshes_[level]->intersection(ray, hit, max(tmin, ray.width));
+}
@@ -0,0 +1,207 @@
+////////////////////////////////////////////////////////////////////////////////
+// Base: A Simple Graphics Suite
+// Author: Eric Scrivner
+//
+// Time-stamp: <Last modified 2026-10-19 12:31:18 by Eric Scrivner>
+//
+// Description:
+//   Quadric error mesh simplification and level-of-detail chains.
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef MESH_LOD_HPP__
+#define MESH_LOD_HPP__
+
+#include "model.hpp"
+#include "primitive.hpp"
+
+#include <vector>
+
+namespace Base {
+  //////////////////////////////////////////////////////////////////////////////
+  // Forward definitions
+  class CompressedMesh;
+  class Group;
+  class Material;
+
+  //////////////////////////////////////////////////////////////////////////////
+  // Function: SimplifyMesh
+  //
+  // Parameters:
+  //   model - A mesh (see CleanupMesh). Faces with more than three vertices
+  //           are split into a fan of triangles as by Model::toPrimitive.
+  //   targetTriangles - The number of triangles to reduce the mesh to
+  //
+  // Returns a simplified copy of the given mesh using Garland and Heckbert's
+  // quadric error metric. Edges are collapsed cheapest first, into the point
+  // minimizing the summed squared distance to the planes of the original
+  // faces around them. Open boundaries are weighted so they keep their shape,
+  // and collapses which would flip a face are skipped, so the result may keep
+  // more triangles than asked for.
+  Model SimplifyMesh(const Model& model, const size_t& targetTriangles);
+
+  //////////////////////////////////////////////////////////////////////////////
+  // Class: LodChain
+  //
+  // A chain of successively simplified versions of a model. Level 0 is the
+  // original mesh and each following level has about a quarter of the
+  // triangles of the one before it. A level is chosen from the size of a
+  // pixel (or ray footprint) at the model, picking the coarsest level whose
+  // triangles are still no larger than the footprint.
+  class LodChain {
+  public:
+    ////////////////////////////////////////////////////////////////////////////
+    // Function: LodChain
+    //
+    // Parameters:
+    //   model - The full detail triangle mesh
+    //   maxLevels - The maximum number of levels, including the original
+    //   minTriangles - No level is simplified below this many triangles
+    //
+    // Builds the chain of simplified meshes.
+    LodChain(const Model& model,
+             const size_t& maxLevels = 8,
+             const size_t& minTriangles = 64);
+
+    ////////////////////////////////////////////////////////////////////////////
+    // Function: numLevels
+    //
+    // Returns the number of levels in the chain
+    size_t numLevels() const { return edgeLengths_.size(); }
+
+    ////////////////////////////////////////////////////////////////////////////
+    // Function: level
+    //
+    // Returns the mesh at the given level (0 is the most detailed). The
+    // meshes are gone once releaseMeshes has been called.
+    const Model& level(const size_t& index) const {
+      assert(index < levels_.size());
+      return levels_[index];
+    }
+
+    ////////////////////////////////////////////////////////////////////////////
+    // Function: edgeLength
+    //
+    // Returns the mean edge length of the mesh at the given level
+    Real edgeLength(const size_t& index) const {
+      assert(index < edgeLengths_.size());
+      return edgeLengths_[index];
+    }
+
+    ////////////////////////////////////////////////////////////////////////////
+    // Function: radius
+    //
+    // Returns the radius of the bounding sphere of the model
+    Real radius() const { return radius_; }
+
+    ////////////////////////////////////////////////////////////////////////////
+    // Function: center
+    //
+    // Returns the center of the bounding sphere of the model
+    const Vector3& center() const { return center_; }
+
+    ////////////////////////////////////////////////////////////////////////////
+    // Function: selectByFootprint
+    //
+    // Parameters:
+    //   footprint - The world-space width of a pixel or ray at the model
+    //
+    // Returns the coarsest level whose mean edge length does not exceed the
+    // footprint. Secondary rays, whose footprints widen with distance and
+    // surface curvature, can use much coarser levels than camera rays.
+    size_t selectByFootprint(const Real& footprint) const;
+
+    ////////////////////////////////////////////////////////////////////////////
+    // Function: selectByScreenSize
+    //
+    // Parameters:
+    //   pixels - The projected diameter of the model's bounding sphere in
+    //            pixels
+    //
+    // Returns the level to be used when the model covers the given number of
+    // pixels across.
+    size_t selectByScreenSize(const Real& pixels) const;
+
+    ////////////////////////////////////////////////////////////////////////////
+    // Function: toPrimitive
+    //
+    // Converts the given level into a primitive group
+    Group* toPrimitive(const size_t& index, Material* material) {
+      assert(index < levels_.size());
+      return levels_[index].toPrimitive(material);
+    }
+
+    ////////////////////////////////////////////////////////////////////////////
+    // Function: releaseMeshes
+    //
+    // Frees the meshes of the levels once they have been converted, keeping
+    // what is needed to select a level
+    void releaseMeshes() { std::vector<Model>().swap(levels_); }
+  private:
+    std::vector<Model> levels_;      // The meshes from finest to coarsest
+    std::vector<Real>  edgeLengths_; // The mean edge length of each level
+    Vector3            center_;      // Bounding sphere center of the model
+    Real               radius_;      // Bounding sphere radius of the model
+  };
+
+  //////////////////////////////////////////////////////////////////////////////
+  // Class: LodMesh
+  //
+  // A triangle mesh primitive which intersects each ray with the level of a
+  // LodChain matching the ray's footprint where it reaches the mesh. Each
+  // level is kept as a CompressedMesh with 21-bit vertices.
+  //
+  // Rays with no width (such as those of Camera::generateRay) always use the
+  // full mesh. Camera rays from generateRays and the rays spawned at their
+  // hits widen with distance, so the mesh is traced coarser the further and
+  // the more often reflected it is. The surfaces of neighbouring levels lie
+  // up to about a footprint apart, so hits closer than the ray's own width
+  // to its origin are ignored, keeping the shadow and secondary rays leaving
+  // one level from hitting another level of the same mesh.
+  class LodMesh : public Primitive {
+  public:
+    ////////////////////////////////////////////////////////////////////////////
+    // Function: LodMesh
+    //
+    // Parameters:
+    //   model - The full detail mesh
+    //   mat - The material of the mesh
+    //   maxLevels, minTriangles - The limits of the chain (see LodChain)
+    LodMesh(const Model& model,
+            Material* mat,
+            const size_t& maxLevels = 8,
+            const size_t& minTriangles = 64);
+
+    ~LodMesh();
+
+    ////////////////////////////////////////////////////////////////////////////
+    // Function: intersection
+    //
+    // Computes the closest intersection with the level of the mesh selected
+    // by the ray's footprint at the mesh's bounding sphere. Safe to call from
+    // several threads at once.
+    bool intersection(const Ray& ray, Hit& hit, Real tmin);
+
+    ////////////////////////////////////////////////////////////////////////////
+    // Function: chain
+    //
+    // Returns the chain the levels were built from
+    const LodChain& chain() const { return chain_; }
+
+    ////////////////////////////////////////////////////////////////////////////
+    // Function: mesh
+    //
+    // Returns the mesh of the given level
+    const CompressedMesh& mesh(const size_t& index) const {
+      assert(index < meshes_.size());
+      return *meshes_[index];
+    }
+  private:
+    LodMesh(const LodMesh&);
+    LodMesh& operator = (const LodMesh&);
+
+    LodChain                     chain_;  // Selects the level for a ray
+    std::vector<CompressedMesh*> meshes_; // The mesh of each level
+  };
+}
+
+#endif // MESH_LOD_HPP__
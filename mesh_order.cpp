@@ -0,0 +1,132 @@
+////////////////////////////////////////////////////////////////////////////////
+// Base: A Simple Graphics Suite
+// Author: Eric Scrivner
+//
+// Time-stamp: <Last modified 2026-10-19 13:02:47 by Eric Scrivner>
+//
+// Description:
+//   Spatial reordering of mesh faces and vertices.
+////////////////////////////////////////////////////////////////////////////////
+
+#include "mesh_order.hpp"
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+using namespace std;
+
+namespace {
+  //////////////////////////////////////////////////////////////////////////////
+  // Function: SpreadBits
+  //
+  // Spreads the low 21 bits of the given value so that there are two zero bits
+  // between each of them.
+  uint64_t SpreadBits(uint64_t value) {
+    value &= 0x1fffff;
+    value = (value | (value << 32)) & 0x001f00000000ffffULL;
+    value = (value | (value << 16)) & 0x001f0000ff0000ffULL;
+    value = (value | (value << 8))  & 0x100f00f00f00f00fULL;
+    value = (value | (value << 4))  & 0x10c30c30c30c30c3ULL;
+    value = (value | (value << 2))  & 0x1249249249249249ULL;
+    return value;
+  }
+
+  //////////////////////////////////////////////////////////////////////////////
+  // Function: Quantize
+  //
+  // Maps a coordinate in the range [0, 1] onto 21 bits
+  uint64_t Quantize(const Base::Real& value) {
+    const Base::Real kMax = (1 << 21) - 1;
+    Base::Real scaled = value * kMax;
+    if (!(scaled > 0)) {
+      return 0;
+    }
+    return static_cast<uint64_t>(min(scaled, kMax));
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+uint64_t Base::MortonCode(const Real& x, const Real& y, const Real& z) {
+  return SpreadBits(Quantize(x)) |
+    (SpreadBits(Quantize(y)) << 1) |
+    (SpreadBits(Quantize(z)) << 2);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void Base::ReorderMesh(Model& model) {
+  size_t numFaces = model.numFaces();
+  size_t numVertices = model.numVertices();
+  if (numFaces == 0) {
+    return;
+  }
+
+  // Find the bounds of the vertices
+  Vector3 lower = model.vertex(0);
+  Vector3 upper = lower;
+  for (size_t i = 1; i < numVertices; i++) {
+    const Vertex& v = model.vertex(i);
+    lower = Vector3(min(lower.x, v.x), min(lower.y, v.y), min(lower.z, v.z));
+    upper = Vector3(max(upper.x, v.x), max(upper.y, v.y), max(upper.z, v.z));
+  }
+
+  // Use one scale for all axes so the curve is not stretched
+  Vector3 extent = upper - lower;
+  Real size = max(extent.x, max(extent.y, extent.z));
+  Real scale = (size > 0) ? 1 / size : 0;
+
+  // Sort the faces by the Morton code of their centroids. Ties keep their
+  // original order so the result is deterministic.
+  vector< pair<uint64_t, size_t> > order(numFaces);
+  for (size_t f = 0; f < numFaces; f++) {
+    const size_t* face = model.faceIndices(f);
+    size_t faceSize = model.faceSize(f);
+    Vector3 centroid(0, 0, 0);
+    for (size_t k = 0; k < faceSize; k++) {
+      centroid += model.vertex(face[k]);
+    }
+    if (faceSize > 0) {
+      centroid = centroid / faceSize;
+    }
+
+    Vector3 p = (centroid - lower) * scale;
+    order[f] = make_pair(MortonCode(p.x, p.y, p.z), f);
+  }
+  sort(order.begin(), order.end());
+
+  // Renumber the vertices in order of first use by the sorted faces
+  const size_t kUnused = static_cast<size_t>(-1);
+  vector<size_t> remap(numVertices, kUnused);
+  VertexList vertices;
+  IndexList indices;
+  IndexList faceStart;
+  vertices.reserve(numVertices);
+  indices.reserve(model.faceIndices(numFaces - 1) +
+                  model.faceSize(numFaces - 1) - model.faceIndices(0));
+  faceStart.reserve(numFaces + 1);
+  faceStart.push_back(0);
+
+  for (size_t i = 0; i < numFaces; i++) {
+    size_t f = order[i].second;
+    const size_t* face = model.faceIndices(f);
+    size_t faceSize = model.faceSize(f);
+    for (size_t k = 0; k < faceSize; k++) {
+      size_t v = face[k];
+      if (remap[v] == kUnused) {
+	remap[v] = vertices.size();
+	vertices.push_back(model.vertex(v));
+      }
+      indices.push_back(remap[v]);
+    }
+    faceStart.push_back(indices.size());
+  }
+
+  for (size_t v = 0; v < numVertices; v++) {
+    if (remap[v] == kUnused) {
+      vertices.push_back(model.vertex(v));
+    }
+  }
+
+  model.setMesh(vertices, indices, faceStart);
+}
@@ -0,0 +1,42 @@
+////////////////////////////////////////////////////////////////////////////////
+// Base: A Simple Graphics Suite
+// Author: Eric Scrivner
+//
+// Time-stamp: <Last modified 2026-10-19 13:02:47 by Eric Scrivner>
+//
+// Description:
+//   Spatial reordering of mesh faces and vertices.
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef MESH_ORDER_HPP__
+#define MESH_ORDER_HPP__
+
+#include "model.hpp"
+
+#include <stdint.h>
+
+namespace Base {
+  //////////////////////////////////////////////////////////////////////////////
+  // Function: MortonCode
+  //
+  // Parameters:
+  //   x, y, z - Coordinates in the range [0, 1]
+  //
+  // Returns the 63-bit Morton (Z-order) code of the given point, interleaving
+  // 21 bits of each coordinate. Points with nearby codes are near each other.
+  uint64_t MortonCode(const Real& x, const Real& y, const Real& z);
+
+  //////////////////////////////////////////////////////////////////////////////
+  // Function: ReorderMesh
+  //
+  // Parameters:
+  //   model - The model to be reordered
+  //
+  // Sorts the faces of the model along a Morton curve through their centroids
+  // and renumbers the vertices in order of first use, so that faces and
+  // vertices which are close in space are also close in memory. Vertices used
+  // by no face are kept at the end. The shape of the mesh is unchanged.
+  void ReorderMesh(Model& model);
+}
+
+#endif // MESH_ORDER_HPP__
@@ -10,131 +10,529 @@
 ////////////////////////////////////////////////////////////////////////////////
 
 #include "draw_line.hpp"
+#include "image.hpp"
+#include "mapped_file.hpp"
 #include "material.hpp"
+#include "mesh_cache.hpp"
 #include "model.hpp"
 #include "primitive.hpp"
+#include "vertex_transform.hpp"
 
-#include <iostream>
-#include <fstream>
-#include <sstream>
+#include <algorithm>
+#include <thread>
 
 #include <cstdlib>
+#include <cstring>
 
 using namespace std;
 
 ////////////////////////////////////////////////////////////////////////////////
 // OBJ Parser
+//
+// The parser works directly on the memory-mapped file contents. Numbers are
+// scanned by hand rather than through streams, and nothing is allocated per
+// line.
 
-enum eLineType {
-  eVertex,
-  eFace,
-  eOther
-};
+namespace {
+  //////////////////////////////////////////////////////////////////////////////
+  // Powers of ten which are exactly representable as doubles
+  const double kPowersOfTen[] = {
+    1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+  };
 
-////////////////////////////////////////////////////////////////////////////////
+  const int kMaxExactPower = 22;
+
+  //////////////////////////////////////////////////////////////////////////////
+
+  inline bool IsSpace(const char& c) {
+    return c == ' ' || c == '\t';
+  }
+
+  inline bool IsDigit(const char& c) {
+    return static_cast<unsigned char>(c - '0') < 10;
+  }
 
-eLineType LineType(const std::string& line) {
-  // Accumulate the first word in a string
-  std::string firstWord;
+  //////////////////////////////////////////////////////////////////////////////
 
-  // Loop through each character in the string
-  for (size_t i = 0; i < line.length(); i++) {
-    // If we have reached the end of word character
-    if (line[i] == ' ') {
-      // Exit the loop
-      break;
+  inline void SkipSpaces(const char*& p, const char* end) {
+    while (p < end && IsSpace(*p)) {
+      p++;
     }
+  }
 
-    // Add the character to the first word
-    firstWord += line[i];
+  //////////////////////////////////////////////////////////////////////////////
+
+  inline const char* SkipLine(const char* p, const char* end) {
+    const char* eol = static_cast<const char*>(memchr(p, '\n', end - p));
+    return (eol == 0) ? end : eol + 1;
   }
 
-  if (firstWord == "v") {
-    return eVertex;
-  } else if (firstWord == "f") {
-    return eFace;
+  //////////////////////////////////////////////////////////////////////////////
+  // Function: ParseReal
+  //
+  // Parses a decimal real number at p, advancing p past it. Numbers with at
+  // most 19 significant digits and a small exponent are converted exactly with
+  // a single multiply or divide; anything else falls back to strtod.
+  bool ParseReal(const char*& p, const char* end, Base::Real& result) {
+    const char* start = p;
+    bool negative = false;
+
+    if (p < end && (*p == '-' || *p == '+')) {
+      negative = (*p == '-');
+      p++;
+    }
+
+    // Accumulate the significant digits into an integer mantissa
+    unsigned long long mantissa = 0;
+    int numDigits = 0;
+    int exponent = 0;
+    bool sawDigit = false;
+
+    while (p < end && IsDigit(*p)) {
+      if (numDigits < 19) {
+	mantissa = mantissa * 10 + (*p - '0');
+	if (mantissa != 0) {
+	  numDigits++;
+	}
+      } else {
+	exponent++;
+      }
+      sawDigit = true;
+      p++;
+    }
+
+    if (p < end && *p == '.') {
+      p++;
+      while (p < end && IsDigit(*p)) {
+	if (numDigits < 19) {
+	  mantissa = mantissa * 10 + (*p - '0');
+	  if (mantissa != 0) {
+	    numDigits++;
+	  }
+	  exponent--;
+	}
+	sawDigit = true;
+	p++;
+      }
+    }
+
+    if (!sawDigit) {
+      p = start;
+      return false;
+    }
+
+    if (p < end && (*p == 'e' || *p == 'E')) {
+      const char* expStart = p++;
+      bool expNegative = false;
+      if (p < end && (*p == '-' || *p == '+')) {
+	expNegative = (*p == '-');
+	p++;
+      }
+
+      if (p < end && IsDigit(*p)) {
+	int expValue = 0;
+	while (p < end && IsDigit(*p)) {
+	  if (expValue < 10000) {
+	    expValue = expValue * 10 + (*p - '0');
+	  }
+	  p++;
+	}
+	exponent += expNegative ? -expValue : expValue;
+      } else {
+	// Not an exponent after all
+	p = expStart;
+      }
+    }
+
+    // Fast path: both the mantissa and the power of ten are exact doubles,
+    // so the single rounding of the multiply or divide is correct.
+    if (mantissa < (1ULL << 53) &&
+        exponent >= -kMaxExactPower && exponent <= kMaxExactPower) {
+      double value = static_cast<double>(mantissa);
+      if (exponent < 0) {
+	value /= kPowersOfTen[-exponent];
+      } else {
+	value *= kPowersOfTen[exponent];
+      }
+      result = negative ? -value : value;
+      return true;
+    }
+
+    // Slow path for long or extreme numbers. The token is copied since the
+    // mapped file is not null terminated.
+    char buffer[64];
+    size_t length = std::min(static_cast<size_t>(p - start),
+                             sizeof(buffer) - 1);
+    memcpy(buffer, start, length);
+    buffer[length] = '\0';
+    result = strtod(buffer, 0);
+    return true;
   }
 
-  return eOther;
-}
+  //////////////////////////////////////////////////////////////////////////////
+  // Function: ParseIndex
+  //
+  // Parses a (possibly negative) integer at p, advancing p past it.
+  bool ParseIndex(const char*& p, const char* end, long& result) {
+    bool negative = false;
+    if (p < end && *p == '-') {
+      negative = true;
+      p++;
+    }
 
-////////////////////////////////////////////////////////////////////////////////
+    if (p >= end || !IsDigit(*p)) {
+      return false;
+    }
 
-Base::Vertex VertexFromString(const std::string& vertStr) {
-  Base::Vertex result;
-  string firstWord;
+    long value = 0;
+    while (p < end && IsDigit(*p)) {
+      value = value * 10 + (*p - '0');
+      p++;
+    }
 
-  std::stringstream s(vertStr);
-  s >> firstWord >> result.x >> result.y >> result.z;
+    result = negative ? -value : value;
+    return true;
+  }
 
-  return result;
-}
+  //////////////////////////////////////////////////////////////////////////////
+  // Function: ParseVertex
+  //
+  // Parses the coordinates following a "v" keyword.
+  Base::Vertex ParseVertex(const char*& p, const char* end) {
+    Base::Vertex v(0, 0, 0);
+
+    SkipSpaces(p, end);
+    ParseReal(p, end, v.x);
+    SkipSpaces(p, end);
+    ParseReal(p, end, v.y);
+    SkipSpaces(p, end);
+    ParseReal(p, end, v.z);
+
+    return v;
+  }
 
+  //////////////////////////////////////////////////////////////////////////////
+  // Function: ParseFaceIndex
+  //
+  // Parses the next vertex reference following an "f" keyword, advancing p
+  // past it. Each reference has the form v, v/vt, v//vn or v/vt/vn and only
+  // the (one-based, or negative and relative) vertex index is kept. Returns
+  // false once there are no more references on the line.
+  bool ParseFaceIndex(const char*& p, const char* end, long& index) {
+    SkipSpaces(p, end);
+    if (!ParseIndex(p, end, index)) {
+      return false;
+    }
+
+    // Skip any texture coordinate and normal references
+    while (p < end && !IsSpace(*p) && *p != '\n' && *p != '\r') {
+      p++;
+    }
+    return true;
+  }
+
+  //////////////////////////////////////////////////////////////////////////////
+  // Function: VertexIndex
+  //
+  // Converts a one-based or relative OBJ index into an array index, given
+  // the number of vertices read before it. Relative indices count back from
+  // the most recently read vertex. Bad indices (zero, or before the first
+  // vertex) wrap around to very large values.
+  inline size_t VertexIndex(const long& index, const size_t& numVertices) {
+    return (index < 0) ? numVertices + index : index - 1;
+  }
+
+  //////////////////////////////////////////////////////////////////////////////
+  // Function: ParseLines
+  //
+  // Parses the OBJ text in [begin, end), which must start at the beginning of
+  // a line, passing each vertex to parser.vertex and the text following each
+  // "f" keyword to parser.face. Stops, returning false, if parser.face does.
+  template <typename Parser>
+  bool ParseLines(const char* begin, const char* end, Parser& parser) {
+    const char* p = begin;
+
+    while (p < end) {
+      SkipSpaces(p, end);
+
+      // Dispatch on the keyword; only "v" and "f" lines are of interest
+      if (end - p > 1 && IsSpace(p[1])) {
+	if (p[0] == 'v') {
+	  p += 2;
+	  parser.vertex(ParseVertex(p, end));
+	} else if (p[0] == 'f') {
+	  p += 2;
+	  if (!parser.face(p, end)) {
+	    return false;
+	  }
+	}
+      }
+
+      p = SkipLine(p, end);
+    }
+
+    return true;
+  }
+
+  //////////////////////////////////////////////////////////////////////////////
+  // Struct: ObjChunk
+  //
+  // The vertices and faces parsed from one contiguous range of lines of an
+  // OBJ file. Positive face indices are absolute and final, while relative
+  // (negative) indices are resolved against the chunk's own vertex count and
+  // must be offset by the number of vertices in all preceding chunks.
+  struct ObjChunk {
+    Base::VertexList vertices;  // The vertices read from the chunk
+    Base::IndexList  indices;   // The face indices read from the chunk
+    Base::IndexList  faceStart; // Offset of each face in indices, plus the end
+    Base::IndexList  relative;  // Positions in indices needing the vertex base
+
+    ObjChunk()
+      : faceStart(1, 0)
+    { }
+
+    void vertex(const Base::Vertex& v) {
+      vertices.push_back(v);
+    }
+
+    ////////////////////////////////////////////////////////////////////////////
+    // Function: face
+    //
+    // Parses the vertex references of a face. A relative index may point
+    // before the start of the chunk, in which case it wraps until the vertex
+    // base is added back in.
+    bool face(const char*& p, const char* end) {
+      long index;
+      while (ParseFaceIndex(p, end, index)) {
+	if (index < 0) {
+	  relative.push_back(indices.size());
+	}
+	indices.push_back(VertexIndex(index, vertices.size()));
+      }
+
+      faceStart.push_back(indices.size());
+      return true;
+    }
+  };
+
+  //////////////////////////////////////////////////////////////////////////////
+  // Struct: ObjStream
+  //
+  // Passes the vertices and faces of an OBJ file to an ObjReader as they are
+  // parsed, keeping only the vertex count and the face being parsed
+  struct ObjStream {
+    Base::ObjReader& reader;      // Receives the vertices and faces
+    size_t           numVertices; // The vertices read so far
+    Base::IndexList  indices;     // The indices of the current face
+
+    ObjStream(Base::ObjReader& r)
+      : reader(r), numVertices(0)
+    { }
+
+    void vertex(const Base::Vertex& v) {
+      reader.vertex(v);
+      numVertices++;
+    }
+
+    ////////////////////////////////////////////////////////////////////////////
+    // Function: face
+    //
+    // Parses the vertex references of a face and passes it on, returning
+    // false if one refers to a vertex which has not been read
+    bool face(const char*& p, const char* end) {
+      indices.clear();
+      long index;
+      while (ParseFaceIndex(p, end, index)) {
+	size_t vertex = VertexIndex(index, numVertices);
+	if (vertex >= numVertices) {
+	  return false;
+	}
+	indices.push_back(vertex);
+      }
+
+      reader.face(indices.data(), indices.size());
+      return true;
+    }
+  };
+
+  //////////////////////////////////////////////////////////////////////////////
+  // Function: ParseObj
+  //
+  // Parses the OBJ text in [begin, end), which must start at the beginning of
+  // a line, appending the vertices and faces found to the given chunk.
+  void ParseObj(const char* begin, const char* end, ObjChunk* chunk) {
+    ParseLines(begin, end, *chunk);
+  }
+
+  //////////////////////////////////////////////////////////////////////////////
+  // Function: NumParseChunks
+  //
+  // Returns the number of chunks (and threads) to use when parsing a file of
+  // the given size. Small files are parsed on the calling thread alone.
+  size_t NumParseChunks(const size_t& fileSize) {
+    const size_t kMinChunkSize = 4 * 1024 * 1024;
+
+    size_t numThreads = std::thread::hardware_concurrency();
+    size_t numChunks = std::min(std::max(numThreads, size_t(1)),
+                                fileSize / kMinChunkSize);
+    return std::max(numChunks, size_t(1));
+  }
+}
 
 ////////////////////////////////////////////////////////////////////////////////
 
-Base::Face FaceFromString(const std::string& faceStr) {
-  // Create a substring removing the first word from the string
-  std::string parsableFace;
-  parsableFace = faceStr.substr(faceStr.find(" "), faceStr.length());
+bool Base::ValidMesh(const size_t& numVertices, const IndexList& indices,
+                     const IndexList& faceStart) {
+  if (faceStart.empty() || faceStart.front() != 0 ||
+      faceStart.back() != indices.size()) {
+    return false;
+  }
+
+  for (size_t i = 1; i < faceStart.size(); i++) {
+    if (faceStart[i] < faceStart[i - 1]) {
+      return false;
+    }
+  }
 
-  // Attempt to tokenize the given string
-  Base::Face result;
-  char* token = strtok(const_cast<char*>(parsableFace.c_str()), " \t\n\r");
-  std::string nextNum;
+  // Bad OBJ indices (zero, or relative indices before the first vertex)
+  // have wrapped around to very large values by now
+  for (size_t i = 0; i < indices.size(); i++) {
+    if (indices[i] >= numVertices) {
+      return false;
+    }
+  }
 
-  // While there are still tokens left
-  while (token != NULL) {
-    // Parse the first number from the triplet of the form v/vt/vn
-    std::string curToken = token;
-    nextNum = curToken.substr(0, curToken.find("/"));
+  return true;
+}
 
-    // Add the number to the facial indices, subtracting one since they
-    // will become array indices.
-    result.addIndex(atoi(nextNum.c_str()) - 1);
+////////////////////////////////////////////////////////////////////////////////
 
-    // Retrieve the next number
-    token = strtok(NULL, " \t\n\r");
+bool Base::ReadObj(const std::string& fileName, ObjReader& reader) {
+  MappedFile objFile;
+  if (!objFile.open(fileName)) {
+    return false;
   }
 
-  return result;
+  ObjStream stream(reader);
+  return ParseLines(objFile.data(), objFile.data() + objFile.size(), stream);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 // Model
 
-bool Base::Model::load(const std::string& fileName) {
+bool Base::Model::load(const std::string& fileName, bool useCache) {
   // Ensure the string has characters in it
   if (fileName.length() == 0) {
     return false;
   }
 
-  // Attempt to open the given file
-  std::ifstream modelFile(fileName.c_str());
+  edges_.clear();
+
+  // Use the binary cache if it is up to date
+  if (useCache && LoadMeshCache(fileName, vertices_, indices_, faceStart_)) {
+    return true;
+  }
+
+  // Otherwise parse the file and cache the result
+  if (!_parse(fileName) ||
+      !ValidMesh(vertices_.size(), indices_, faceStart_)) {
+    VertexList().swap(vertices_);
+    IndexList().swap(indices_);
+    faceStart_.assign(1, 0);
+    return false;
+  }
+
+  if (useCache) {
+    SaveMeshCache(fileName, vertices_, indices_, faceStart_);
+  }
+
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool Base::Model::_parse(const std::string& fileName) {
+  // Attempt to map the given file
+  MappedFile modelFile;
 
   // If the file could not be opened
-  if (!modelFile.is_open() || !modelFile.good()) {
+  if (!modelFile.open(fileName)) {
     // Return an error
     return false;
   }
 
-  // Clear the vertices and faces from this model
+  const char* begin = modelFile.data();
+  const char* end = begin + modelFile.size();
+  size_t numChunks = NumParseChunks(modelFile.size());
+
+  // Split the file into chunks at line boundaries
+  std::vector<const char*> bounds(numChunks + 1, end);
+  bounds[0] = begin;
+  for (size_t i = 1; i < numChunks; i++) {
+    const char* split = std::max(begin + modelFile.size() / numChunks * i,
+                                 bounds[i - 1]);
+    bounds[i] = SkipLine(split, end);
+  }
+
+  // Parse every chunk but the first on its own thread
+  std::vector<ObjChunk> chunks(numChunks);
+  std::vector<std::thread> workers;
+  for (size_t i = 1; i < numChunks; i++) {
+    workers.push_back(std::thread(ParseObj, bounds[i], bounds[i + 1],
+                                  &chunks[i]));
+  }
+
+  ParseObj(bounds[0], bounds[1], &chunks[0]);
+
+  for (size_t i = 0; i < workers.size(); i++) {
+    workers[i].join();
+  }
+
+  // A single chunk needs no fix-up and can be taken over as-is
+  if (numChunks == 1) {
+    vertices_.swap(chunks[0].vertices);
+    indices_.swap(chunks[0].indices);
+    faceStart_.swap(chunks[0].faceStart);
+    return true;
+  }
+
+  // Otherwise concatenate the chunks, offsetting the relative indices of each
+  // by the number of vertices preceding it.
+  size_t numVertices = 0, numIndices = 0, numFaces = 0;
+  for (size_t i = 0; i < numChunks; i++) {
+    numVertices += chunks[i].vertices.size();
+    numIndices += chunks[i].indices.size();
+    numFaces += chunks[i].faceStart.size() - 1;
+  }
+
   vertices_.clear();
-  faces_.clear();
+  indices_.clear();
+  faceStart_.assign(1, 0);
+  vertices_.reserve(numVertices);
+  indices_.reserve(numIndices);
+  faceStart_.reserve(numFaces + 1);
+
+  for (size_t i = 0; i < numChunks; i++) {
+    ObjChunk& chunk = chunks[i];
+    size_t vertexBase = vertices_.size();
+    size_t indexBase = indices_.size();
+
+    for (size_t j = 0; j < chunk.relative.size(); j++) {
+      chunk.indices[chunk.relative[j]] += vertexBase;
+    }
 
-  // While there are lines left to read
-  std::string nextLine;
-  while (std::getline(modelFile, nextLine)) {
-    // If the type of data on the next line is ...
-    switch (LineType(nextLine)) {
-    case eVertex: // a vertex
-      addVertex(VertexFromString(nextLine));
-      break;
-    case eFace: // a face
-      addFace(FaceFromString(nextLine));
-      break;
-    default: break;
+    vertices_.insert(vertices_.end(),
+                     chunk.vertices.begin(), chunk.vertices.end());
+    indices_.insert(indices_.end(),
+                    chunk.indices.begin(), chunk.indices.end());
+    for (size_t j = 1; j < chunk.faceStart.size(); j++) {
+      faceStart_.push_back(chunk.faceStart[j] + indexBase);
     }
+
+    // Release the chunk as soon as it has been merged
+    ObjChunk().vertices.swap(chunk.vertices);
+    ObjChunk().indices.swap(chunk.indices);
   }
 
   return true;
@@ -142,45 +540,67 @@ bool Base::Model::load(const std::string& fileName) {
 
 ////////////////////////////////////////////////////////////////////////////////
 
-void Base::Model::draw(const Base::Vector3& pos) {
+void Base::Model::draw(const Base::Vector3& pos, bool cullBackFaces) {
   // Translate all the vertices to the given position
-  for (size_t i = 0; i < vertices_.size(); i++) {
-    vertices_[i] += pos;
+  Matrix44 translation;
+  translation.makeTranslate(pos.x, pos.y, pos.z);
+  transform(translation, drawVertices_);
+
+  // The viewport spans -(width/2) to width/2 and -(height/2) to height/2
+  GLint viewport[4];
+  glGetIntegerv(GL_VIEWPORT, viewport);
+  Real xMax = viewport[2] / 2.0;
+  Real yMax = viewport[3] / 2.0;
+  _clipEdges(-xMax, -yMax, xMax, yMax, cullBackFaces);
+
+  for (size_t i = 0; i < drawLines_.size(); i += 4) {
+    Base::DrawLine(Vector3(drawLines_[i], drawLines_[i + 1], 0),
+                   Vector3(drawLines_[i + 2], drawLines_[i + 3], 0),
+                   color_);
   }
+}
 
-  // Loop through each of the faces
-  for (size_t i = 0; i < faces_.size(); i++) {
-    // Loop through each triple of vertices in the face
-    size_t numIndices = faces_[i].size();
+////////////////////////////////////////////////////////////////////////////////
 
-    for (size_t j = 0; j < numIndices; j++) {
-      _drawTriangle(faces_[i][j],
-                    faces_[i][(j + 1) % numIndices],
-                    faces_[i][(j + 2) % numIndices]);
-    }
-  }
+void Base::Model::draw(Image& image, const Vector3& pos, bool cullBackFaces) {
+  // Translate the vertices to the given position relative to the center
+  Matrix44 translation;
+  translation.makeTranslate(pos.x + image.width() / 2,
+                            pos.y + image.height() / 2,
+                            pos.z);
+  transform(translation, drawVertices_);
+
+  _clipEdges(0, 0, image.width() - 1, image.height() - 1, cullBackFaces);
 
-  // Untranslate all the vertices
-  for (size_t i = 0; i < vertices_.size(); i++) {
-    vertices_[i] -= pos;
+  for (size_t i = 0; i < drawLines_.size(); i += 4) {
+    Base::DrawLineBresenham(image, drawLines_[i], drawLines_[i + 1],
+                            drawLines_[i + 2], drawLines_[i + 3], color_);
   }
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 
-Base::Group* Base::Model::toPrimitive(Material* material) {
-  Base::Group* group = new Base::Group();
+Base::Group* Base::Model::toPrimitive(Material* material, Arena* arena) {
+  Base::Group* group = arena ? arena->create<Group>(arena) : new Group();
+
+  size_t numTriangles = 0;
+  for (size_t i = 0; i < numFaces(); i++) {
+    numTriangles += (faceSize(i) > 2) ? faceSize(i) - 2 : 0;
+  }
+  group->reserve(numTriangles);
   
   // Loop through each of the faces
-  for (size_t i = 0; i < faces_.size(); i++) {
-    // Loop through each triple of vertices in the face
-    size_t numIndices = faces_[i].size();
+  for (size_t i = 0; i < numFaces(); i++) {
+    // Split the face into a fan of triangles around its first vertex
+    size_t numIndices = faceSize(i);
+    const size_t* face = faceIndices(i);
     
-    for (size_t j = 0; j < numIndices; j++) {
-      group->addPrimitive(_makeTriangle(faces_[i][j],
-                                        faces_[i][(j + 1) % numIndices],
-                                        faces_[i][(j + 2) % numIndices],
-                                        material));
+    for (size_t j = 1; j + 1 < numIndices; j++) {
+      group->addPrimitive(_makeTriangle(face[0],
+                                        face[j],
+                                        face[j + 1],
+                                        material,
+                                        arena));
     }
   }
 
@@ -190,28 +610,122 @@ Base::Group* Base::Model::toPrimitive(Material* material) {
 ////////////////////////////////////////////////////////////////////////////////
 
 void Base::Model::transform(const Matrix44& transformation) {
-  Vector4 result;
-  for (size_t i = 0; i < vertices_.size(); i++) {
-    result = transformation * Vector4(vertices_[i]);
-    vertices_[i].x = result.x;
-    vertices_[i].y = result.y;
-    vertices_[i].z = result.z;
+  TransformPoints(transformation, vertices_.data(), vertices_.data(),
+                  vertices_.size());
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void Base::Model::transform(const Matrix44& transformation,
+                            VertexList& out) const {
+  out.resize(vertices_.size());
+  TransformPoints(transformation, vertices_.data(), out.data(),
+                  vertices_.size());
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void Base::Model::_buildEdges() {
+  if (!edges_.empty() || indices_.empty()) {
+    return;
+  }
+
+  // Gather every side of every face, with its ends in order
+  struct Side {
+    size_t v1, v2, face;
+    bool operator < (const Side& rhs) const {
+      if (v1 != rhs.v1) return v1 < rhs.v1;
+      if (v2 != rhs.v2) return v2 < rhs.v2;
+      return face < rhs.face;
+    }
+  };
+
+  std::vector<Side> sides;
+  sides.reserve(indices_.size());
+  for (size_t f = 0; f < numFaces(); f++) {
+    size_t size = faceSize(f);
+    const size_t* face = faceIndices(f);
+    for (size_t j = 0; j < size; j++) {
+      size_t a = face[j];
+      size_t b = face[(j + 1) % size];
+      if (a != b) {
+	Side side = { std::min(a, b), std::max(a, b), f };
+	sides.push_back(side);
+      }
+    }
+  }
+  std::sort(sides.begin(), sides.end());
+
+  // Merge the sides of each edge
+  for (size_t i = 0; i < sides.size(); i++) {
+    if (!edges_.empty() && edges_.back().v1 == sides[i].v1 &&
+        edges_.back().v2 == sides[i].v2) {
+      if (edges_.back().face2 == kNoFace) {
+	edges_.back().face2 = sides[i].face;
+      }
+      continue;
+    }
+
+    Edge edge = { sides[i].v1, sides[i].v2, sides[i].face, kNoFace };
+    edges_.push_back(edge);
   }
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 
-void Base::Model::_drawTriangle(size_t& v1, size_t& v2, size_t& v3) {
-  Base::DrawLine(vertices_[v1], vertices_[v2], color_);
-  Base::DrawLine(vertices_[v2], vertices_[v3], color_);
-  Base::DrawLine(vertices_[v3], vertices_[v1], color_);
+void Base::Model::_clipEdges(const Real& xMin, const Real& yMin,
+                             const Real& xMax, const Real& yMax,
+                             bool cullBackFaces) {
+  _buildEdges();
+  drawLines_.clear();
+
+  // Find the faces which are counter-clockwise on the screen from their
+  // signed areas
+  if (cullBackFaces) {
+    frontFacing_.resize(numFaces());
+    for (size_t f = 0; f < numFaces(); f++) {
+      size_t size = faceSize(f);
+      const size_t* face = faceIndices(f);
+      Real area = 0;
+      for (size_t j = 0; j < size; j++) {
+	const Vertex& a = drawVertices_[face[j]];
+	const Vertex& b = drawVertices_[face[(j + 1) % size]];
+	area += a.x * b.y - b.x * a.y;
+      }
+      frontFacing_[f] = (area > 0);
+    }
+  }
+
+  for (size_t i = 0; i < edges_.size(); i++) {
+    const Edge& edge = edges_[i];
+    if (cullBackFaces && !frontFacing_[edge.face1] &&
+        (edge.face2 == kNoFace || !frontFacing_[edge.face2])) {
+      continue;
+    }
+
+    Real x1 = drawVertices_[edge.v1].x;
+    Real y1 = drawVertices_[edge.v1].y;
+    Real x2 = drawVertices_[edge.v2].x;
+    Real y2 = drawVertices_[edge.v2].y;
+    if (ClipLine(x1, y1, x2, y2, xMin, yMin, xMax, yMax)) {
+      drawLines_.push_back(x1);
+      drawLines_.push_back(y1);
+      drawLines_.push_back(x2);
+      drawLines_.push_back(y2);
+    }
+  }
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 
-Base::Triangle* Base::Model::_makeTriangle(size_t& v1,
-                                           size_t& v2,
-                                           size_t& v3,
-                                           Material* mat) {
+Base::Triangle* Base::Model::_makeTriangle(size_t v1,
+                                           size_t v2,
+                                           size_t v3,
+                                           Material* mat,
+                                           Arena* arena) {
+  if (arena != 0) {
+    return arena->create<Triangle>(vertices_[v1], vertices_[v2], vertices_[v3],
+                                   mat);
+  }
   return new Base::Triangle(vertices_[v1], vertices_[v2], vertices_[v3], mat);
 }
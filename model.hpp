@@ -21,13 +21,72 @@
 namespace Base {
   //////////////////////////////////////////////////////////////////////////////
   // Forward definitions
+  class Arena;
   class Group;
+  class Image;
   class Material;
   class Triangle;
 
   //////////////////////////////////////////////////////////////////////////////
   // Type definitions
   typedef Vector3 Vertex;
+  typedef std::vector<Vertex> VertexList;
+  typedef std::vector<size_t> IndexList;
+
+  //////////////////////////////////////////////////////////////////////////////
+  // Function: ValidMesh
+  //
+  // Parameters:
+  //   numVertices - The number of vertices in the mesh
+  //   indices - The vertex indices of every face, in order
+  //   faceStart - The offset of each face in indices, followed by the total
+  //               number of indices
+  //
+  // Returns true if the face offsets are in order and cover indices, and
+  // every index refers to one of the vertices.
+  bool ValidMesh(const size_t& numVertices, const IndexList& indices,
+                 const IndexList& faceStart);
+
+  //////////////////////////////////////////////////////////////////////////////
+  // Class: ObjReader
+  //
+  // Receives the vertices and faces of an OBJ file from ReadObj, one at a
+  // time and in the order they appear in the file
+  class ObjReader {
+  public:
+    virtual ~ObjReader() { }
+
+    ////////////////////////////////////////////////////////////////////////////
+    // Function: vertex
+    //
+    // Called with each vertex of the file
+    virtual void vertex(const Vertex& v) = 0;
+
+    ////////////////////////////////////////////////////////////////////////////
+    // Function: face
+    //
+    // Parameters:
+    //   indices - The zero-based indices of the vertices of the face
+    //   count - The number of indices
+    //
+    // Called with each face of the file. Every index refers to a vertex
+    // which has already been passed to vertex.
+    virtual void face(const size_t* indices, const size_t& count) = 0;
+  };
+
+  //////////////////////////////////////////////////////////////////////////////
+  // Function: ReadObj
+  //
+  // Parameters:
+  //   fileName - The name of the OBJ file to be read
+  //   reader - Receives the vertices and faces of the file
+  //
+  // Parses an OBJ file on the calling thread and passes its vertices and
+  // faces to the reader without keeping them, so a file may be read in
+  // several passes whatever its size. Returns false if the file cannot be
+  // opened, or if a face refers to a vertex which has not yet been read (in
+  // which case reading stops before that face).
+  bool ReadObj(const std::string& fileName, ObjReader& reader);
 
   //////////////////////////////////////////////////////////////////////////////
   // Class: Face
@@ -57,6 +116,11 @@ namespace Base {
       return index_[index];
     }
 
+    const size_t& operator [] (const size_t& index) const {
+      assert(index < index_.size());
+      return index_[index];
+    }
+
     //////////////////////////////////////////////////////////////////////////////
     // Function: size
     //
@@ -71,35 +135,73 @@ namespace Base {
   // Class: Model
   //
   // Represents a model loaded from a file in OBJ format.
+  //
+  // The faces are stored as a single list of vertex indices together with the
+  // offset at which each face starts, so loading a model performs no per-face
+  // allocation.
   class Model {
   public:
+    Model()
+      : faceStart_(1, 0)
+    { }
+
     ////////////////////////////////////////////////////////////////////////////
     // Function: load
     //
     // Parameters:
     //   fileName - The name of the file to be loaded
+    //   useCache - Whether to use (and create) a binary cache of the model
     //
     // Loads the OBJ model from the given file into the class, returning true
-    // if the model was loaded and false otherwise.
-    bool load(const std::string& fileName);
+    // if the model was loaded and false otherwise. Large files are split at
+    // line boundaries and parsed on several threads. A file with a face
+    // referring to a vertex which does not exist (including index 0, or a
+    // relative index before the first vertex) is rejected and leaves the
+    // model empty.
+    //
+    // When useCache is set the model is read from the binary cache next to
+    // the OBJ file (see MeshCacheName) if it is up to date, and otherwise the
+    // cache is written after parsing so that later loads skip the parse
+    // entirely. The cache is off by default, so loading a model never writes
+    // files unless asked to.
+    bool load(const std::string& fileName, bool useCache = false);
+
+    ////////////////////////////////////////////////////////////////////////////
+    // Function: draw
+    //
+    // Parameters:
+    //   pos - The position at which to draw the model
+    //
+    // Draws a wireframe of the model at the given position on the screen.
+    // Each edge shared by several faces is drawn once, and lines are clipped
+    // to the viewport (centered on the origin, as set up by the demo) before
+    // they are drawn. With cullBackFaces set, edges are only drawn if they
+    // border a face which is counter-clockwise on the screen.
+    void draw(const Vector3& pos, bool cullBackFaces = false);
 
     ////////////////////////////////////////////////////////////////////////////
     // Function: draw
     //
     // Parameters:
+    //   image - The image to draw into
     //   pos - The position at which to draw the model
     //
-    // Draws the model at the given position on the screen
-    void draw(const Vector3& pos);
+    // Draws the model at the given position into an image in memory, with
+    // (0, 0) at the center of the image as it is on the screen. Edges are
+    // deduplicated, clipped and culled as for the screen.
+    void draw(Image& image, const Vector3& pos, bool cullBackFaces = false);
 
     //////////////////////////////////////////////////////////////////////////////
     // Function: toPrimtive
     //
     // Parameters:
     //   material - The material to be used for the primitives
+    //   arena - The arena to allocate the group and triangles from, if any
     //
     // Converts this model into a primitive group (a group of triangles).
-    Group* toPrimitive(Material* material);
+    // Faces with more than three vertices are split into a fan of triangles;
+    // use CleanupMesh first for concave polygons.
+    Group* toPrimitive(Material* material, Arena* arena = 0);
 
     //////////////////////////////////////////////////////////////////////////////
     // Function: transform
@@ -110,6 +212,17 @@ namespace Base {
     // Applies the given transformation to all the vertices of this object
     void transform(const Matrix44& transformation);
 
+    //////////////////////////////////////////////////////////////////////////////
+    // Function: transform
+    //
+    // Parameters:
+    //   transformation - The transformation matrix
+    //   out - Receives the transformed vertices
+    //
+    // Writes the transformed vertices of this object to out, leaving the
+    // object itself unchanged.
+    void transform(const Matrix44& transformation, VertexList& out) const;
+
     //////////////////////////////////////////////////////////////////////////////
     // Function: addVertex
     //
@@ -127,8 +240,73 @@ namespace Base {
     //   face - A face to be added
     //
     // Adds the given face to this model's face list
-    void addFace(const Face& face)
-    { faces_.push_back(face); }
+    void addFace(const Face& face) {
+      for (size_t i = 0; i < face.size(); i++) {
+	indices_.push_back(face[i]);
+      }
+      faceStart_.push_back(indices_.size());
+      edges_.clear();
+    }
+
+    ////////////////////////////////////////////////////////////////////////////
+    // Function: setMesh
+    //
+    // Parameters:
+    //   vertices - The new vertex list
+    //   indices - The vertex indices of every face, in order
+    //   faceStart - The offset of each face in indices, followed by the total
+    //               number of indices
+    //
+    // Replaces the geometry of this model. The given lists are swapped into
+    // the model rather than copied, and are left holding the old geometry.
+    void setMesh(VertexList& vertices, IndexList& indices, IndexList& faceStart) {
+      assert(!faceStart.empty() && faceStart.back() == indices.size());
+      vertices_.swap(vertices);
+      indices_.swap(indices);
+      faceStart_.swap(faceStart);
+      edges_.clear();
+    }
+
+    ////////////////////////////////////////////////////////////////////////////
+    // Function: numVertices
+    //
+    // Returns the number of vertices in this model
+    size_t numVertices() const
+    { return vertices_.size(); }
+
+    ////////////////////////////////////////////////////////////////////////////
+    // Function: vertex
+    //
+    // Returns the vertex with the given index
+    const Vertex& vertex(const size_t& index) const {
+      assert(index < vertices_.size());
+      return vertices_[index];
+    }
+
+    ////////////////////////////////////////////////////////////////////////////
+    // Function: numFaces
+    //
+    // Returns the number of faces in this model
+    size_t numFaces() const
+    { return faceStart_.size() - 1; }
+
+    ////////////////////////////////////////////////////////////////////////////
+    // Function: faceSize
+    //
+    // Returns the number of vertex indices composing the given face
+    size_t faceSize(const size_t& face) const {
+      assert(face < numFaces());
+      return faceStart_[face + 1] - faceStart_[face];
+    }
+
+    ////////////////////////////////////////////////////////////////////////////
+    // Function: faceIndices
+    //
+    // Returns a pointer to the faceSize(face) vertex indices of the given face
+    const size_t* faceIndices(const size_t& face) const {
+      assert(face < numFaces());
+      return indices_.data() + faceStart_[face];
+    }
 
     ////////////////////////////////////////////////////////////////////////////////
     // Function: setColor
@@ -141,32 +319,66 @@ namespace Base {
     { color_ = color; }
   private:
     ////////////////////////////////////////////////////////////////////////////
-    // Function: _drawTriangle
+    // Function: _parse
+    //
+    // Parameters:
+    //   fileName - The name of the OBJ file to be parsed
+    //
+    // Parses the given OBJ file into the class, returning true if the file
+    // could be read and false otherwise.
+    bool _parse(const std::string& fileName);
+
+    ////////////////////////////////////////////////////////////////////////////
+    // Struct: Edge
+    //
+    // An edge of the mesh and the faces on either side of it
+    struct Edge {
+      size_t v1, v2;       // The vertex indices of the ends (v1 < v2)
+      size_t face1, face2; // The faces sharing the edge (kNoFace if none)
+    };
+    typedef std::vector<Edge> EdgeList;
+
+    static const size_t kNoFace = static_cast<size_t>(-1);
+
+    ////////////////////////////////////////////////////////////////////////////
+    // Function: _buildEdges
+    //
+    // Finds the unique edges of the faces of the model, if not already known.
+    // Edges with more than two faces keep only the first two.
+    void _buildEdges();
+
+    ////////////////////////////////////////////////////////////////////////////
+    // Function: _clipEdges
     //
     // Parameters:
-    //   v1, v2, v3 - The vertex indices forming the triangle
+    //   xMin, yMin, xMax, yMax - The rectangle to clip to
+    //   cullBackFaces - Whether to drop edges with only back faces
     //
-    // Renders a triangle using the given vertices and Bresenham's line
-    // drawing algorithm.
-    void _drawTriangle(size_t& v1, size_t& v2, size_t& v3);
+    // Fills drawLines_ with the visible part of each edge of drawVertices_
+    // as x1, y1, x2, y2.
+    void _clipEdges(const Real& xMin, const Real& yMin,
+                    const Real& xMax, const Real& yMax,
+                    bool cullBackFaces);
 
     ////////////////////////////////////////////////////////////////////////////
     // Function: _makeTriangle
     //
     // Parameters:
     //  v1, v2, v3 - The vertex indices forming the triangle
+    //  arena - The arena to allocate the triangle from, if any
     //
     // Creates a new triangle primitive with the corresponding vertices.
-    Triangle* _makeTriangle(size_t& v1, size_t& v2, size_t& v3, Material* mat);
-
-    ////////////////////////////////////////////////////////////////////////////
-    // Type definition
-    typedef std::vector<Face>		FaceList;
-    typedef std::vector<Vertex> VertexList;
+    Triangle* _makeTriangle(size_t v1, size_t v2, size_t v3, Material* mat,
+                            Arena* arena);
 
     Color	color_;		// The color used to render the model.
-    FaceList	faces_;		// The faces making up the model
     VertexList	vertices_;	// The list of vertices composing the model
+    IndexList	indices_;	// The vertex indices of every face, in order
+    IndexList	faceStart_;	// Offset of each face in indices_, plus the end
+    EdgeList	edges_;		// Unique edges of the faces (built by draw)
+    VertexList	drawVertices_;	// The vertices as positioned by draw
+    std::vector<Real> drawLines_;	// Clipped lines to be drawn by draw
+    std::vector<char> frontFacing_;	// Whether each face faces the viewer
   };
 }
 
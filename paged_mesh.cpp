@@ -0,0 +1,791 @@
+////////////////////////////////////////////////////////////////////////////////
+// Base: A Simple Graphics Suite
+// Author: Eric Scrivner
+//
+// Time-stamp: <Last modified 2026-10-19 13:40:12 by Eric Scrivner>
+//
+// Description:
+//   Triangle meshes stored on disk in spatially clustered chunks which are
+//   mapped into memory on demand.
+//
+//   A paged mesh file consists of a header, a table with one record per
+//   chunk and then the chunks themselves, each starting on a multiple of
+//   kChunkAlignment bytes. A chunk holds its vertices (three doubles each)
+//   followed by its triangles (three 32-bit indices into those vertices).
+//   Everything is stored in the byte order of the machine which wrote it.
+////////////////////////////////////////////////////////////////////////////////
+
+#include "matrix33.hpp"
+#include "mesh_order.hpp"
+#include "paged_mesh.hpp"
+#include "vertex_transform.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <ostream>
+#include <sstream>
+#include <stdint.h>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <unistd.h>
+using namespace std;
+
+namespace {
+  //////////////////////////////////////////////////////////////////////////////
+  // Constants
+  const char     kPagedMagic[4]  = { 'B', 'P', 'M', 'S' };
+  const uint32_t kPagedVersion   = 2;
+  const uint32_t kByteOrderMark  = 0x01020304;
+  const size_t   kChunkAlignment = 64 * 1024; // Multiple of any page size
+  const size_t   kSortBuckets    = 64; // Temporary files triangles sort through
+  const int      kBucketShift    = 57; // Leaves 6 bits of a 63-bit Morton code
+  const uint32_t kUnusedVertex   = static_cast<uint32_t>(-1); // Not in chunk
+
+  //////////////////////////////////////////////////////////////////////////////
+  // Struct: PagedHeader
+  //
+  // The header at the start of every paged mesh file
+  struct PagedHeader {
+    char     magic[4];     // Always kPagedMagic
+    uint32_t version;      // Always kPagedVersion
+    uint32_t byteOrder;    // kByteOrderMark as written by the creator
+    uint32_t reserved;     // Always zero
+    uint64_t numChunks;    // Number of records in the chunk table
+    uint64_t numTriangles; // Number of triangles in all chunks
+    uint64_t sourceSize;   // Size of the file the mesh was built from
+    int64_t  sourceMtime;  // Its modification time in ns (zero if none)
+  };
+
+  //////////////////////////////////////////////////////////////////////////////
+  // Struct: ChunkRecord
+  //
+  // The entry for a single chunk in the chunk table
+  struct ChunkRecord {
+    double   lower[3];     // Minimum corner of the chunk's bounding box
+    double   upper[3];     // Maximum corner of the chunk's bounding box
+    uint64_t offset;       // Offset of the chunk from the start of the file
+    uint64_t size;         // Size of the chunk in bytes
+    uint32_t numVertices;  // Number of vertices in the chunk
+    uint32_t numTriangles; // Number of triangles in the chunk
+  };
+
+  //////////////////////////////////////////////////////////////////////////////
+  // Function: AlignUp
+  //
+  // Rounds the given value up to a multiple of the alignment
+  size_t AlignUp(size_t value, size_t alignment) {
+    return (value + alignment - 1) / alignment * alignment;
+  }
+
+  //////////////////////////////////////////////////////////////////////////////
+  // Struct: SortRecord
+  //
+  // A triangle waiting in a temporary file to be sorted into its chunk
+  struct SortRecord {
+    uint64_t code;        // The Morton code of the triangle's centroid
+    uint64_t vertices[3]; // The indices of the triangle's vertices
+
+    bool operator < (const SortRecord& rhs) const {
+      return code < rhs.code;
+    }
+  };
+
+  //////////////////////////////////////////////////////////////////////////////
+  // Class: VertexReader
+  //
+  // Keeps the vertices of an OBJ file and counts the triangles of its faces
+  class VertexReader : public Base::ObjReader {
+  public:
+    VertexReader(Base::VertexList& vertices)
+      : numTriangles(0), vertices_(vertices)
+    { }
+
+    void vertex(const Base::Vertex& v) {
+      vertices_.push_back(v);
+    }
+
+    void face(const size_t*, const size_t& count) {
+      if (count > 2) {
+	numTriangles += count - 2;
+      }
+    }
+
+    size_t numTriangles; // The triangles of the faces read so far
+  private:
+    Base::VertexList& vertices_; // Receives the vertices
+  };
+
+  //////////////////////////////////////////////////////////////////////////////
+  // Class: TriangleBucketer
+  //
+  // Splits the faces of an OBJ file into triangles and appends each to the
+  // temporary file of the leading bits of its Morton code, in file order
+  class TriangleBucketer : public Base::ObjReader {
+  public:
+    TriangleBucketer(const Base::VertexList& vertices,
+                     const Base::Vector3& lower, const Base::Real& scale,
+                     ofstream* buckets)
+      : numTriangles(0), vertices_(vertices), lower_(lower), scale_(scale),
+        buckets_(buckets)
+    { }
+
+    void vertex(const Base::Vertex&) { }
+
+    void face(const size_t* indices, const size_t& count) {
+      for (size_t j = 1; j + 1 < count; j++) {
+	SortRecord record;
+	record.vertices[0] = indices[0];
+	record.vertices[1] = indices[j];
+	record.vertices[2] = indices[j + 1];
+
+	Base::Vector3 sum = vertices_[indices[0]] + vertices_[indices[j]] +
+	  vertices_[indices[j + 1]];
+	Base::Vector3 p = (sum - 3 * lower_) * scale_;
+	record.code = Base::MortonCode(p.x, p.y, p.z);
+
+	buckets_[record.code >> kBucketShift].write(
+	  reinterpret_cast<const char*>(&record), sizeof(record));
+	numTriangles++;
+      }
+    }
+
+    size_t numTriangles; // The triangles written so far
+  private:
+    const Base::VertexList& vertices_; // The (transformed) vertices
+    Base::Vector3           lower_;    // Minimum corner of the vertices
+    Base::Real              scale_;    // Maps 3x centroids into [0, 1]
+    ofstream*               buckets_;  // The kSortBuckets bucket files
+  };
+
+  //////////////////////////////////////////////////////////////////////////////
+  // Class: ChunkWriter
+  //
+  // Writes sorted triangles to the chunks of a paged mesh file, each chunk
+  // with its own copy of the vertices its triangles use
+  class ChunkWriter {
+  public:
+    ChunkWriter(ofstream& out, const Base::VertexList& vertices,
+                ChunkRecord* records, const size_t& numChunks,
+                const size_t& position)
+      : out_(out), vertices_(vertices), records_(records),
+        numChunks_(numChunks), numWritten_(0), position_(position),
+        local_(vertices.size(), kUnusedVertex)
+    { }
+
+    ////////////////////////////////////////////////////////////////////////////
+    // Function: write
+    //
+    // Writes the given triangles as the next chunk, returning false if the
+    // file holds no more chunks
+    bool write(const SortRecord* triangles, const size_t& count) {
+      if (numWritten_ == numChunks_) {
+	return false;
+      }
+
+      // Renumber the vertices used by the chunk's triangles
+      used_.clear();
+      chunkTriangles_.clear();
+      for (size_t i = 0; i < count; i++) {
+	for (int k = 0; k < 3; k++) {
+	  size_t v = triangles[i].vertices[k];
+	  if (local_[v] == kUnusedVertex) {
+	    local_[v] = used_.size();
+	    used_.push_back(v);
+	  }
+	  chunkTriangles_.push_back(local_[v]);
+	}
+      }
+
+      ChunkRecord& record = records_[numWritten_];
+      chunkVertices_.clear();
+      for (size_t i = 0; i < used_.size(); i++) {
+	const Base::Vertex& v = vertices_[used_[i]];
+	const double xyz[3] = { v.x, v.y, v.z };
+	for (int axis = 0; axis < 3; axis++) {
+	  if (i == 0 || xyz[axis] < record.lower[axis]) {
+	    record.lower[axis] = xyz[axis];
+	  }
+	  if (i == 0 || xyz[axis] > record.upper[axis]) {
+	    record.upper[axis] = xyz[axis];
+	  }
+	  chunkVertices_.push_back(xyz[axis]);
+	}
+	local_[used_[i]] = kUnusedVertex;
+      }
+
+      record.offset = position_;
+      record.size = chunkVertices_.size() * sizeof(double) +
+	chunkTriangles_.size() * sizeof(uint32_t);
+      record.numVertices = used_.size();
+      record.numTriangles = count;
+
+      out_.write(reinterpret_cast<const char*>(chunkVertices_.data()),
+                 chunkVertices_.size() * sizeof(double));
+      out_.write(reinterpret_cast<const char*>(chunkTriangles_.data()),
+                 chunkTriangles_.size() * sizeof(uint32_t));
+
+      // Pad the chunk out to the next boundary
+      size_t end = position_ + record.size;
+      numWritten_++;
+      position_ = (numWritten_ == numChunks_) ? end :
+	AlignUp(end, kChunkAlignment);
+      static const char kPadding[kChunkAlignment] = { 0 };
+      out_.write(kPadding, position_ - end);
+      return true;
+    }
+
+    ////////////////////////////////////////////////////////////////////////////
+    // Function: numWritten
+    //
+    // Returns the number of chunks written so far
+    size_t numWritten() const { return numWritten_; }
+  private:
+    ofstream&               out_;            // The paged mesh file
+    const Base::VertexList& vertices_;       // The vertices of the mesh
+    ChunkRecord*            records_;        // The table of chunks
+    size_t                  numChunks_;      // The number of chunks in all
+    size_t                  numWritten_;     // The chunks written so far
+    size_t                  position_;       // Where the next chunk starts
+    vector<uint32_t>        local_;          // Chunk index of each vertex
+    vector<size_t>          used_;           // The vertices of the chunk
+    vector<uint32_t>        chunkTriangles_; // The triangles of the chunk
+    vector<double>          chunkVertices_;  // The vertices of the chunk
+  };
+
+  //////////////////////////////////////////////////////////////////////////////
+  // Function: BucketName
+  //
+  // Returns the name of the given temporary bucket file of a paged mesh
+  string BucketName(const string& fileName, const size_t& bucket) {
+    ostringstream name;
+    name << fileName << ".bucket" << bucket;
+    return name.str();
+  }
+
+  //////////////////////////////////////////////////////////////////////////////
+  // Function: RemoveBuckets
+  //
+  // Closes and deletes the temporary bucket files of a paged mesh
+  void RemoveBuckets(const string& fileName, ofstream* buckets) {
+    for (size_t b = 0; b < kSortBuckets; b++) {
+      buckets[b].close();
+      remove(BucketName(fileName, b).c_str());
+    }
+  }
+
+  //////////////////////////////////////////////////////////////////////////////
+  // Function: SourceStamp
+  //
+  // Gets the size and modification time (in nanoseconds) of a file
+  bool SourceStamp(const string& fileName, uint64_t& size, int64_t& mtime) {
+    struct stat info;
+    if (stat(fileName.c_str(), &info) != 0) {
+      return false;
+    }
+
+    size = info.st_size;
+    mtime = static_cast<int64_t>(info.st_mtim.tv_sec) * 1000000000 +
+      info.st_mtim.tv_nsec;
+    return true;
+  }
+
+  //////////////////////////////////////////////////////////////////////////////
+  // Struct: ObjSource
+  //
+  // Reads the faces of a paged mesh from an OBJ file
+  struct ObjSource {
+    const string& fileName; // The OBJ file
+
+    ObjSource(const string& name)
+      : fileName(name)
+    { }
+
+    bool read(Base::ObjReader& reader) const {
+      return Base::ReadObj(fileName, reader);
+    }
+  };
+
+  //////////////////////////////////////////////////////////////////////////////
+  // Struct: ModelSource
+  //
+  // Reads the faces of a paged mesh from a model in memory
+  struct ModelSource {
+    const Base::Model& model; // The model
+
+    ModelSource(const Base::Model& m)
+      : model(m)
+    { }
+
+    bool read(Base::ObjReader& reader) const {
+      for (size_t i = 0; i < model.numVertices(); i++) {
+	reader.vertex(model.vertex(i));
+      }
+      for (size_t f = 0; f < model.numFaces(); f++) {
+	reader.face(model.faceIndices(f), model.faceSize(f));
+      }
+      return true;
+    }
+  };
+
+  //////////////////////////////////////////////////////////////////////////////
+  // Function: WritePagedMesh
+  //
+  // Parameters:
+  //   source - Passes the faces of the mesh to an ObjReader through its read
+  //   vertices - The vertices of the mesh, already transformed
+  //   numTriangles - The number of triangles in the fans of the faces
+  //   fileName - The name of the paged mesh file to create
+  //   sourceFileName - The file whose size and time the paged mesh records
+  //   trianglesPerChunk - The number of triangles stored in each chunk
+  //
+  // Writes a paged mesh file (see SavePagedMesh), reading the faces from the
+  // source once
+  template <typename Source>
+  bool WritePagedMesh(const Source& source, const Base::VertexList& vertices,
+                      const size_t& numTriangles, const string& fileName,
+                      const string& sourceFileName,
+                      const size_t& trianglesPerChunk) {
+    // Scale centroids into the unit cube for their Morton codes
+    Base::Vector3 lower(0, 0, 0), upper(0, 0, 0);
+    for (size_t i = 0; i < vertices.size(); i++) {
+      const Base::Vertex& v = vertices[i];
+      if (i == 0) {
+	lower = upper = v;
+      }
+      lower = Base::Vector3(min(lower.x, v.x), min(lower.y, v.y), min(lower.z, v.z));
+      upper = Base::Vector3(max(upper.x, v.x), max(upper.y, v.y), max(upper.z, v.z));
+    }
+    Base::Vector3 extent = upper - lower;
+    Base::Real size = max(extent.x, max(extent.y, extent.z));
+    Base::Real scale = (size > 0) ? 1 / (3 * size) : 0;
+
+    // Read the faces, spreading their triangles over the buckets
+    ofstream buckets[kSortBuckets];
+    for (size_t b = 0; b < kSortBuckets; b++) {
+      buckets[b].open(BucketName(fileName, b).c_str(),
+		      ios::out | ios::binary | ios::trunc);
+      if (!buckets[b].is_open()) {
+	RemoveBuckets(fileName, buckets);
+	return false;
+      }
+    }
+
+    TriangleBucketer bucketer(vertices, lower, scale, buckets);
+    bool bucketed = source.read(bucketer) &&
+      bucketer.numTriangles == numTriangles;
+    for (size_t b = 0; b < kSortBuckets; b++) {
+      buckets[b].close();
+      bucketed = bucketed && !buckets[b].fail();
+    }
+    if (!bucketed) {
+      RemoveBuckets(fileName, buckets);
+      return false;
+    }
+
+    // Lay out the chunk table
+    size_t numChunks = (numTriangles + trianglesPerChunk - 1) / trianglesPerChunk;
+    vector<ChunkRecord> records(numChunks);
+    memset(records.data(), 0, records.size() * sizeof(ChunkRecord));
+
+    PagedHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, kPagedMagic, sizeof(kPagedMagic));
+    header.version = kPagedVersion;
+    header.byteOrder = kByteOrderMark;
+    header.numChunks = numChunks;
+    header.numTriangles = numTriangles;
+    if (sourceFileName.length() &&
+	!SourceStamp(sourceFileName, header.sourceSize, header.sourceMtime)) {
+      RemoveBuckets(fileName, buckets);
+      return false;
+    }
+
+    string tempName = fileName + ".tmp";
+    ofstream out(tempName.c_str(), ios::out | ios::binary | ios::trunc);
+    if (!out.is_open()) {
+      RemoveBuckets(fileName, buckets);
+      return false;
+    }
+
+    // The table is written once the chunks have been measured
+    size_t tableEnd = sizeof(header) + numChunks * sizeof(ChunkRecord);
+    out.seekp(AlignUp(tableEnd, kChunkAlignment));
+    ChunkWriter writer(out, vertices, records.data(), numChunks,
+		       AlignUp(tableEnd, kChunkAlignment));
+
+    // Sort each bucket in turn (keeping triangles with equal codes in file
+    // order) and cut the triangles into chunks, which may span buckets
+    vector<SortRecord> sorted;
+    size_t pending = 0;
+    bool written = true;
+    for (size_t b = 0; b < kSortBuckets && written; b++) {
+      string bucketName = BucketName(fileName, b);
+      ifstream in(bucketName.c_str(), ios::in | ios::binary | ios::ate);
+      size_t count = in.is_open() ?
+	static_cast<size_t>(in.tellg()) / sizeof(SortRecord) : 0;
+      in.seekg(0);
+
+      // Move the triangles left over from the last bucket to the front
+      sorted.erase(sorted.begin(), sorted.end() - pending);
+      sorted.resize(pending + count);
+      in.read(reinterpret_cast<char*>(sorted.data() + pending),
+	      count * sizeof(SortRecord));
+      written = !in.fail();
+      in.close();
+      remove(bucketName.c_str());
+      stable_sort(sorted.begin() + pending, sorted.end());
+
+      size_t first = 0;
+      for (; written && sorted.size() - first >= trianglesPerChunk;
+	   first += trianglesPerChunk) {
+	written = writer.write(sorted.data() + first, trianglesPerChunk);
+      }
+      pending = sorted.size() - first;
+    }
+    if (written && pending > 0) {
+      written = writer.write(sorted.data() + sorted.size() - pending,
+                             pending);
+    }
+    RemoveBuckets(fileName, buckets);
+
+    out.seekp(0);
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char*>(records.data()),
+	      records.size() * sizeof(ChunkRecord));
+
+    out.close();
+    if (!written || writer.numWritten() != numChunks || out.fail() ||
+	rename(tempName.c_str(), fileName.c_str()) != 0) {
+      remove(tempName.c_str());
+      return false;
+    }
+
+    return true;
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool Base::SavePagedMesh(const string& objFileName,
+                         const string& fileName,
+                         const Matrix44& transformation,
+                         const size_t& trianglesPerChunk) {
+  assert(trianglesPerChunk > 0);
+
+  // Read the vertices and count the triangles
+  VertexList vertices;
+  VertexReader vertexReader(vertices);
+  if (!ReadObj(objFileName, vertexReader)) {
+    return false;
+  }
+  TransformPoints(transformation, vertices.data(), vertices.data(),
+                  vertices.size());
+
+  // Then read the faces again
+  ObjSource source(objFileName);
+  return WritePagedMesh(source, vertices, vertexReader.numTriangles,
+                        fileName, objFileName, trianglesPerChunk);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool Base::SavePagedMesh(const Model& model,
+                         const string& fileName,
+                         const string& sourceFileName,
+                         const size_t& trianglesPerChunk) {
+  assert(trianglesPerChunk > 0);
+
+  VertexList vertices(model.numVertices());
+  for (size_t i = 0; i < vertices.size(); i++) {
+    vertices[i] = model.vertex(i);
+  }
+
+  size_t numTriangles = 0;
+  for (size_t f = 0; f < model.numFaces(); f++) {
+    if (model.faceSize(f) > 2) {
+      numTriangles += model.faceSize(f) - 2;
+    }
+  }
+
+  ModelSource source(model);
+  return WritePagedMesh(source, vertices, numTriangles, fileName,
+                        sourceFileName, trianglesPerChunk);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool Base::PagedMeshIsCurrent(const string& fileName,
+                              const string& sourceFileName) {
+  PagedHeader header;
+  ifstream in(fileName.c_str(), ios::in | ios::binary);
+  if (!in.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+      memcmp(header.magic, kPagedMagic, sizeof(kPagedMagic)) != 0 ||
+      header.version != kPagedVersion ||
+      header.byteOrder != kByteOrderMark) {
+    return false;
+  }
+
+  uint64_t size;
+  int64_t mtime;
+  return SourceStamp(sourceFileName, size, mtime) &&
+    header.sourceSize == size && header.sourceMtime == mtime;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+ostream& Base::operator << (ostream& out, const PagedMeshStats& stats) {
+  out << stats.chunkVisits << " chunk visits for " << stats.rays
+      << " rays, " << stats.pageIns << " page-ins ("
+      << stats.bytesPagedIn / 1024 << " KB), " << stats.evictions
+      << " evictions, " << stats.residentBytes / 1024 << " KB resident ("
+      << stats.peakBytes / 1024 << " KB peak), " << stats.damaged
+      << " damaged chunks";
+  return out;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// PagedMesh
+
+Base::PagedMesh::PagedMesh(Material* mat, const size_t& residentLimit)
+  : Primitive(mat), fd_(-1), pageSize_(sysconf(_SC_PAGESIZE)),
+    residentLimit_(residentLimit), numTriangles_(0)
+{ }
+
+////////////////////////////////////////////////////////////////////////////////
+
+Base::PagedMesh::~PagedMesh() {
+  close();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool Base::PagedMesh::open(const string& fileName) {
+  close();
+
+  int fd = ::open(fileName.c_str(), O_RDONLY);
+  if (fd < 0) {
+    return false;
+  }
+
+  // Read and check the header
+  PagedHeader header;
+  if (pread(fd, &header, sizeof(header), 0) != sizeof(header) ||
+      memcmp(header.magic, kPagedMagic, sizeof(kPagedMagic)) != 0 ||
+      header.version != kPagedVersion ||
+      header.byteOrder != kByteOrderMark) {
+    ::close(fd);
+    return false;
+  }
+
+  // Followed by the chunk table
+  vector<ChunkRecord> records(header.numChunks);
+  ssize_t tableSize = records.size() * sizeof(ChunkRecord);
+  if (pread(fd, records.data(), tableSize, sizeof(header)) != tableSize) {
+    ::close(fd);
+    return false;
+  }
+
+  off_t fileSize = lseek(fd, 0, SEEK_END);
+  chunks_.resize(records.size());
+  vector<Real> bounds;
+  bounds.reserve(6 * records.size());
+  for (size_t i = 0; i < records.size(); i++) {
+    const ChunkRecord& record = records[i];
+    size_t expected = record.numVertices * 3 * sizeof(double) +
+      record.numTriangles * 3 * sizeof(uint32_t);
+    if (record.size != expected || record.offset % kChunkAlignment != 0 ||
+        record.offset + record.size > static_cast<uint64_t>(fileSize)) {
+      chunks_.clear();
+      ::close(fd);
+      return false;
+    }
+
+    Chunk& chunk = chunks_[i];
+    chunk.offset = record.offset;
+    chunk.size = record.size;
+    chunk.numVertices = record.numVertices;
+    chunk.numTriangles = record.numTriangles;
+    chunk.checked = false;
+    chunk.damaged = false;
+    chunk.mapping = 0;
+    chunk.mappingSize = 0;
+    chunk.data = 0;
+    chunk.lru = lru_.end();
+
+    bounds.insert(bounds.end(), record.lower, record.lower + 3);
+    bounds.insert(bounds.end(), record.upper, record.upper + 3);
+  }
+
+  // The chunks were written in Morton order, so neighbours are close
+  hierarchy_.build(bounds);
+  fd_ = fd;
+  numTriangles_ = header.numTriangles;
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void Base::PagedMesh::close() {
+  while (!lru_.empty()) {
+    _evict(lru_.back());
+  }
+  chunks_.clear();
+  hierarchy_.clear();
+  numTriangles_ = 0;
+
+  if (fd_ >= 0) {
+    ::close(fd_);
+    fd_ = -1;
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+const char* Base::PagedMesh::_acquire(size_t index) {
+  Chunk& chunk = chunks_[index];
+
+  // Already resident, so just mark it as the most recently used
+  if (chunk.data != 0) {
+    lru_.splice(lru_.begin(), lru_, chunk.lru);
+    return chunk.data;
+  }
+  if (chunk.damaged) {
+    return 0;
+  }
+
+  // Make room for the chunk, but always allow at least one to be resident
+  size_t start = chunk.offset / pageSize_ * pageSize_;
+  size_t length = chunk.offset + chunk.size - start;
+  while (!lru_.empty() && stats_.residentBytes + length > residentLimit_) {
+    _evict(lru_.back());
+    stats_.evictions++;
+  }
+
+  void* mapping = mmap(0, length, PROT_READ, MAP_PRIVATE, fd_, start);
+  if (mapping == MAP_FAILED) {
+    return 0;
+  }
+
+  // The whole chunk is about to be read
+  madvise(mapping, length, MADV_WILLNEED);
+  const char* data = static_cast<const char*>(mapping) + (chunk.offset - start);
+
+  // Triangles are intersected straight from the mapping, so a damaged file
+  // must not hand out indices outside the chunk's vertices
+  if (!chunk.checked) {
+    const uint32_t* triangles = reinterpret_cast<const uint32_t*>(
+      data + chunk.numVertices * 3 * sizeof(double));
+    for (size_t i = 0; i < 3 * chunk.numTriangles; i++) {
+      if (triangles[i] >= chunk.numVertices) {
+	munmap(mapping, length);
+	chunk.damaged = true;
+	stats_.damaged++;
+	return 0;
+      }
+    }
+    chunk.checked = true;
+  }
+
+  chunk.mapping = mapping;
+  chunk.mappingSize = length;
+  chunk.data = data;
+  lru_.push_front(index);
+  chunk.lru = lru_.begin();
+
+  stats_.pageIns++;
+  stats_.bytesPagedIn += length;
+  stats_.residentBytes += length;
+  stats_.peakBytes = max(stats_.peakBytes, stats_.residentBytes);
+  return chunk.data;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void Base::PagedMesh::_evict(size_t index) {
+  Chunk& chunk = chunks_[index];
+  assert(chunk.mapping != 0);
+
+  munmap(chunk.mapping, chunk.mappingSize);
+  stats_.residentBytes -= chunk.mappingSize;
+  lru_.erase(chunk.lru);
+
+  chunk.mapping = 0;
+  chunk.mappingSize = 0;
+  chunk.data = 0;
+  chunk.lru = lru_.end();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool Base::PagedMesh::intersection(const Ray& ray, Hit& hit, Real tmin) {
+  stats_.rays++;
+  return hierarchy_.intersect(ray, hit, tmin, [&](size_t chunk) {
+    return _intersectChunk(ray, hit, tmin, chunk);
+  });
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool Base::PagedMesh::_intersectChunk(const Ray& ray, Hit& hit, Real tmin,
+                                      const size_t& index) {
+  const char* data = _acquire(index);
+  if (data == 0) {
+    return false;
+  }
+  stats_.chunkVisits++;
+
+  const Chunk& chunk = chunks_[index];
+  const double* vertices = reinterpret_cast<const double*>(data);
+  const uint32_t* triangles = reinterpret_cast<const uint32_t*>(
+    data + chunk.numVertices * 3 * sizeof(double));
+  const Vector3& d = ray.direction;
+
+  // Find the closest triangle hit with the same arithmetic as
+  // Triangle::intersection, and only work out its normal at the end
+  Real closest = hit.getDistance();
+  Vector3 closestEb(0, 0, 0), closestEc(0, 0, 0);
+  bool found = false;
+  for (size_t t = 0; t < chunk.numTriangles; t++) {
+    const double* a = vertices + 3 * triangles[3 * t];
+    const double* b = vertices + 3 * triangles[3 * t + 1];
+    const double* c = vertices + 3 * triangles[3 * t + 2];
+
+    Vector3 v1(a[0], a[1], a[2]);
+    Vector3 Eb = Vector3(b[0], b[1], b[2]) - v1;
+    Vector3 Ec = Vector3(c[0], c[1], c[2]) - v1;
+    Vector3 nb = -Eb;
+    Vector3 nc = -Ec;
+
+    Real detA = Determinant(nb, nc, d);
+    if (detA == 0) {
+      continue;
+    }
+
+    Vector3 Ea = v1 - ray.origin;
+    Real dist = Determinant(nb, nc, Ea) / detA;
+    if (!(dist >= tmin && dist <= closest)) {
+      continue;
+    }
+
+    Real beta = Determinant(Ea, nc, d) / detA;
+    Real gamma = Determinant(nb, Ea, d) / detA;
+    if (beta >= 0 && gamma >= 0 && beta + gamma < 1.0) {
+      closest = dist;
+      closestEb = Eb;
+      closestEc = Ec;
+      found = true;
+    }
+  }
+
+  if (!found) {
+    return false;
+  }
+
+  hit.setDistance(closest);
+  hit.setMaterial(material);
+  hit.setNormal(-(closestEb.crossProduct(closestEc).normalize()));
+  return true;
+}
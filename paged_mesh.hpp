@@ -0,0 +1,224 @@
+////////////////////////////////////////////////////////////////////////////////
+// Base: A Simple Graphics Suite
+// Author: Eric Scrivner
+//
+// Time-stamp: <Last modified 2026-10-19 13:40:12 by Eric Scrivner>
+//
+// Description:
+//   Triangle meshes stored on disk in spatially clustered chunks which are
+//   mapped into memory on demand.
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef PAGED_MESH_HPP__
+#define PAGED_MESH_HPP__
+
+#include "bvh.hpp"
+#include "matrix44.hpp"
+#include "model.hpp"
+#include "primitive.hpp"
+
+#include <iosfwd>
+#include <list>
+#include <string>
+#include <vector>
+
+namespace Base {
+  //////////////////////////////////////////////////////////////////////////////
+  // Function: SavePagedMesh
+  //
+  // Parameters:
+  //   objFileName - The OBJ file whose faces are to be written
+  //   fileName - The name of the paged mesh file to create
+  //   transformation - The transformation applied to the vertices
+  //   trianglesPerChunk - The number of triangles stored in each chunk
+  //
+  // Writes the faces of an OBJ file (split into fans of triangles), as they
+  // are in the file, to a paged mesh file, recording the size and
+  // modification time of the OBJ file. Triangles are sorted along a Morton
+  // curve and cut into chunks of neighbouring triangles, each with its own
+  // vertices and bounding box and starting on a page boundary. Returns true
+  // if the file was written.
+  //
+  // The OBJ file is read twice (see ReadObj) and its faces are never all in
+  // memory: the triangles are spread over temporary files next to fileName
+  // by the leading bits of their Morton codes, and each of these is then
+  // sorted on its own. Only the vertices, four bytes more per vertex and the
+  // triangles of the largest of these files are held at once.
+  bool SavePagedMesh(const std::string& objFileName,
+                     const std::string& fileName,
+                     const Matrix44& transformation,
+                     const size_t& trianglesPerChunk = 4096);
+
+  //////////////////////////////////////////////////////////////////////////////
+  // Function: SavePagedMesh
+  //
+  // Parameters:
+  //   model - The model to be written, as it is to be traced
+  //   fileName - The name of the paged mesh file to create
+  //   sourceFileName - The file the model was loaded from, if any
+  //   trianglesPerChunk - The number of triangles stored in each chunk
+  //
+  // Writes the faces of a model in memory to a paged mesh file as above,
+  // so a model which has been cleaned up (see CleanupMesh) or otherwise
+  // changed after loading is paged as it is. Returns true if the file was
+  // written.
+  bool SavePagedMesh(const Model& model,
+                     const std::string& fileName,
+                     const std::string& sourceFileName = std::string(),
+                     const size_t& trianglesPerChunk = 4096);
+
+  //////////////////////////////////////////////////////////////////////////////
+  // Function: PagedMeshIsCurrent
+  //
+  // Returns true if the given paged mesh file exists and was written (by
+  // this version, on a machine of the same layout) from the given source
+  // file with its present size and modification time. Paged meshes are
+  // saved with whatever transformation or cleanup their callers applied,
+  // which is not recorded, so callers must only reuse files they wrote the
+  // same way.
+  bool PagedMeshIsCurrent(const std::string& fileName,
+                          const std::string& sourceFileName);
+
+  //////////////////////////////////////////////////////////////////////////////
+  // Struct: PagedMeshStats
+  //
+  // Counts of the paging done by a PagedMesh.
+  struct PagedMeshStats {
+    size_t rays;          // Rays intersected with the mesh
+    size_t chunkVisits;   // Chunks whose triangles were tested against a ray
+    size_t pageIns;       // Chunks mapped into memory
+    size_t evictions;     // Chunks unmapped to stay under the limit
+    size_t bytesPagedIn;  // Total size of all the chunks mapped
+    size_t residentBytes; // Size of the chunks currently mapped
+    size_t peakBytes;     // Largest value residentBytes has had
+    size_t damaged;       // Chunks skipped for holding a bad vertex index
+
+    PagedMeshStats()
+      : rays(0), chunkVisits(0), pageIns(0), evictions(0),
+        bytesPagedIn(0), residentBytes(0), peakBytes(0), damaged(0)
+    { }
+  };
+
+  //////////////////////////////////////////////////////////////////////////////
+  // Function: operator <<
+  //
+  // Writes a one line summary of the given statistics to a stream
+  std::ostream& operator << (std::ostream& out, const PagedMeshStats& stats);
+
+  //////////////////////////////////////////////////////////////////////////////
+  // Class: PagedMesh
+  //
+  // A triangle mesh primitive backed by a file written with SavePagedMesh.
+  // Only a hierarchy over the chunk bounding boxes is kept in memory, built
+  // over the chunks in their Morton order when the file is opened. Chunks
+  // hit by a
+  // ray are mapped in when first needed and the least recently used chunks
+  // are unmapped whenever the mapped total would exceed the resident limit,
+  // so memory use is bounded by the working set rather than the mesh size.
+  // The first time a chunk is mapped every vertex index of its triangles is
+  // checked, and a chunk with an index outside its vertices (as a damaged
+  // file may have) is never intersected and is counted in the statistics.
+  // Not safe to intersect from several threads at once.
+  class PagedMesh : public Primitive {
+  public:
+    ////////////////////////////////////////////////////////////////////////////
+    // Function: PagedMesh
+    //
+    // Parameters:
+    //   mat - The material of the mesh
+    //   residentLimit - The most chunk data, in bytes, to keep mapped
+    PagedMesh(Material* mat, const size_t& residentLimit = 256 << 20);
+
+    ~PagedMesh();
+
+    ////////////////////////////////////////////////////////////////////////////
+    // Function: open
+    //
+    // Parameters:
+    //   fileName - The name of a paged mesh file
+    //
+    // Reads the chunk table of the given file, returning false if the file
+    // could not be opened or is not a valid paged mesh.
+    bool open(const std::string& fileName);
+
+    ////////////////////////////////////////////////////////////////////////////
+    // Function: close
+    //
+    // Unmaps all chunks and closes the file
+    void close();
+
+    ////////////////////////////////////////////////////////////////////////////
+    // Function: intersection
+    //
+    // Computes the closest intersection with the triangles of the mesh,
+    // descending the hierarchy of chunks nearest side first and skipping
+    // those beyond the closest hit. Triangles are intersected in place in
+    // the mapped chunk, with the same arithmetic as Triangle::intersection.
+    bool intersection(const Ray& ray, Hit& hit, Real tmin);
+
+    ////////////////////////////////////////////////////////////////////////////
+    // Function: numChunks
+    //
+    // Returns the number of chunks in the mesh
+    size_t numChunks() const { return chunks_.size(); }
+
+    ////////////////////////////////////////////////////////////////////////////
+    // Function: numTriangles
+    //
+    // Returns the number of triangles in the mesh
+    size_t numTriangles() const { return numTriangles_; }
+
+    ////////////////////////////////////////////////////////////////////////////
+    // Function: stats
+    //
+    // Returns the paging statistics
+    const PagedMeshStats& stats() const { return stats_; }
+  private:
+    ////////////////////////////////////////////////////////////////////////////
+    // Struct: Chunk
+    //
+    // The in-memory record of a chunk of the mesh
+    struct Chunk {
+      size_t  offset, size;   // The location of the chunk in the file
+      size_t  numVertices;    // The number of vertices in the chunk
+      size_t  numTriangles;   // The number of triangles in the chunk
+      bool    checked;        // Whether its indices have been checked
+      bool    damaged;        // Whether it has an index outside the chunk
+      void*   mapping;        // The mapping of the chunk, if resident
+      size_t  mappingSize;    // The length of the mapping
+      const char* data;       // The first byte of the chunk in the mapping
+      std::list<size_t>::iterator lru; // Position in the recently used list
+    };
+
+    PagedMesh(const PagedMesh&);
+    PagedMesh& operator = (const PagedMesh&);
+
+    ////////////////////////////////////////////////////////////////////////////
+    // Function: _intersectChunk
+    //
+    // Intersects the ray with the triangles of one chunk, mapping it in if
+    // necessary
+    bool _intersectChunk(const Ray& ray, Hit& hit, Real tmin,
+                         const size_t& index);
+
+    ////////////////////////////////////////////////////////////////////////////
+    // Function: _acquire
+    //
+    // Maps the given chunk in if it is not resident, checking its indices
+    // the first time, and returns its first byte, or 0 if it could not be
+    // mapped or is damaged
+    const char* _acquire(size_t index);
+    void _evict(size_t index);
+
+    int                      fd_;            // The open paged mesh file
+    size_t                   pageSize_;      // Granularity of mappings
+    size_t                   residentLimit_; // Byte limit on mapped chunks
+    size_t                   numTriangles_;  // Triangles in all chunks
+    std::vector<Chunk>       chunks_;        // The table of chunks
+    Bvh<Real>                hierarchy_;     // Hierarchy over chunk bounds
+    std::list<size_t>        lru_;           // Mapped chunks, most recent first
+    PagedMeshStats           stats_;         // Paging statistics
+  };
+}
+
+#endif // PAGED_MESH_HPP__
@@ -11,11 +11,88 @@
 
 #include "plot.hpp"
 
+#include <vector>
+
+namespace {
+  //////////////////////////////////////////////////////////////////////////////
+  // Class: PlotBatch
+  //
+  // Vertices of a single primitive type waiting to be drawn, kept in client
+  // side vertex and color arrays.
+  class PlotBatch {
+  public:
+    PlotBatch()
+      : mode_(GL_POINTS)
+    { }
+
+    ////////////////////////////////////////////////////////////////////////////
+    // Function: prepare
+    //
+    // Flushes the batch if it is of another primitive type or does not have
+    // room for count more vertices, and sets its primitive type.
+    void prepare(GLenum mode, size_t count) {
+      if (mode != mode_ || numVertices() + count > kMaxVertices) {
+	flush();
+      }
+      mode_ = mode;
+    }
+
+    void add(const Base::Real& x, const Base::Real& y,
+             const Base::Color& color) {
+      positions_.push_back(x);
+      positions_.push_back(y);
+      colors_.push_back(color.r);
+      colors_.push_back(color.g);
+      colors_.push_back(color.b);
+    }
+
+    ////////////////////////////////////////////////////////////////////////////
+    // Function: flush
+    //
+    // Draws and empties the batch
+    void flush() {
+      if (positions_.empty()) {
+	return;
+      }
+
+      glEnableClientState(GL_VERTEX_ARRAY);
+      glEnableClientState(GL_COLOR_ARRAY);
+      glVertexPointer(2, GL_FLOAT, 0, &positions_[0]);
+      glColorPointer(3, GL_FLOAT, 0, &colors_[0]);
+      glDrawArrays(mode_, 0, numVertices());
+      glDisableClientState(GL_COLOR_ARRAY);
+      glDisableClientState(GL_VERTEX_ARRAY);
+
+      positions_.clear();
+      colors_.clear();
+    }
+  private:
+    static const size_t kMaxVertices = 64 * 1024; // Vertices per draw call
+
+    size_t numVertices() const { return positions_.size() / 2; }
+
+    GLenum               mode_;      // The primitive type of the batch
+    std::vector<GLfloat> positions_; // The x and y of each vertex
+    std::vector<GLfloat> colors_;    // The red, green and blue of each vertex
+  };
+
+  //////////////////////////////////////////////////////////////////////////////
+  // Function: Batch
+  //
+  // Returns the pending batch, ready to take count vertices of the given
+  // primitive type.
+  PlotBatch& Batch(GLenum mode, size_t count) {
+    static PlotBatch batch;
+    if (count > 0) {
+      batch.prepare(mode, count);
+    }
+    return batch;
+  }
+}
+
 void Base::Plot(const int& x, const int& y, const Base::Color& color) {
-  glBegin(GL_POINTS);
-  glColor3f(color.r, color.g, color.b);
-  glVertex2i(x, y);
-  glEnd();
+  PlotBatch& batch = Batch(GL_POINTS, 1);
+  batch.add(x, y, color);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -23,4 +100,20 @@ void Base::Plot(const int& x, const int& y, const Base::Color& color) {
 void Base::Plot(const int& x, const int& y) {
   Plot(x, y, Color::White);
 }
-	
+
+////////////////////////////////////////////////////////////////////////////////
+
+void Base::PlotLine(const Real& x1, const Real& y1,
+                    const Real& x2, const Real& y2,
+                    const Color& color) {
+  PlotBatch& batch = Batch(GL_LINES, 2);
+  batch.add(x1, y1, color);
+  batch.add(x2, y2, color);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void Base::FlushPlots() {
+  PlotBatch& batch = Batch(GL_POINTS, 0);
+  batch.flush();
+}
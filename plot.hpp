@@ -35,6 +35,33 @@ namespace Base {
   //
   // Plots a single point at the given coordinates on the screen
   void Plot(const int& x, const int& y);
+
+  //////////////////////////////////////////////////////////////////////////////
+  // Function: PlotLine
+  //
+  // Parameters:
+  //   x1, y1 - The coordinates of the start of the line
+  //   x2, y2 - The coordinates of the end of the line
+  //   color - The color of the line
+  //
+  // Draws a line segment of the given color on the screen, rasterized by
+  // OpenGL rather than by one of the algorithms of DrawLine, so its pixels
+  // may differ from theirs
+  void PlotLine(const Real& x1, const Real& y1,
+                const Real& x2, const Real& y2,
+                const Color& color);
+
+  //////////////////////////////////////////////////////////////////////////////
+  // Function: FlushPlots
+  //
+  // Points and lines are not drawn immediately but collected into vertex
+  // arrays, which are submitted with a single glDrawArrays when full, when
+  // switching between points and lines, or when this is called. Must be
+  // called before anything else is drawn with OpenGL directly (as
+  // Image::draw does), so that it is drawn over the points and lines plotted
+  // before it, and once drawing is finished and before the frame is swapped
+  // onto the screen.
+  void FlushPlots();
 }
 
 #endif // PLOT_HPP__
@@ -10,6 +10,8 @@
 #ifndef PRIMITIVE_HPP__
 #define PRIMITIVE_HPP__
 
+#include "arena.hpp"
+#include "fast_math.hpp"
 #include "hit.hpp"
 #include "ray.hpp"
 #include "vector3.hpp"
@@ -56,37 +58,98 @@ namespace Base {
   //////////////////////////////////////////////////////////////////////////////
   // Class: Group
   //
-  // Represents a group of primitive objects
+  // Represents a group of primitive objects. A group deletes the primitives
+  // added to it, except for those allocated from its arena (if it has one),
+  // which are left for the arena to release.
   class Group : public Primitive {
   public:
-    Group()
-      : Primitive(0)
+    ////////////////////////////////////////////////////////////////////////////
+    // Function: Group
+    //
+    // Parameters:
+    //   arena - The arena from which the group's primitives may be allocated
+    Group(Arena* arena = 0)
+      : Primitive(0), version_(0), parent_(0), arena_(arena)
     { }
 
     ~Group() {
       for (std::vector<Primitive*>::iterator it = primitives_.begin();
 	   it != primitives_.end(); it++) {
-	delete *it;
+	if (arena_ == 0 || !arena_->owns(*it)) {
+	  delete *it;
+	}
       }
       primitives_.clear();
     }
     ////////////////////////////////////////////////////////////////////////////
     // Function: addPrimitive
     //
-    // Adds a primitive to this primitive group
+    // Adds a primitive to this primitive group. A group added to another
+    // passes its changes on to it (see version).
     void addPrimitive(Primitive* p) {
       primitives_.push_back(p);
+      if (Group* group = dynamic_cast<Group*>(p)) {
+	group->parent_ = this;
+      }
+      markChanged();
+    }
+
+    ////////////////////////////////////////////////////////////////////////////
+    // Function: markChanged
+    //
+    // Changes the version of this group and of the groups containing it. To
+    // be called after a primitive within the group is changed in place (such
+    // as by moving it), which the group cannot see for itself.
+    void markChanged() {
+      for (Group* group = this; group != 0; group = group->parent_) {
+	group->version_++;
+      }
+    }
+
+    ////////////////////////////////////////////////////////////////////////////
+    // Function: reserve
+    //
+    // Reserves space for the given number of primitives
+    void reserve(const size_t& count) {
+      primitives_.reserve(count);
+    }
+
+    ////////////////////////////////////////////////////////////////////////////
+    // Function: numPrimitives
+    //
+    // Returns the number of primitives directly in this group
+    size_t numPrimitives() const { return primitives_.size(); }
+
+    ////////////////////////////////////////////////////////////////////////////
+    // Function: getPrimitive
+    //
+    // Returns the primitive at the given index
+    Primitive* getPrimitive(const size_t& index) const {
+      assert(index < numPrimitives());
+      return primitives_[index];
     }
 
+    ////////////////////////////////////////////////////////////////////////////
+    // Function: version
+    //
+    // Returns a number which changes whenever a primitive is added to this
+    // group or to a group within it, or markChanged is called on either, so
+    // that compiled copies of the group can tell when they are out of date.
+    // A group within several others only passes its changes on to the one it
+    // was added to last.
+    size_t version() const { return version_; }
+
     ////////////////////////////////////////////////////////////////////////////
     // Function: intersection
     //
-    // Computes the closest intersecting primitive in this group
+    // Computes the closest intersecting primitive in this group, setting the
+    // element of the hit to the index of the primitive in the group
     bool intersection(const Ray& ray, Hit& hit, Real tmin) {
       bool didHit = false;
 
       for (size_t i = 0; i < primitives_.size(); i++) {
 	if (primitives_[i]->intersection(ray, hit, tmin)) {
+	  hit.setElement(i);
 	  didHit = true;
 	}
       }
@@ -95,6 +158,9 @@ namespace Base {
     }
   private:
     std::vector<Primitive*> primitives_; // The internal primitives
+    size_t                  version_;    // Changed by every addPrimitive
+    Group*                  parent_;     // The group this was last added to
+    Arena*                  arena_;      // The arena of the primitives, if any
   };
 
   //////////////////////////////////////////////////////////////////////////////
@@ -106,7 +172,8 @@ namespace Base {
     Sphere(const Vector3& center,
            Real radius,
            Material* mat)
-      : Primitive(mat), center_(center), radius_(radius)
+      : Primitive(mat), center_(center), radius_(radius),
+        radius2_(radius * radius)
     { }
 
     ////////////////////////////////////////////////////////////////////////////
@@ -126,9 +193,10 @@ namespace Base {
 	return false;
       }
 
-      // Compute the discriminant
-      Real discTmp = (co - (co.dotProduct(ray.direction) * ray.direction)).magnitude();
-      Real disc = pow(radius_, 2) - pow(discTmp, 2);
+      // Compute the discriminant from the squared distance of the center
+      // from the ray
+      Vector3 perpendicular = co - (rayCos * ray.direction);
+      Real disc = radius2_ - perpendicular.dotProduct(perpendicular);
       
       // Now we must ensure that we have two real solutions to this equation.
       // If the discriminant is less than zero we know we have two imagniary
@@ -141,10 +209,11 @@ namespace Base {
 	// the case of a ray originating inside a sphere. To do this we check
 	// for one negative and one positive solution, in this case we take the
 	// positive solution, otherwise we take the minimum of the two solutions
-	if (rayCos - sqrt(disc) < 0) {
-	  distance = rayCos + sqrt(disc);
+	Real root = sqrt(disc);
+	if (rayCos - root < 0) {
+	  distance = rayCos + root;
 	} else {
-	  distance = std::min(rayCos + sqrt(disc), rayCos - sqrt(disc));
+	  distance = rayCos - root;
 	}
 
 	// If the distance was positive and closer than the closest hit
@@ -154,7 +223,7 @@ namespace Base {
 	  
 	  // Fill in the hit information and indicate an intersection
 	  hit.setDistance(distance);
-	  hit.setNormal(normal.normalize());
+	  hit.setNormal(Normalize(normal, GetPrecision()).toVector3());
 	  hit.setMaterial(material);
 
 	  return true;
@@ -163,9 +232,22 @@ namespace Base {
 
       return false;
     }
+
+    ////////////////////////////////////////////////////////////////////////////
+    // Function: getCenter
+    //
+    // Returns the center of the sphere
+    const Vector3& getCenter() const { return center_; }
+
+    ////////////////////////////////////////////////////////////////////////////
+    // Function: getRadius
+    //
+    // Returns the radius of the sphere
+    Real getRadius() const { return radius_; }
   private:
     Vector3 center_;
     Real    radius_;
+    Real    radius2_; // The squared radius
   };
 
   //////////////////////////////////////////////////////////////////////////////
@@ -203,6 +285,18 @@ namespace Base {
 
       return false;
     }
+
+    ////////////////////////////////////////////////////////////////////////////
+    // Function: getNormal
+    //
+    // Returns the normal of the plane
+    const Vector3& getNormal() const { return normal_; }
+
+    ////////////////////////////////////////////////////////////////////////////
+    // Function: getOffset
+    //
+    // Returns the offset of the plane from the origin
+    Real getOffset() const { return offset_; }
   private:
     Vector3 normal_; // The normal of the plane
     Real offset_; // The offset from the origin
@@ -269,9 +363,33 @@ namespace Base {
 
       return false;
     }
+
+    ////////////////////////////////////////////////////////////////////////////
+    // Function: getVertex
+    //
+    // Returns the given vertex (0, 1 or 2) of the triangle
+    const Vector3& getVertex(const int& index) const {
+      assert(index >= 0 && index < 3);
+      return (index == 0) ? v1_ : ((index == 1) ? v2_ : v3_);
+    }
   private:
     Vector3 v1_, v2_, v3_; // The vertices of this triangle
   };
+
+  //////////////////////////////////////////////////////////////////////////////
+  // Planes, spheres and triangles hold no resources, so arenas need not run
+  // their destructors
+  template <> struct ArenaDestroys<Plane> {
+    static const bool value = false;
+  };
+
+  template <> struct ArenaDestroys<Sphere> {
+    static const bool value = false;
+  };
+
+  template <> struct ArenaDestroys<Triangle> {
+    static const bool value = false;
+  };
 }
 
 #endif // PRIMITIVE_HPP__
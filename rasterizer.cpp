@@ -0,0 +1,446 @@
+////////////////////////////////////////////////////////////////////////////////
+// Base: A Simple Graphics Suite
+// Author: Eric Scrivner
+//
+// Time-stamp: <Last modified 2026-10-19 15:34:08 by Eric Scrivner>
+//
+// Description:
+//   Software rasterizer producing shaded previews of models.
+////////////////////////////////////////////////////////////////////////////////
+
+#include "camera.hpp"
+#include "image.hpp"
+#include "model.hpp"
+#include "rasterizer.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <ostream>
+#include <stdint.h>
+#include <thread>
+#include <vector>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+using namespace std;
+
+namespace {
+  //////////////////////////////////////////////////////////////////////////////
+  // Constants
+  const int      kTileShift = 6;               // Tiles are 64x64 pixels
+  const int      kTileSize  = 1 << kTileShift;
+  const uint32_t kNoTriangle = 0xFFFFFFFF;     // Marks uncovered pixels
+
+  //////////////////////////////////////////////////////////////////////////////
+  // Struct: ScreenVertex
+  //
+  // A vertex projected onto the image
+  struct ScreenVertex {
+    float x, y;    // The position in pixels
+    float invZ;    // One over the depth of the vertex
+    bool  visible; // False if the vertex is behind the camera
+  };
+
+  //////////////////////////////////////////////////////////////////////////////
+  // Struct: TriangleSetup
+  //
+  // A triangle prepared for rasterization. Each edge function is a*x + b*y + c
+  // and is positive inside the triangle; pixels exactly on an edge are only
+  // inside if the edge is a top or left edge. The inverse depth is a plane
+  // over the screen in the same way.
+  struct TriangleSetup {
+    float       a[3], b[3], c[3];   // The edge functions
+    bool        inclusive[3];       // Whether each edge owns pixels on it
+    float       zA, zB, zC;         // The inverse depth plane
+    int         minX, minY;         // The first pixel of the bounding box
+    int         maxX, maxY;         // The last pixel of the bounding box
+    bool        valid;              // False if the triangle was dropped
+    Base::Color color;              // The flat shaded color
+  };
+
+  //////////////////////////////////////////////////////////////////////////////
+  // Typedefs
+  typedef vector<uint32_t> BinT;          // Triangles overlapping one tile
+  typedef vector<BinT>     BinListT;      // One bin per tile
+
+  //////////////////////////////////////////////////////////////////////////////
+  // Function: RunThreads
+  //
+  // Calls body(i) for i in [0, count), each on its own thread except the
+  // first which runs on the calling thread, and waits for them all.
+  template <typename Body>
+  void RunThreads(const size_t& count, const Body& body) {
+    vector<std::thread> workers;
+    for (size_t i = 1; i < count; i++) {
+      workers.push_back(std::thread(body, i));
+    }
+
+    body(0);
+
+    for (size_t i = 0; i < workers.size(); i++) {
+      workers[i].join();
+    }
+  }
+
+  //////////////////////////////////////////////////////////////////////////////
+  // Function: SetupEdge
+  //
+  // Sets up the edge function for the edge from p to q, positive on its left.
+  // Both triangles sharing an edge compute it from the same endpoint (the one
+  // with the lower index), so their functions are exact negatives of one
+  // another and every pixel on the edge is drawn exactly once.
+  void SetupEdge(const ScreenVertex* vertices, size_t p, size_t q,
+                 TriangleSetup& setup, int edge) {
+    bool flipped = q < p;
+    const ScreenVertex& from = vertices[flipped ? q : p];
+    const ScreenVertex& to = vertices[flipped ? p : q];
+
+    float dx = to.x - from.x;
+    float dy = to.y - from.y;
+    float a = -dy;
+    float b = dx;
+    float c = dy * from.x - dx * from.y;
+    if (flipped) {
+      a = -a;
+      b = -b;
+      c = -c;
+      dx = -dx;
+      dy = -dy;
+    }
+
+    setup.a[edge] = a;
+    setup.b[edge] = b;
+    setup.c[edge] = c;
+
+    // With y up and counter-clockwise winding, left edges run downwards and
+    // top edges run leftwards
+    setup.inclusive[edge] = (dy < 0) || (dy == 0 && dx < 0);
+  }
+
+  //////////////////////////////////////////////////////////////////////////////
+  // Function: SetupTriangle
+  //
+  // Prepares the triangle with the given vertex indices, returning false if
+  // it is not drawn. The reason is counted in stats.
+  bool SetupTriangle(const Base::Model& model,
+                     const ScreenVertex* vertices,
+                     size_t i0, size_t i1, size_t i2,
+                     const Base::Vector3& eye,
+                     const Base::RasterOptions& options,
+                     int width, int height,
+                     TriangleSetup& setup,
+                     Base::RasterStats& stats) {
+    setup.valid = false;
+
+    const ScreenVertex& v0 = vertices[i0];
+    if (!v0.visible || !vertices[i1].visible || !vertices[i2].visible) {
+      stats.nearClipped++;
+      return false;
+    }
+
+    // Ensure the triangle is counter-clockwise on screen
+    double area = (double(vertices[i1].x) - v0.x) * (vertices[i2].y - v0.y) -
+      (double(vertices[i2].x) - v0.x) * (vertices[i1].y - v0.y);
+    if (area == 0 || (area < 0 && options.cullBackFaces)) {
+      stats.culled++;
+      return false;
+    }
+    if (area < 0) {
+      std::swap(i1, i2);
+      area = -area;
+    }
+    const ScreenVertex& v1 = vertices[i1];
+    const ScreenVertex& v2 = vertices[i2];
+
+    // Find the pixels the triangle may cover
+    float minX = min(v0.x, min(v1.x, v2.x));
+    float maxX = max(v0.x, max(v1.x, v2.x));
+    float minY = min(v0.y, min(v1.y, v2.y));
+    float maxY = max(v0.y, max(v1.y, v2.y));
+    setup.minX = max(0, static_cast<int>(ceil(minX)));
+    setup.minY = max(0, static_cast<int>(ceil(minY)));
+    setup.maxX = min(width - 1, static_cast<int>(floor(maxX)));
+    setup.maxY = min(height - 1, static_cast<int>(floor(maxY)));
+    if (setup.minX > setup.maxX || setup.minY > setup.maxY) {
+      stats.culled++;
+      return false;
+    }
+
+    // The edge opposite each vertex
+    SetupEdge(vertices, i1, i2, setup, 0);
+    SetupEdge(vertices, i2, i0, setup, 1);
+    SetupEdge(vertices, i0, i1, setup, 2);
+
+    // The edge functions sum to the doubled area, so dividing them by it
+    // gives barycentric coordinates
+    double zScale = 1 / area;
+    setup.zA = (setup.a[0] * v0.invZ + setup.a[1] * v1.invZ +
+                setup.a[2] * v2.invZ) * zScale;
+    setup.zB = (setup.b[0] * v0.invZ + setup.b[1] * v1.invZ +
+                setup.b[2] * v2.invZ) * zScale;
+    setup.zC = (setup.c[0] * v0.invZ + setup.c[1] * v1.invZ +
+                setup.c[2] * v2.invZ) * zScale;
+
+    // Light the triangle from the camera
+    const Base::Vector3& p0 = model.vertex(i0);
+    const Base::Vector3& p1 = model.vertex(i1);
+    const Base::Vector3& p2 = model.vertex(i2);
+    Base::Vector3 normal = (p1 - p0).crossProduct(p2 - p0);
+    Base::Vector3 view = (p0 + p1 + p2) / 3 - eye;
+    Base::Real lengths = normal.magnitude() * view.magnitude();
+    Base::Real lambert = (lengths > 0) ?
+      fabs(normal.dotProduct(view)) / lengths : 0;
+    setup.color = options.color *
+      (options.ambient + (1 - options.ambient) * lambert);
+
+    setup.valid = true;
+    return true;
+  }
+
+  //////////////////////////////////////////////////////////////////////////////
+  // Function: RasterizeTriangle
+  //
+  // Draws the part of a triangle within a tile into the tile's depth and
+  // triangle buffers, returning the number of pixels written.
+  size_t RasterizeTriangle(const TriangleSetup& setup, uint32_t id,
+                           int tileX, int tileY,
+                           float* depth, uint32_t* triangles) {
+    int x0 = max(setup.minX, tileX);
+    int x1 = min(setup.maxX, tileX + kTileSize - 1);
+    int y0 = max(setup.minY, tileY);
+    int y1 = min(setup.maxY, tileY + kTileSize - 1);
+    size_t written = 0;
+
+    // Pixels are processed four at a time from a multiple of four
+    x0 &= ~3;
+
+#ifdef __SSE2__
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 laneOffsets = _mm_setr_ps(0, 1, 2, 3);
+    const __m128i idVector = _mm_set1_epi32(static_cast<int>(id));
+    __m128 a[3], b[3], c[3], inclusive[3];
+    for (int e = 0; e < 3; e++) {
+      a[e] = _mm_set1_ps(setup.a[e]);
+      b[e] = _mm_set1_ps(setup.b[e]);
+      c[e] = _mm_set1_ps(setup.c[e]);
+      inclusive[e] = _mm_castsi128_ps(_mm_set1_epi32(setup.inclusive[e] ? -1
+                                                     : 0));
+    }
+    const __m128 zA = _mm_set1_ps(setup.zA);
+    const __m128 zB = _mm_set1_ps(setup.zB);
+    const __m128 zC = _mm_set1_ps(setup.zC);
+
+    for (int y = y0; y <= y1; y++) {
+      __m128 py = _mm_set1_ps(static_cast<float>(y));
+      float* depthRow = depth + (y - tileY) * kTileSize;
+      uint32_t* triangleRow = triangles + (y - tileY) * kTileSize;
+
+      for (int x = x0; x <= x1; x += 4) {
+	__m128 px = _mm_add_ps(_mm_set1_ps(static_cast<float>(x)),
+	                       laneOffsets);
+
+	// Find the pixels inside all three edges
+	__m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+	for (int e = 0; e < 3; e++) {
+	  __m128 w = _mm_add_ps(_mm_add_ps(_mm_mul_ps(a[e], px),
+	                                   _mm_mul_ps(b[e], py)), c[e]);
+	  __m128 onEdge = _mm_and_ps(_mm_cmpeq_ps(w, zero), inclusive[e]);
+	  inside = _mm_and_ps(inside, _mm_or_ps(_mm_cmpgt_ps(w, zero), onEdge));
+	}
+	if (_mm_movemask_ps(inside) == 0) {
+	  continue;
+	}
+
+	// Keep those closer than what has already been drawn
+	__m128 z = _mm_add_ps(_mm_add_ps(_mm_mul_ps(zA, px),
+	                                 _mm_mul_ps(zB, py)), zC);
+	float* depthPtr = depthRow + (x - tileX);
+	__m128 oldZ = _mm_loadu_ps(depthPtr);
+	__m128 pass = _mm_and_ps(inside, _mm_cmpgt_ps(z, oldZ));
+	int passMask = _mm_movemask_ps(pass);
+	if (passMask == 0) {
+	  continue;
+	}
+
+	_mm_storeu_ps(depthPtr, _mm_or_ps(_mm_and_ps(pass, z),
+	                                  _mm_andnot_ps(pass, oldZ)));
+
+	__m128i* triangleptr = reinterpret_cast<__m128i*>(triangleRow +
+	                                                  (x - tileX));
+	__m128i passInt = _mm_castps_si128(pass);
+	__m128i oldIds = _mm_loadu_si128(triangleptr);
+	_mm_storeu_si128(triangleptr,
+	                 _mm_or_si128(_mm_and_si128(passInt, idVector),
+	                              _mm_andnot_si128(passInt, oldIds)));
+
+	written += (passMask & 1) + ((passMask >> 1) & 1) +
+	  ((passMask >> 2) & 1) + ((passMask >> 3) & 1);
+      }
+    }
+#else
+    for (int y = y0; y <= y1; y++) {
+      for (int x = x0; x <= x1; x++) {
+	bool inside = true;
+	for (int e = 0; e < 3 && inside; e++) {
+	  float w = setup.a[e] * x + setup.b[e] * y + setup.c[e];
+	  inside = (w > 0) || (w == 0 && setup.inclusive[e]);
+	}
+
+	int offset = (y - tileY) * kTileSize + (x - tileX);
+	float z = setup.zA * x + setup.zB * y + setup.zC;
+	if (inside && z > depth[offset]) {
+	  depth[offset] = z;
+	  triangles[offset] = id;
+	  written++;
+	}
+      }
+    }
+#endif
+
+    return written;
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+ostream& Base::operator << (ostream& out, const RasterStats& stats) {
+  out << stats.triangles << " triangles (" << stats.nearClipped
+      << " near clipped, " << stats.culled << " culled), " << stats.binned
+      << " tile bins, " << stats.pixelsWritten << " pixels written";
+  return out;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+Base::RasterStats Base::RasterizeModel(const Model& model,
+                                       const PerspectiveCamera& camera,
+                                       Image& image,
+                                       const RasterOptions& options) {
+  int width = image.width();
+  int height = image.height();
+  size_t numThreads = options.numThreads;
+  if (numThreads == 0) {
+    numThreads = max(std::thread::hardware_concurrency(), 1U);
+  }
+
+  // Number the triangles of every face's fan
+  size_t numFaces = model.numFaces();
+  vector<size_t> firstTriangle(numFaces + 1, 0);
+  for (size_t f = 0; f < numFaces; f++) {
+    size_t size = model.faceSize(f);
+    firstTriangle[f + 1] = firstTriangle[f] + ((size > 2) ? size - 2 : 0);
+  }
+  size_t numTriangles = firstTriangle[numFaces];
+
+  // Project every vertex onto the image
+  size_t numVertices = model.numVertices();
+  vector<ScreenVertex> vertices(numVertices);
+  RunThreads(numThreads, [&](size_t thread) {
+      size_t begin = numVertices * thread / numThreads;
+      size_t end = numVertices * (thread + 1) / numThreads;
+      for (size_t i = begin; i < end; i++) {
+	Vector3 projected(0, 0, 0);
+	ScreenVertex& v = vertices[i];
+	v.visible = camera.project(model.vertex(i), projected);
+	v.x = projected.x * width;
+	v.y = projected.y * height;
+	v.invZ = v.visible ? 1 / projected.z : 0;
+      }
+    });
+
+  // Set up the triangles and bin them into tiles, each thread keeping its
+  // own bins so that no locking is needed
+  int tilesX = (width + kTileSize - 1) >> kTileShift;
+  int tilesY = (height + kTileSize - 1) >> kTileShift;
+  size_t numTiles = tilesX * tilesY;
+  vector<TriangleSetup> setups(numTriangles);
+  vector<BinListT> bins(numThreads, BinListT(numTiles));
+  vector<RasterStats> threadStats(numThreads);
+
+  RunThreads(numThreads, [&](size_t thread) {
+      size_t begin = numFaces * thread / numThreads;
+      size_t end = numFaces * (thread + 1) / numThreads;
+      RasterStats& stats = threadStats[thread];
+      BinListT& threadBins = bins[thread];
+
+      for (size_t f = begin; f < end; f++) {
+	const size_t* face = model.faceIndices(f);
+	for (size_t j = 1; j + 1 < model.faceSize(f); j++) {
+	  size_t id = firstTriangle[f] + j - 1;
+	  TriangleSetup& setup = setups[id];
+	  if (!SetupTriangle(model, &vertices[0], face[0], face[j], face[j + 1],
+	                     camera.getCenter(), options, width, height,
+	                     setup, stats)) {
+	    continue;
+	  }
+
+	  for (int ty = setup.minY >> kTileShift;
+	       ty <= (setup.maxY >> kTileShift); ty++) {
+	    for (int tx = setup.minX >> kTileShift;
+	         tx <= (setup.maxX >> kTileShift); tx++) {
+	      threadBins[ty * tilesX + tx].push_back(id);
+	      stats.binned++;
+	    }
+	  }
+	}
+      }
+    });
+
+  // Rasterize whole tiles on each thread into a shared frame. The bins of
+  // each tile are visited in thread order, which is triangle order, so the
+  // result does not depend on the number of threads.
+  vector<Color> frame(static_cast<size_t>(width) * height);
+  std::atomic<size_t> nextTile(0);
+
+  RunThreads(numThreads, [&](size_t thread) {
+      vector<float> depth(kTileSize * kTileSize);
+      vector<uint32_t> triangles(kTileSize * kTileSize);
+      RasterStats& stats = threadStats[thread];
+
+      for (size_t tile = nextTile++; tile < numTiles; tile = nextTile++) {
+	int tileX = (tile % tilesX) << kTileShift;
+	int tileY = (tile / tilesX) << kTileShift;
+	std::fill(depth.begin(), depth.end(), 0.0f);
+	std::fill(triangles.begin(), triangles.end(), kNoTriangle);
+
+	for (size_t t = 0; t < numThreads; t++) {
+	  const BinT& bin = bins[t][tile];
+	  for (size_t i = 0; i < bin.size(); i++) {
+	    stats.pixelsWritten += RasterizeTriangle(setups[bin[i]], bin[i],
+	                                             tileX, tileY,
+	                                             &depth[0], &triangles[0]);
+	  }
+	}
+
+	// Resolve the tile into the frame
+	int tileWidth = min(kTileSize, width - tileX);
+	int tileHeight = min(kTileSize, height - tileY);
+	for (int y = 0; y < tileHeight; y++) {
+	  Color* out = &frame[static_cast<size_t>(tileY + y) * width + tileX];
+	  const uint32_t* ids = &triangles[y * kTileSize];
+	  for (int x = 0; x < tileWidth; x++) {
+	    out[x] = (ids[x] == kNoTriangle) ? options.background :
+	      setups[ids[x]].color;
+	  }
+	}
+      }
+    });
+
+  // Copy the frame into the image on this thread, since image writes are
+  // not safe to make concurrently
+  for (int y = 0; y < height; y++) {
+    image.writeRow(y, 0, width, &frame[static_cast<size_t>(y) * width]);
+  }
+
+  RasterStats total;
+  total.triangles = numTriangles;
+  for (size_t i = 0; i < numThreads; i++) {
+    total.nearClipped += threadStats[i].nearClipped;
+    total.culled += threadStats[i].culled;
+    total.binned += threadStats[i].binned;
+    total.pixelsWritten += threadStats[i].pixelsWritten;
+  }
+  return total;
+}
@@ -0,0 +1,93 @@
+////////////////////////////////////////////////////////////////////////////////
+// Base: A Simple Graphics Suite
+// Author: Eric Scrivner
+//
+// Time-stamp: <Last modified 2026-10-19 15:34:08 by Eric Scrivner>
+//
+// Description:
+//   Software rasterizer producing shaded previews of models.
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef RASTERIZER_HPP__
+#define RASTERIZER_HPP__
+
+#include "base.hpp"
+#include "color.hpp"
+#include "vector3.hpp"
+
+#include <iosfwd>
+
+namespace Base {
+  //////////////////////////////////////////////////////////////////////////////
+  // Forward definitions
+  class Image;
+  class Model;
+  class PerspectiveCamera;
+
+  //////////////////////////////////////////////////////////////////////////////
+  // Struct: RasterOptions
+  //
+  // Controls the output of RasterizeModel.
+  struct RasterOptions {
+    Color  color;          // The color of fully lit surfaces
+    Color  background;     // The color of pixels no triangle covers
+    Real   ambient;        // The fraction of color used for unlit surfaces
+    bool   cullBackFaces;  // Skip triangles which are clockwise on screen
+    size_t numThreads;     // Threads to use; zero uses one per core
+
+    RasterOptions()
+      : color(Color::White), background(Color::Black), ambient(0.2),
+        cullBackFaces(false), numThreads(0)
+    { }
+  };
+
+  //////////////////////////////////////////////////////////////////////////////
+  // Struct: RasterStats
+  //
+  // Counts of the work done by RasterizeModel.
+  struct RasterStats {
+    size_t triangles;      // Triangles in the model
+    size_t nearClipped;    // Triangles dropped for crossing the near plane
+    size_t culled;         // Triangles back facing, degenerate or off screen
+    size_t binned;         // Triangle and tile pairs rasterized
+    size_t pixelsWritten;  // Pixels passing the depth test (incl. overdraw)
+
+    RasterStats()
+      : triangles(0), nearClipped(0), culled(0), binned(0), pixelsWritten(0)
+    { }
+  };
+
+  //////////////////////////////////////////////////////////////////////////////
+  // Function: operator <<
+  //
+  // Writes a one line summary of the given statistics to a stream
+  std::ostream& operator << (std::ostream& out, const RasterStats& stats);
+
+  //////////////////////////////////////////////////////////////////////////////
+  // Function: RasterizeModel
+  //
+  // Parameters:
+  //   model - The model to be drawn (faces are split into fans of triangles)
+  //   camera - The camera the model is viewed through
+  //   image - The image the model is drawn into; every pixel is written
+  //   options - Colors and settings for the rasterizer
+  //
+  // Draws the faces of the model as flat shaded, depth buffered triangles lit
+  // from the camera, sampling pixels at the same screen positions as the
+  // ray tracer does.
+  //
+  // Vertices are projected in parallel and the triangles set up as edge
+  // functions and binned into 64x64 pixel tiles. Threads then take whole
+  // tiles, testing four pixels at a time for coverage and depth (with SSE
+  // where available) against a tile-local depth buffer, and the finished
+  // frame is copied into the image a row at a time.
+  //
+  // Triangles with a vertex behind the camera are dropped rather than
+  // clipped, so geometry passing through the camera plane may vanish.
+  RasterStats RasterizeModel(const Model& model,
+                             const PerspectiveCamera& camera,
+                             Image& image,
+                             const RasterOptions& options = RasterOptions());
+}
+
+#endif // RASTERIZER_HPP__
@@ -22,9 +22,24 @@ namespace Base {
   public:
     Vector3 origin; // The starting point of the ray
     Vector3 direction; // The direction the ray will travel in
+    Real width; // The width of the ray's footprint at its origin
+    Real spread; // The growth of the width per unit of distance travelled
 
-    Ray(const Vector3& o, const Vector3& d)
-      : origin(o), direction(d)
+    ////////////////////////////////////////////////////////////////////////////
+    // Function: Ray
+    //
+    // Parameters:
+    //   o - The origin of the ray
+    //   d - The direction of the ray
+    //   w - The width of the ray at its origin
+    //   s - The growth of the width per unit of distance
+    //
+    // Initializes the ray. The width and spread approximate the differentials
+    // of the ray as a cone covering the area of the image it was traced for,
+    // and are zero for rays taken to be infinitely thin.
+    Ray(const Vector3& o, const Vector3& d, const Real& w = 0,
+        const Real& s = 0)
+      : origin(o), direction(d), width(w), spread(s)
     { }
 
     ////////////////////////////////////////////////////////////////////////////
@@ -37,6 +52,12 @@ namespace Base {
     Vector3 positionAtTime(const Real& t) const { 
       return origin + t * direction;
     }
+
+    ////////////////////////////////////////////////////////////////////////////
+    // Function: widthAtTime
+    //
+    // Returns the width of the ray's footprint at the given parametric value
+    Real widthAtTime(const Real& t) const { return width + t * spread; }
   };
 }
 
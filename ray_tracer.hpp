@@ -11,9 +11,13 @@
 #define RAY_TRACER_HPP__
 
 #include "color.hpp"
+#include "compiled_group.hpp"
+#include "dependency_map.hpp"
 #include "hit.hpp"
 #include "ray.hpp"
+#include "sampling.hpp"
 #include "scene.hpp"
+#include "vector_math.hpp"
 
 #include <cstdio>
 
@@ -33,10 +37,14 @@ namespace Base {
     //   maxDepth - The maximum ray-trace recursion depth
     //   minWeight - The minimum weight of a ray contribution
     //
-    // Initializes the ray-tracer with the given scene and depth.
+    // Initializes the ray-tracer with the given scene and depth, compiling
+    // the primitives of the scene.
     RayTracer(Scene* scene, int maxDepth, Real minWeight)
-      : scene_(scene), maxDepth_(maxDepth), minWeight_(minWeight)
-    { }
+      : scene_(scene), maxDepth_(maxDepth), minWeight_(minWeight),
+        shadowSamples_(4), shadowBudget_(32)
+    {
+      compile();
+    }
 
     ~RayTracer() {
       if (scene_ != 0) {
@@ -50,6 +58,48 @@ namespace Base {
     // Returns the scene being ray-traced
     Scene* getScene() const { return scene_; }
 
+    ////////////////////////////////////////////////////////////////////////////
+    // Function: setShadowSampling
+    //
+    // Parameters:
+    //   samples - The number of shadow rays first cast to an area light
+    //   budget - The most shadow rays cast to an area light from one point
+    //
+    // Sets how many shadow rays are used to find how much of an area light
+    // is visible from a point. Points which the first rays find to be wholly
+    // lit or wholly shadowed are taken to be so, and only points where they
+    // disagree (in a penumbra) get the rest of the budget.
+    void setShadowSampling(const size_t& samples, const size_t& budget) {
+      assert(samples > 0 && samples <= budget);
+      shadowSamples_ = samples;
+      shadowBudget_ = budget;
+    }
+
+    ////////////////////////////////////////////////////////////////////////////
+    // Function: compile
+    //
+    // Compiles the primitives of the scene into the form which is traced
+    // (see CompiledGroup). Tracing recompiles them if the version of the
+    // scene's group has changed, which it does when a primitive is added to
+    // it or to a group within it. Primitives changed in place are only seen
+    // once markChanged is called on a group containing them, or this is
+    // called. Recompiling is not safe while several threads are tracing, so
+    // traces with threads should call this after changing the scene.
+    void compile() const {
+      compiled_.compile(*scene_->getPrimitives());
+      compiledVersion_ = scene_->getPrimitives()->version();
+    }
+
+    ////////////////////////////////////////////////////////////////////////////
+    // Function: closestHit
+    //
+    // Finds the closest intersection of the ray with the scene's primitives
+    // without shading it, returning false if the ray hits nothing
+    bool closestHit(const Ray& ray, Real tmin, Hit& hit) const {
+      hit.setDistance(RealLimits::infinity());
+      return _primitives().intersection(ray, hit, tmin);
+    }
+
     ////////////////////////////////////////////////////////////////////////////
     // Function: traceRay
     //
@@ -60,11 +110,14 @@ namespace Base {
     //   weight - The current weight of the light ray
     //   indexOfRefraction - The current index of refraction
     //   hit - The hit information in regards to the ray being traced
+    //   touched - If given, receives the scene elements (see Scene) which the
+    //             ray and the rays it spawns touch
     //
     // Traces the given ray into the scene given that it does not exceed the
     // maximum recursion depth.
     Color traceRay(Ray& ray, int depth, Real tmin, Real weight,
-                   Real indexOfRefraction, Hit& hit) const {
+                   Real indexOfRefraction, Hit& hit,
+                   ElementSet* touched = 0) const {
       // If the current depth exceeds the maximum depth
       if (depth > maxDepth_ || fabs(weight - minWeight_) < 0.001) {
 	// Return the background color
@@ -75,24 +128,42 @@ namespace Base {
       hit.setDistance(RealLimits::infinity());
 
       // If there was an intersection with an object in the scene
-      if (scene_->getPrimitives()->intersection(ray, hit, tmin)) {
-	Color result = scene_->getAmbient() * hit.getMaterial()->diffuse;
+      if (_primitives().intersection(ray, hit, tmin)) {
+	if (touched != 0) {
+	  touched->insert(hit.getElement());
+	  touched->insert(scene_->materialElement(hit.getMaterial()));
+	}
+
+	Vec4 result = Vec4(scene_->getAmbient()) *
+	              hit.getMaterial()->diffuseAt(ray, hit);
 	Vector3 lightDir;
 	Color lightCol;
 
+	// Shadow rays start as wide as the ray is at the hit
+	Real width = ray.widthAtTime(hit.getDistance());
+
 	// For each light in the scene
 	for (size_t i = 0; i < scene_->numLights(); i++) {
 	  // Compute the illumination of this light
 	  Vector3 hitPoint = ray.positionAtTime(hit.getDistance());
-	  scene_->getLight(i)->illuminationAt(hitPoint, lightDir, lightCol);
+	  Light* light = scene_->getLight(i);
+	  light->illuminationAt(hitPoint, lightDir, lightCol);
 
-	  // If we're not in any shadows
-	  if (!inShadow(hitPoint, lightDir, tmin)) {
+	  if (AreaLight* area = dynamic_cast<AreaLight*>(light)) {
+	    // Scale the contribution by how much of the light can be seen
+	    Real visible = lightVisibility(hitPoint, width, *area, tmin,
+					   touched);
+	    if (visible > 0) {
+	      result += visible * Vec4(hit.getMaterial()->shade(ray, hit, lightDir,
+	                                                        lightCol));
+	    }
+	  } else if (!inShadow(hitPoint, lightDir, width, tmin, touched)) {
 	    // Add the contribution of this light to the final color
 	    result += hit.getMaterial()->shade(ray, hit, lightDir, lightCol);
 	  }
 
-	  Ray nextRay(Vector3(0,0,0), Vector3(0,0,0));
+	  // Rays leaving the hit keep on widening from the width reached there
+	  Ray nextRay(Vector3(0,0,0), Vector3(0,0,0), width, ray.spread);
 
 	  // If the material is reflective
 	  if (hit.getMaterial()->isReflective()) {
@@ -102,11 +173,12 @@ namespace Base {
 
 	    // Recursively compute the color
 	    Hit hit2;
-	    result += hit.getMaterial()->reflection * traceRay(nextRay,
-	                                                       depth + 1,
-	                                                       tmin,
-	                                                       weight * hit.getMaterial()->reflection.magnitude(),
-	                                                       indexOfRefraction, hit2);
+	    result += Vec4(hit.getMaterial()->reflection) * traceRay(nextRay,
+	                                                             depth + 1,
+	                                                             tmin,
+	                                                             weight * hit.getMaterial()->reflection.magnitude(),
+	                                                             indexOfRefraction, hit2,
+	                                                             touched);
 	  }
 
 	  // If the material is transparent
@@ -118,20 +190,19 @@ namespace Base {
 	                                         indexOfRefraction,
 	                                         hit.getMaterial()->indexOfRefraction);
 
-	    Real mag = Vector3(hit.getMaterial()->refraction.r,
-	                       hit.getMaterial()->refraction.g,
-	                       hit.getMaterial()->refraction.b).magnitude();
+	    Vec4 refraction = hit.getMaterial()->refraction;
 	    Hit hit3;
-	    result += hit.getMaterial()->refraction * traceRay(nextRay,
-	                                                       depth + 1,
-	                                                       tmin,
-	                                                       weight * mag,
-	                                                       hit.getMaterial()->indexOfRefraction,
-	                                                       hit3);
+	    result += refraction * traceRay(nextRay,
+	                                    depth + 1,
+	                                    tmin,
+	                                    weight * refraction.magnitude(),
+	                                    hit.getMaterial()->indexOfRefraction,
+	                                    hit3,
+	                                    touched);
 	  }
 	}
 
-	return weight * result;
+	return (weight * result).toColor();
       }
 
       return scene_->getBackgroundColor();
@@ -141,15 +212,74 @@ namespace Base {
     // Function: inShadow
     //
     // Indicates whether an object is in the shadow of another object given
-    // a point of intersection and a direction to a light.
-    bool inShadow(const Vector3& hitPoint, const Vector3& lightDir, Real tmin) const {
-      // Set the nearest hit to infinitely far away
+    // a point of intersection and a direction to a light. The shadow ray has
+    // the given width (see Ray), so that primitives with levels of detail
+    // (see LodMesh) cast shadows from the level the point was found on. Only
+    // objects nearer than maxDistance cast shadows. If touched is given the
+    // element casting the shadow is added to it.
+    bool inShadow(const Vector3& hitPoint, const Vector3& lightDir,
+                  Real width, Real tmin, ElementSet* touched,
+                  Real maxDistance = RealLimits::infinity()) const {
+      // Only look for hits before the light
       Hit h;
-      h.setDistance(RealLimits::infinity());
+      h.setDistance(maxDistance);
 
       // Determine whether or not an intersection occurred
-      Vector3 hp = hitPoint;
-      return scene_->getPrimitives()->intersection(Ray(hitPoint, lightDir), h, tmin);
+      if (!_primitives().intersection(Ray(hitPoint, lightDir, width), h,
+				    tmin)) {
+	return false;
+      }
+
+      if (touched != 0) {
+	touched->insert(h.getElement());
+      }
+      return true;
+    }
+
+    ////////////////////////////////////////////////////////////////////////////
+    // Function: lightVisibility
+    //
+    // Returns the fraction of the area light which can be seen from the given
+    // point, estimated from shadow rays to low-discrepancy sample points of
+    // the light's surface. The samples are scrambled by a hash of the point
+    // so that neighbouring points do not share the same pattern of errors.
+    Real lightVisibility(const Vector3& hitPoint, Real width,
+                         const AreaLight& light, Real tmin,
+                         ElementSet* touched) const {
+      SampleScramble scramble = ScrambleForPoint(hitPoint);
+      size_t lit = 0;
+      size_t count = 0;
+      while (count < shadowBudget_) {
+	Real u, v;
+	SamplePoint2D(count, scramble, u, v);
+	Vector3 toLight = light.samplePoint(hitPoint, u, v) - hitPoint;
+	Real distance = toLight.magnitude();
+	if (distance == 0 ||
+	    !inShadow(hitPoint, toLight / distance, width, tmin, touched,
+		      distance)) {
+	  lit++;
+	}
+	count++;
+
+	// Stop if the first samples agree, as they do outside penumbrae
+	if (count == shadowSamples_ && (lit == 0 || lit == count)) {
+	  break;
+	}
+      }
+
+      return static_cast<Real>(lit) / count;
+    }
+
+    ////////////////////////////////////////////////////////////////////////////
+    // Function: _primitives
+    //
+    // Returns the compiled primitives of the scene, compiling them again if
+    // the scene has changed
+    CompiledGroup& _primitives() const {
+      if (compiledVersion_ != scene_->getPrimitives()->version()) {
+	compile();
+      }
+      return compiled_;
     }
 
     ////////////////////////////////////////////////////////////////////////////
@@ -159,7 +289,7 @@ namespace Base {
     // surface normal.
     Vector3 getReflectionDir(const Vector3& rayDir, const Vector3& norm) const {
       // Perfect mirror reflection
-      return rayDir - (2 * rayDir.dotProduct(norm)) * norm;
+      return Vec4(rayDir).reflect(norm).toVector3();
     }
 
     ////////////////////////////////////////////////////////////////////////////
@@ -182,13 +312,17 @@ namespace Base {
       // Compute the refracted ray direction
       Real cosIncident = eyeRay.dotProduct(normal);
       Real cosMaterial = (n_r * cosIncident);
-      cosMaterial -= sqrt(1 - pow(n_r, 2) * (1 - pow(cosIncident, 2)));
+      cosMaterial -= sqrt(1 - n_r * n_r * (1 - cosIncident * cosIncident));
       return (cosMaterial * normal) - (n_r * eyeRay);
     }
 
     Scene* scene_; // The scene to be ray-traced
     int maxDepth_; // The maximum recursive depth for tracing rays
     Real minWeight_; // The minimum weighting of a ray contribution
+    size_t shadowSamples_; // Shadow rays first cast to an area light
+    size_t shadowBudget_; // Most shadow rays cast to an area light
+    mutable CompiledGroup compiled_; // The scene's primitives, by type
+    mutable size_t compiledVersion_; // The version of the scene compiled
   };
 }
 
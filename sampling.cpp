@@ -0,0 +1,79 @@
+////////////////////////////////////////////////////////////////////////////////
+// Base: A Simple Graphics Suite
+// Author: Eric Scrivner
+//
+// Time-stamp: <Last modified 2026-10-19 19:31:06 by Eric Scrivner>
+//
+// Description:
+//   Low-discrepancy sample points for integrating over lights.
+////////////////////////////////////////////////////////////////////////////////
+
+#include "sampling.hpp"
+
+#include <cstring>
+
+namespace {
+  //////////////////////////////////////////////////////////////////////////////
+  // Function: Mix
+  //
+  // Returns a well mixed hash of the given value (the finalizer of
+  // MurmurHash3)
+  uint64_t Mix(uint64_t value) {
+    value ^= value >> 33;
+    value *= 0xff51afd7ed558ccdULL;
+    value ^= value >> 33;
+    value *= 0xc4ceb9fe1a85ec53ULL;
+    value ^= value >> 33;
+    return value;
+  }
+
+  //////////////////////////////////////////////////////////////////////////////
+  // Function: Bits
+  //
+  // Returns the bits of the given real
+  uint64_t Bits(const Base::Real& value) {
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return bits;
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+Base::SampleScramble Base::ScrambleForPoint(const Vector3& point) {
+  uint64_t hash = Mix(Bits(point.x));
+  hash = Mix(hash ^ Bits(point.y));
+  hash = Mix(hash ^ Bits(point.z));
+
+  SampleScramble scramble;
+  scramble.u = static_cast<uint32_t>(hash);
+  scramble.v = static_cast<uint32_t>(hash >> 32);
+  return scramble;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void Base::SamplePoint2D(const uint32_t& index, const SampleScramble& scramble,
+                         Real& u, Real& v) {
+  // The first dimension is the base two radical inverse of the index, found
+  // by reversing its bits
+  uint32_t x = index;
+  x = (x << 16) | (x >> 16);
+  x = ((x & 0x00ff00ff) << 8) | ((x & 0xff00ff00) >> 8);
+  x = ((x & 0x0f0f0f0f) << 4) | ((x & 0xf0f0f0f0) >> 4);
+  x = ((x & 0x33333333) << 2) | ((x & 0xcccccccc) >> 2);
+  x = ((x & 0x55555555) << 1) | ((x & 0xaaaaaaaa) >> 1);
+
+  // The second is the sum of the direction numbers of the bits of the index
+  uint32_t y = 0;
+  for (uint32_t i = index, direction = 1u << 31; i != 0;
+       i >>= 1, direction ^= direction >> 1) {
+    if (i & 1) {
+      y ^= direction;
+    }
+  }
+
+  const Real kScale = 1.0 / 4294967296.0; // 2^-32
+  u = (x ^ scramble.u) * kScale;
+  v = (y ^ scramble.v) * kScale;
+}
@@ -0,0 +1,58 @@
+////////////////////////////////////////////////////////////////////////////////
+// Base: A Simple Graphics Suite
+// Author: Eric Scrivner
+//
+// Time-stamp: <Last modified 2026-10-19 19:31:06 by Eric Scrivner>
+//
+// Description:
+//   Low-discrepancy sample points for integrating over lights.
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef SAMPLING_HPP__
+#define SAMPLING_HPP__
+
+#include "base.hpp"
+#include "vector3.hpp"
+
+#include <stdint.h>
+
+namespace Base {
+  //////////////////////////////////////////////////////////////////////////////
+  // Struct: SampleScramble
+  //
+  // Bits with which the sample points of one sequence are scrambled, so that
+  // neighbouring points being shaded do not use the same sample points and
+  // share the same errors.
+  struct SampleScramble {
+    uint32_t u, v; // The bits flipped in each coordinate
+
+    SampleScramble()
+      : u(0), v(0)
+    { }
+  };
+
+  //////////////////////////////////////////////////////////////////////////////
+  // Function: ScrambleForPoint
+  //
+  // Returns scramble bits hashed from the given point, so that the same point
+  // always gets the same samples
+  SampleScramble ScrambleForPoint(const Vector3& point);
+
+  //////////////////////////////////////////////////////////////////////////////
+  // Function: SamplePoint2D
+  //
+  // Parameters:
+  //   index - The index of the sample in the sequence
+  //   scramble - The scramble bits of the sequence
+  //   u, v - Set to the sample point, on [0, 1)
+  //
+  // Returns the given point of the two dimensional Sobol sequence, scrambled
+  // by flipping bits. The first 2^k points of the sequence have one point in
+  // each of the 2^k boxes of any division of the unit square into boxes of
+  // equal size and power of two sides, and scrambling keeps that property,
+  // so every prefix of the sequence covers the square evenly.
+  void SamplePoint2D(const uint32_t& index, const SampleScramble& scramble,
+                     Real& u, Real& v);
+}
+
+#endif // SAMPLING_HPP__
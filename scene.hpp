@@ -11,9 +11,11 @@
 #ifndef SCENE_HPP__
 #define SCENE_HPP__
 
+#include "arena.hpp"
 #include "base.hpp"
 #include "camera.hpp"
 #include "light.hpp"
+#include "material.hpp"
 #include "primitive.hpp"
 
 namespace Base {
@@ -21,20 +23,38 @@ namespace Base {
   // Class: Scene
   //
   // Encapsulates information about a scene which is to be ray-traced.
+  //
+  // The scene owns an arena from which its primitives can be allocated (see
+  // getArena), so that the largest scenes are built and torn down without
+  // a heap allocation per primitive. Primitives allocated with new may still
+  // be added to the scene, and are deleted with it.
+  //
+  // The elements of a scene, which a DependencyMap records the use of, are
+  // the primitives added directly to its group followed by the materials
+  // added to it with addMaterial. A primitive within a group in the scene
+  // has the element of that group, so the whole of a model's mesh is one
+  // element.
   class Scene {
   public:
-    Scene(Camera* camera)
-      : primitives_(new Group()), camera_(camera), ambient_(Color::Black)
-    { }
+    ////////////////////////////////////////////////////////////////////////////
+    // Function: Scene
+    //
+    // Parameters:
+    //   camera - The camera looking onto the scene
+    //   hugePages - Whether to back the scene's arena with huge pages
+    Scene(Camera* camera, bool hugePages = false)
+      : arena_(Arena::kDefaultBlockSize, hugePages), camera_(camera),
+        ambient_(Color::Black)
+    {
+      primitives_ = arena_.create<Group>(&arena_);
+    }
 
     ~Scene() {
       if (camera_ != 0) {
 	delete camera_;
       }
 
-      if (primitives_ != 0) {
-	delete primitives_;
-      }
+      // The primitives are destroyed along with the arena
 
       for (LightSetT::iterator it = lights_.begin();
 	   it != lights_.end(); it++) {
@@ -51,6 +71,17 @@ namespace Base {
       lights_.push_back(light);
     }
 
+    ////////////////////////////////////////////////////////////////////////////
+    // Function: addMaterial
+    //
+    // Adds a material used in this scene to its elements, recording its
+    // index in the material. The scene does not take ownership of the
+    // material.
+    void addMaterial(Material* material) {
+      material->sceneIndex = materials_.size();
+      materials_.push_back(material);
+    }
+
     ////////////////////////////////////////////////////////////////////////////
     // Function: setCamera
     //
@@ -60,10 +91,6 @@ namespace Base {
 	delete camera_;
       }
 
-      if (primitives_ != 0) {
-	delete primitives_;
-      }
-
       camera_ = camera;
     }
 
@@ -108,6 +135,45 @@ namespace Base {
       return lights_[index];
     }
 
+    ////////////////////////////////////////////////////////////////////////////
+    // Function: numMaterials
+    //
+    // Returns the number of materials added to this scene
+    size_t numMaterials() const { return materials_.size(); }
+
+    ////////////////////////////////////////////////////////////////////////////
+    // Function: getMaterial
+    //
+    // Returns the material added at the given index
+    Material* getMaterial(const size_t& index) const {
+      assert(index < numMaterials());
+      return materials_[index];
+    }
+
+    ////////////////////////////////////////////////////////////////////////////
+    // Function: numElements
+    //
+    // Returns the number of elements in this scene. Element i is the i-th
+    // primitive of the scene's group, and element numPrimitives() + j is the
+    // j-th material added.
+    size_t numElements() const {
+      return primitives_->numPrimitives() + materials_.size();
+    }
+
+    ////////////////////////////////////////////////////////////////////////////
+    // Function: materialElement
+    //
+    // Returns the element of the given material, or kNoElement if it was not
+    // added to this scene. A material added to several scenes only has an
+    // element in the last.
+    size_t materialElement(const Material* material) const {
+      size_t index = material->sceneIndex;
+      if (index < materials_.size() && materials_[index] == material) {
+	return primitives_->numPrimitives() + index;
+      }
+      return kNoElement;
+    }
+
     ////////////////////////////////////////////////////////////////////////////
     // Function: getCamera
     //
@@ -119,12 +185,22 @@ namespace Base {
     //
     // Returns the group containing all the primitives in this scene
     Group* getPrimitives() const { return primitives_; }
+
+    ////////////////////////////////////////////////////////////////////////////
+    // Function: getArena
+    //
+    // Returns the arena from which primitives of this scene may be allocated.
+    // It is released when the scene is destroyed.
+    Arena* getArena() { return &arena_; }
   private:
     ////////////////////////////////////////////////////////////////////////////
     // Type definitions
     typedef std::vector<Light*> LightSetT;
+    typedef std::vector<Material*> MaterialSetT;
 
+    Arena     arena_; // Memory for the primitives of the scene.
     LightSetT lights_; // All the lights in a scene.
+    MaterialSetT materials_; // The materials added to the scene.
     Group*    primitives_; // All the primitives in a scene.
     Camera*   camera_; // The camera looking onto the scene.
     Color     background_; // The background color for the scene.
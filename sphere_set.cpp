@@ -0,0 +1,307 @@
+////////////////////////////////////////////////////////////////////////////////
+// Base: A Simple Graphics Suite
+// Author: Eric Scrivner
+//
+// Time-stamp: <Last modified 2026-10-19 16:24:07 by Eric Scrivner>
+//
+// Description:
+//   Large sets of spheres sharing a material, stored as arrays of coordinates
+//   and intersected several at a time.
+////////////////////////////////////////////////////////////////////////////////
+
+#include "fast_math.hpp"
+#include "mesh_order.hpp"
+#include "sphere_set.hpp"
+
+#include <algorithm>
+#include <utility>
+
+#ifdef __AVX__
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+using namespace std;
+
+namespace {
+  //////////////////////////////////////////////////////////////////////////////
+  // Function: Permute
+  //
+  // Reorders values so that values[i] becomes the old values[order[i]]
+  void Permute(std::vector<Base::Real>& values,
+               const std::vector<std::pair<uint64_t, size_t> >& order) {
+    std::vector<Base::Real> result(values.size());
+    for (size_t i = 0; i < order.size(); i++) {
+      result[i] = values[order[i].second];
+    }
+    values.swap(result);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+Base::SphereSet::SphereSet(Material* mat)
+  : Primitive(mat), numSpheres_(0), built_(false)
+{ }
+
+////////////////////////////////////////////////////////////////////////////////
+
+void Base::SphereSet::reserve(const size_t& count) {
+  x_.reserve(count + kLeafSize);
+  y_.reserve(count + kLeafSize);
+  z_.reserve(count + kLeafSize);
+  radius2_.reserve(count + kLeafSize);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void Base::SphereSet::addSphere(const Vector3& center, const Real& radius) {
+  // Drop the padding of the last build
+  x_.resize(numSpheres_);
+  y_.resize(numSpheres_);
+  z_.resize(numSpheres_);
+  radius2_.resize(numSpheres_);
+
+  x_.push_back(center.x);
+  y_.push_back(center.y);
+  z_.push_back(center.z);
+  radius2_.push_back(radius * radius);
+  numSpheres_++;
+  built_ = false;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void Base::SphereSet::build() {
+  hierarchy_.clear();
+  built_ = true;
+
+  x_.resize(numSpheres_);
+  y_.resize(numSpheres_);
+  z_.resize(numSpheres_);
+  radius2_.resize(numSpheres_);
+  if (numSpheres_ == 0) {
+    return;
+  }
+
+  // Sort the spheres along a Morton curve through the box of their centers
+  Real lower[3] = { x_[0], y_[0], z_[0] };
+  Real upper[3] = { x_[0], y_[0], z_[0] };
+  for (size_t i = 1; i < numSpheres_; i++) {
+    lower[0] = min(lower[0], x_[i]); upper[0] = max(upper[0], x_[i]);
+    lower[1] = min(lower[1], y_[i]); upper[1] = max(upper[1], y_[i]);
+    lower[2] = min(lower[2], z_[i]); upper[2] = max(upper[2], z_[i]);
+  }
+
+  Real scale[3];
+  for (int axis = 0; axis < 3; axis++) {
+    Real extent = upper[axis] - lower[axis];
+    scale[axis] = (extent > 0) ? 1 / extent : 0;
+  }
+
+  std::vector<std::pair<uint64_t, size_t> > order(numSpheres_);
+  for (size_t i = 0; i < numSpheres_; i++) {
+    order[i].first = MortonCode((x_[i] - lower[0]) * scale[0],
+                                (y_[i] - lower[1]) * scale[1],
+                                (z_[i] - lower[2]) * scale[2]);
+    order[i].second = i;
+  }
+  sort(order.begin(), order.end());
+
+  Permute(x_, order);
+  Permute(y_, order);
+  Permute(z_, order);
+  Permute(radius2_, order);
+
+  // Pad the last leaf with spheres which can never be hit
+  size_t padded = (numSpheres_ + kLeafSize - 1) / kLeafSize * kLeafSize;
+  x_.resize(padded, 0);
+  y_.resize(padded, 0);
+  z_.resize(padded, 0);
+  radius2_.resize(padded, -1);
+
+  // Bound the spheres of each leaf
+  std::vector<Real> bounds;
+  bounds.reserve(6 * padded / kLeafSize);
+  for (size_t first = 0; first < padded; first += kLeafSize) {
+    Real lower[3] = {
+      RealLimits::infinity(), RealLimits::infinity(), RealLimits::infinity()
+    };
+    Real upper[3] = { -lower[0], -lower[1], -lower[2] };
+    for (size_t i = first; i < first + kLeafSize && i < numSpheres_; i++) {
+      Real radius = sqrt(radius2_[i]);
+      lower[0] = min(lower[0], x_[i] - radius);
+      lower[1] = min(lower[1], y_[i] - radius);
+      lower[2] = min(lower[2], z_[i] - radius);
+      upper[0] = max(upper[0], x_[i] + radius);
+      upper[1] = max(upper[1], y_[i] + radius);
+      upper[2] = max(upper[2], z_[i] + radius);
+    }
+    bounds.insert(bounds.end(), lower, lower + 3);
+    bounds.insert(bounds.end(), upper, upper + 3);
+  }
+  hierarchy_.build(bounds);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool Base::SphereSet::intersection(const Ray& ray, Hit& hit, Real tmin) {
+  if (!built_) {
+    build();
+  }
+
+  return hierarchy_.intersect(ray, hit, tmin, [&](size_t leaf) {
+    return _intersectLeaf(ray, hit, tmin, leaf * kLeafSize);
+  });
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool Base::SphereSet::_intersectLeaf(const Ray& ray, Hit& hit, Real tmin,
+                                     const size_t& first) const {
+  // Find the closest sphere hit with the same arithmetic as
+  // Sphere::intersection, so the results are identical
+  Real closest = hit.getDistance();
+  size_t closestSphere = first + kLeafSize;
+
+#ifdef __SSE2__
+#ifdef __AVX__
+  const __m256d ox = _mm256_set1_pd(ray.origin.x);
+  const __m256d oy = _mm256_set1_pd(ray.origin.y);
+  const __m256d oz = _mm256_set1_pd(ray.origin.z);
+  const __m256d dx = _mm256_set1_pd(ray.direction.x);
+  const __m256d dy = _mm256_set1_pd(ray.direction.y);
+  const __m256d dz = _mm256_set1_pd(ray.direction.z);
+  const __m256d zero = _mm256_setzero_pd();
+  const __m256d epsilon = _mm256_set1_pd(0.0001);
+  const __m256d minimum = _mm256_set1_pd(tmin);
+#else
+  const __m128d ox = _mm_set1_pd(ray.origin.x);
+  const __m128d oy = _mm_set1_pd(ray.origin.y);
+  const __m128d oz = _mm_set1_pd(ray.origin.z);
+  const __m128d dx = _mm_set1_pd(ray.direction.x);
+  const __m128d dy = _mm_set1_pd(ray.direction.y);
+  const __m128d dz = _mm_set1_pd(ray.direction.z);
+  const __m128d zero = _mm_setzero_pd();
+  const __m128d epsilon = _mm_set1_pd(0.0001);
+  const __m128d minimum = _mm_set1_pd(tmin);
+#endif
+
+  for (size_t i = first; i < first + kLeafSize; i += 4) {
+    Real distances[4];
+    int mask;
+
+#ifdef __AVX__
+    // Four spheres per iteration
+    __m256d cx = _mm256_sub_pd(_mm256_loadu_pd(&x_[i]), ox);
+    __m256d cy = _mm256_sub_pd(_mm256_loadu_pd(&y_[i]), oy);
+    __m256d cz = _mm256_sub_pd(_mm256_loadu_pd(&z_[i]), oz);
+    __m256d rayCos = _mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(cx, dx),
+                                                 _mm256_mul_pd(cy, dy)),
+                                   _mm256_mul_pd(cz, dz));
+
+    // Squared distance of the center from the ray
+    __m256d px = _mm256_sub_pd(cx, _mm256_mul_pd(rayCos, dx));
+    __m256d py = _mm256_sub_pd(cy, _mm256_mul_pd(rayCos, dy));
+    __m256d pz = _mm256_sub_pd(cz, _mm256_mul_pd(rayCos, dz));
+    __m256d perp2 = _mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(px, px),
+                                                _mm256_mul_pd(py, py)),
+                                  _mm256_mul_pd(pz, pz));
+    __m256d disc = _mm256_sub_pd(_mm256_loadu_pd(&radius2_[i]), perp2);
+    __m256d valid = _mm256_and_pd(_mm256_cmp_pd(rayCos, zero, _CMP_GE_OQ),
+                                  _mm256_cmp_pd(disc, epsilon, _CMP_GT_OQ));
+
+    // Take the far root if the ray starts inside the sphere
+    __m256d root = _mm256_sqrt_pd(_mm256_max_pd(disc, zero));
+    __m256d nearRoot = _mm256_sub_pd(rayCos, root);
+    __m256d farRoot = _mm256_add_pd(rayCos, root);
+    __m256d distance =
+      _mm256_blendv_pd(nearRoot, farRoot,
+                       _mm256_cmp_pd(nearRoot, zero, _CMP_LT_OQ));
+    valid = _mm256_and_pd(valid,
+                          _mm256_cmp_pd(distance, minimum, _CMP_GE_OQ));
+
+    _mm256_storeu_pd(distances, distance);
+    mask = _mm256_movemask_pd(valid);
+#else
+    // Two pairs of spheres per iteration
+    int masks[2];
+    for (size_t j = 0; j < 2; j++) {
+      size_t k = i + 2 * j;
+      __m128d cx = _mm_sub_pd(_mm_loadu_pd(&x_[k]), ox);
+      __m128d cy = _mm_sub_pd(_mm_loadu_pd(&y_[k]), oy);
+      __m128d cz = _mm_sub_pd(_mm_loadu_pd(&z_[k]), oz);
+      __m128d rayCos = _mm_add_pd(_mm_add_pd(_mm_mul_pd(cx, dx),
+                                             _mm_mul_pd(cy, dy)),
+                                  _mm_mul_pd(cz, dz));
+
+      // Squared distance of the center from the ray
+      __m128d px = _mm_sub_pd(cx, _mm_mul_pd(rayCos, dx));
+      __m128d py = _mm_sub_pd(cy, _mm_mul_pd(rayCos, dy));
+      __m128d pz = _mm_sub_pd(cz, _mm_mul_pd(rayCos, dz));
+      __m128d perp2 = _mm_add_pd(_mm_add_pd(_mm_mul_pd(px, px),
+                                            _mm_mul_pd(py, py)),
+                                 _mm_mul_pd(pz, pz));
+      __m128d disc = _mm_sub_pd(_mm_loadu_pd(&radius2_[k]), perp2);
+      __m128d valid = _mm_and_pd(_mm_cmpge_pd(rayCos, zero),
+                                 _mm_cmpgt_pd(disc, epsilon));
+
+      // Take the far root if the ray starts inside the sphere
+      __m128d root = _mm_sqrt_pd(_mm_max_pd(disc, zero));
+      __m128d nearRoot = _mm_sub_pd(rayCos, root);
+      __m128d farRoot = _mm_add_pd(rayCos, root);
+      __m128d inside = _mm_cmplt_pd(nearRoot, zero);
+      __m128d distance = _mm_or_pd(_mm_and_pd(inside, farRoot),
+                                   _mm_andnot_pd(inside, nearRoot));
+      valid = _mm_and_pd(valid, _mm_cmpge_pd(distance, minimum));
+
+      _mm_storeu_pd(&distances[2 * j], distance);
+      masks[j] = _mm_movemask_pd(valid);
+    }
+    mask = masks[0] | (masks[1] << 2);
+#endif
+
+    if (mask == 0) {
+      continue;
+    }
+
+    // Accept hits in order, as a Group of spheres would
+    for (size_t lane = 0; lane < 4; lane++) {
+      if ((mask & (1 << lane)) && distances[lane] <= closest) {
+	closest = distances[lane];
+	closestSphere = i + lane;
+      }
+    }
+  }
+#else
+  for (size_t i = first; i < first + kLeafSize; i++) {
+    Vector3 co = Vector3(x_[i], y_[i], z_[i]) - ray.origin;
+    Real rayCos = co.dotProduct(ray.direction);
+    if (rayCos < 0) {
+      continue;
+    }
+
+    Vector3 perpendicular = co - (rayCos * ray.direction);
+    Real disc = radius2_[i] - perpendicular.dotProduct(perpendicular);
+    if (disc > 0.0001) {
+      Real root = sqrt(disc);
+      Real distance = (rayCos - root < 0) ? rayCos + root : rayCos - root;
+      if (distance >= tmin && distance <= closest) {
+	closest = distance;
+	closestSphere = i;
+      }
+    }
+  }
+#endif
+
+  if (closestSphere == first + kLeafSize) {
+    return false;
+  }
+
+  Vector3 center(x_[closestSphere], y_[closestSphere], z_[closestSphere]);
+  Vector3 normal = ray.positionAtTime(closest) - center;
+  hit.setDistance(closest);
+  hit.setNormal(Normalize(normal, GetPrecision()).toVector3());
+  hit.setMaterial(material);
+  return true;
+}
@@ -0,0 +1,102 @@
+////////////////////////////////////////////////////////////////////////////////
+// Base: A Simple Graphics Suite
+// Author: Eric Scrivner
+//
+// Time-stamp: <Last modified 2026-10-19 16:24:07 by Eric Scrivner>
+//
+// Description:
+//   Large sets of spheres sharing a material, stored as arrays of coordinates
+//   and intersected several at a time.
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef SPHERE_SET_HPP__
+#define SPHERE_SET_HPP__
+
+#include "bvh.hpp"
+#include "primitive.hpp"
+
+#include <stdint.h>
+#include <vector>
+
+namespace Base {
+  //////////////////////////////////////////////////////////////////////////////
+  // Class: SphereSet
+  //
+  // A primitive made of many spheres with the same material, such as the
+  // particles of a simulation. Each sphere is hit exactly as a Sphere with the
+  // same center and radius would be.
+  //
+  // The centers and squared radii are kept in separate arrays (structure of
+  // arrays). When built, the spheres are sorted along a Morton curve and cut
+  // into leaves of kLeafSize neighbouring spheres, with a bounding volume
+  // hierarchy above the leaves. Rays only visit the leaves whose boxes they
+  // pass through, and the spheres of a leaf are tested four per loop
+  // iteration: in one register when built with AVX, or in two with SSE2.
+  class SphereSet : public Primitive {
+  public:
+    SphereSet(Material* mat);
+
+    ////////////////////////////////////////////////////////////////////////////
+    // Function: reserve
+    //
+    // Reserves space for the given number of spheres
+    void reserve(const size_t& count);
+
+    ////////////////////////////////////////////////////////////////////////////
+    // Function: addSphere
+    //
+    // Parameters:
+    //   center - The center of the sphere
+    //   radius - The radius of the sphere
+    //
+    // Adds a sphere to the set. The set must be built again before it is
+    // intersected, which happens automatically on the next intersection.
+    void addSphere(const Vector3& center, const Real& radius);
+
+    ////////////////////////////////////////////////////////////////////////////
+    // Function: build
+    //
+    // Sorts the spheres and builds the hierarchy over them. Intersection
+    // builds the set if needed, but that is not safe while several threads
+    // share the set, so call this first when tracing with threads.
+    void build();
+
+    ////////////////////////////////////////////////////////////////////////////
+    // Function: intersection
+    //
+    // Computes the closest intersection with the spheres of the set, visiting
+    // the nearer side of the hierarchy first and skipping any part whose box
+    // is beyond the closest hit.
+    bool intersection(const Ray& ray, Hit& hit, Real tmin);
+
+    ////////////////////////////////////////////////////////////////////////////
+    // Function: size
+    //
+    // Returns the number of spheres in the set
+    size_t size() const { return numSpheres_; }
+
+    ////////////////////////////////////////////////////////////////////////////
+    // Function: numNodes
+    //
+    // Returns the number of nodes in the hierarchy (zero until built)
+    size_t numNodes() const { return hierarchy_.numNodes(); }
+  private:
+    static const size_t kLeafSize = 8; // Spheres per leaf (a multiple of 4)
+
+    ////////////////////////////////////////////////////////////////////////////
+    // Function: _intersectLeaf
+    //
+    // Tests the kLeafSize spheres of a leaf starting at first, updating the
+    // hit as a Group of Sphere primitives would. Returns true on a hit.
+    bool _intersectLeaf(const Ray& ray, Hit& hit, Real tmin,
+                        const size_t& first) const;
+
+    std::vector<Real> x_, y_, z_;  // The centers of the spheres
+    std::vector<Real> radius2_;    // The squared radii (negative for padding)
+    Bvh<Real>         hierarchy_;  // The hierarchy over the leaves
+    size_t            numSpheres_; // The number of spheres (without padding)
+    bool              built_;      // Whether the hierarchy is up to date
+  };
+}
+
+#endif // SPHERE_SET_HPP__
@@ -0,0 +1,335 @@
+////////////////////////////////////////////////////////////////////////////////
+// Base: A Simple Graphics Suite
+// Author: Eric Scrivner
+//
+// Time-stamp: <Last modified 2026-10-19 20:05:42 by Eric Scrivner>
+//
+// Description:
+//   Mip-mapped textures kept in tiles, filtered to the footprint of a ray.
+////////////////////////////////////////////////////////////////////////////////
+
+#include "texture.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+using namespace std;
+
+namespace {
+  //////////////////////////////////////////////////////////////////////////////
+  // Constants
+  const int      kTileTexels      = Base::kImageTileSize *
+                                    Base::kImageTileSize; // Texels in a tile
+  const size_t   kTexelCacheSize  = 32; // Tiles in each thread's cache
+  const uint64_t kEmptyKey        = ~uint64_t(0); // Key of an unused entry
+
+  //////////////////////////////////////////////////////////////////////////////
+  // Struct: TexelCache
+  //
+  // A direct-mapped cache of decoded tiles, keyed by texture, level and tile
+  struct TexelCache {
+    uint64_t              keys[kTexelCacheSize];
+    float                 tiles[kTexelCacheSize][kTileTexels][3];
+    Base::TexelCacheStats stats;
+
+    TexelCache() {
+      fill(keys, keys + kTexelCacheSize, kEmptyKey);
+    }
+  };
+
+  thread_local TexelCache gTexelCache; // The calling thread's cache
+
+  atomic<uint32_t> gNextTextureId(1); // The id given to the next contents
+
+  //////////////////////////////////////////////////////////////////////////////
+  // Function: Wrap
+  //
+  // Returns the given texel coordinate repeated onto [0, size)
+  int Wrap(const int& coordinate, const int& size) {
+    int wrapped = coordinate % size;
+    return wrapped < 0 ? wrapped + size : wrapped;
+  }
+
+  //////////////////////////////////////////////////////////////////////////////
+  // Struct: Tap
+  //
+  // A texel of a level and the fraction of a texel of the next level it
+  // covers
+  struct Tap {
+    int   index;
+    float weight;
+
+    Tap(const int& i, const float& w)
+      : index(i), weight(w)
+    { }
+  };
+
+  //////////////////////////////////////////////////////////////////////////////
+  // Function: BoxTaps
+  //
+  // Parameters:
+  //   size - The number of texels across a level
+  //   nextSize - The number of texels across the next level
+  //   taps - Receives the taps of each texel of the next level
+  //   first - Receives the first tap of each texel of the next level, and
+  //           after them the number of taps
+  //
+  // Finds the texels of a level which each texel of the next (smaller) level
+  // covers along one axis. Each texel of the next level is as wide as
+  // size / nextSize texels of the level, so for odd sizes it covers parts of
+  // three of them.
+  void BoxTaps(const int& size, const int& nextSize, vector<Tap>& taps,
+               vector<size_t>& first) {
+    taps.clear();
+    first.clear();
+    Base::Real scale = static_cast<Base::Real>(size) / nextSize;
+    for (int i = 0; i < nextSize; i++) {
+      first.push_back(taps.size());
+      Base::Real lower = i * scale;
+      Base::Real upper = (i + 1) * scale;
+      for (int j = static_cast<int>(lower); j < upper && j < size; j++) {
+	Base::Real overlap = min<Base::Real>(upper, j + 1) -
+	                     max<Base::Real>(lower, j);
+	if (overlap > 0) {
+	  taps.push_back(Tap(j, static_cast<float>(overlap / scale)));
+	}
+      }
+    }
+    first.push_back(taps.size());
+  }
+
+  //////////////////////////////////////////////////////////////////////////////
+  // Function: PackTexel
+  //
+  // Returns the given color rounded to an RGBA8 texel
+  uint32_t PackTexel(const float* color) {
+    const Base::Real kHalf = 0.5 / 255;
+    return Base::ColorToByte(color[0] + kHalf) |
+      (Base::ColorToByte(color[1] + kHalf) << 8) |
+      (Base::ColorToByte(color[2] + kHalf) << 16) | (0xffu << 24);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+ostream& Base::operator << (ostream& out, const TexelCacheStats& stats) {
+  out << stats.hits + stats.misses << " texel fetches, "
+      << stats.hitRate() * 100 << "% cached, " << stats.bytesRead / 1024
+      << " KB of texels read";
+  return out;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+Base::TexelCacheStats Base::GetTexelCacheStats() {
+  return gTexelCache.stats;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void Base::ResetTexelCacheStats() {
+  gTexelCache.stats = TexelCacheStats();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void Base::Texture::build(const ImageView& image) {
+  // New contents get a new id, so tiles of the old ones are never used
+  id_ = gNextTextureId++;
+  levels_.clear();
+  texels_.clear();
+
+  int width = image.width();
+  int height = image.height();
+  if (width <= 0 || height <= 0) {
+    return;
+  }
+
+  // The current level at full precision, row-major
+  vector<float> current(static_cast<size_t>(width) * height * 3);
+  for (int y = 0; y < height; y++) {
+    for (int x = 0; x < width; x++) {
+      const Color& color = image.pixelAt(x, y);
+      float* texel = &current[(static_cast<size_t>(y) * width + x) * 3];
+      texel[0] = color.r;
+      texel[1] = color.g;
+      texel[2] = color.b;
+    }
+  }
+
+  vector<float> next, rows;
+  vector<Tap> columnTaps, rowTaps;
+  vector<size_t> firstColumnTap, firstRowTap;
+  while (true) {
+    // Quantize the level into tiles
+    Level level(width, height, texels_.size());
+    texels_.resize(level.offset + ImageStorageSize(eTiled, width, height), 0);
+    for (int y = 0; y < height; y++) {
+      for (int x = 0; x < width; x++) {
+	texels_[level.offset + PixelOffset(eTiled, level.stride, x, y)] =
+	  PackTexel(&current[(static_cast<size_t>(y) * width + x) * 3]);
+      }
+    }
+    levels_.push_back(level);
+
+    if (width == 1 && height == 1) {
+      break;
+    }
+
+    // Box filter the next level over the area each of its texels covers,
+    // first along the rows and then down the columns. Odd sized levels have
+    // every texel share in the next level, in proportion to its coverage.
+    int nextWidth = max(1, width / 2);
+    int nextHeight = max(1, height / 2);
+    BoxTaps(width, nextWidth, columnTaps, firstColumnTap);
+    BoxTaps(height, nextHeight, rowTaps, firstRowTap);
+
+    rows.assign(static_cast<size_t>(nextWidth) * height * 3, 0);
+    for (int y = 0; y < height; y++) {
+      for (int x = 0; x < nextWidth; x++) {
+	float* texel = &rows[(static_cast<size_t>(y) * nextWidth + x) * 3];
+	for (size_t t = firstColumnTap[x]; t < firstColumnTap[x + 1]; t++) {
+	  const Tap& tap = columnTaps[t];
+	  const float* source =
+	    &current[(static_cast<size_t>(y) * width + tap.index) * 3];
+	  for (int i = 0; i < 3; i++) {
+	    texel[i] += tap.weight * source[i];
+	  }
+	}
+      }
+    }
+
+    next.assign(static_cast<size_t>(nextWidth) * nextHeight * 3, 0);
+    for (int y = 0; y < nextHeight; y++) {
+      float* row = &next[static_cast<size_t>(y) * nextWidth * 3];
+      for (size_t t = firstRowTap[y]; t < firstRowTap[y + 1]; t++) {
+	const Tap& tap = rowTaps[t];
+	const float* source =
+	  &rows[static_cast<size_t>(tap.index) * nextWidth * 3];
+	for (int i = 0; i < nextWidth * 3; i++) {
+	  row[i] += tap.weight * source[i];
+	}
+      }
+    }
+
+    current.swap(next);
+    width = nextWidth;
+    height = nextHeight;
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool Base::Texture::load(const string& fileName) {
+  Image image;
+  if (!LoadTga(fileName, image)) {
+    return false;
+  }
+
+  build(image.view());
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+Base::Real Base::Texture::levelOfDetail(const Real& footprint) const {
+  if (levels_.empty()) {
+    return 0;
+  }
+
+  // The level at which the footprint covers one texel
+  Real texels = footprint * max(levels_[0].width, levels_[0].height);
+  if (!(texels > 1)) {
+    return 0;
+  }
+  return min(log2(texels), static_cast<Real>(levels_.size() - 1));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+Base::Color Base::Texture::sample(const Real& u, const Real& v,
+                                  const Real& footprint) const {
+  if (levels_.empty()) {
+    return Color::White;
+  }
+
+  Real lod = levelOfDetail(footprint);
+  size_t level = static_cast<size_t>(lod);
+  Real blend = lod - level;
+  Color color = _bilinear(level, u, v);
+  if (blend > 0 && level + 1 < levels_.size()) {
+    color = (1 - blend) * color + blend * _bilinear(level + 1, u, v);
+  }
+  return color;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+Base::Color Base::Texture::_bilinear(const size_t& level, const Real& u,
+                                     const Real& v) const {
+  const Level& l = levels_[level];
+
+  // Texel centers are at half-integer coordinates
+  Real x = (u - floor(u)) * l.width - 0.5;
+  Real y = (v - floor(v)) * l.height - 0.5;
+  Real fx = floor(x);
+  Real fy = floor(y);
+  Real wx = x - fx;
+  Real wy = y - fy;
+
+  int x0 = Wrap(static_cast<int>(fx), l.width);
+  int y0 = Wrap(static_cast<int>(fy), l.height);
+  int x1 = Wrap(x0 + 1, l.width);
+  int y1 = Wrap(y0 + 1, l.height);
+
+  float a[3], b[3], c[3], d[3];
+  _texel(level, x0, y0, a);
+  _texel(level, x1, y0, b);
+  _texel(level, x0, y1, c);
+  _texel(level, x1, y1, d);
+  Real weights[4] = { (1 - wx) * (1 - wy), wx * (1 - wy),
+                      (1 - wx) * wy, wx * wy };
+  return Color(weights[0] * a[0] + weights[1] * b[0] +
+               weights[2] * c[0] + weights[3] * d[0],
+               weights[0] * a[1] + weights[1] * b[1] +
+               weights[2] * c[1] + weights[3] * d[1],
+               weights[0] * a[2] + weights[1] * b[2] +
+               weights[2] * c[2] + weights[3] * d[2]);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void Base::Texture::_texel(const size_t& level, const int& x, const int& y,
+                           float* texel) const {
+  const Level& l = levels_[level];
+  size_t offset = PixelOffset(eTiled, l.stride, x, y);
+  size_t tile = offset / kTileTexels;
+  size_t index = offset % kTileTexels;
+
+  // The tiles of a small block of a level fall in different entries,
+  // whatever the width of the level
+  uint64_t key = (uint64_t(id_) << 40) | (uint64_t(level) << 32) | tile;
+  size_t entry = ((x >> kImageTileShift) + 7 * (y >> kImageTileShift) +
+                  13 * level + 29 * id_) % kTexelCacheSize;
+
+  TexelCache& cache = gTexelCache;
+  float (*decoded)[3] = cache.tiles[entry];
+  if (cache.keys[entry] == key) {
+    cache.stats.hits++;
+    copy(decoded[index], decoded[index] + 3, texel);
+    return;
+  }
+
+  // Decode the whole tile
+  const uint32_t* packed = &texels_[l.offset + tile * kTileTexels];
+  const float kScale = 1.0f / 255;
+  for (int i = 0; i < kTileTexels; i++) {
+    decoded[i][0] = (packed[i] & 0xff) * kScale;
+    decoded[i][1] = ((packed[i] >> 8) & 0xff) * kScale;
+    decoded[i][2] = ((packed[i] >> 16) & 0xff) * kScale;
+  }
+  cache.keys[entry] = key;
+  cache.stats.misses++;
+  cache.stats.bytesRead += kTileTexels * sizeof(uint32_t);
+  copy(decoded[index], decoded[index] + 3, texel);
+}
@@ -0,0 +1,173 @@
+////////////////////////////////////////////////////////////////////////////////
+// Base: A Simple Graphics Suite
+// Author: Eric Scrivner
+//
+// Time-stamp: <Last modified 2026-10-19 20:05:42 by Eric Scrivner>
+//
+// Description:
+//   Mip-mapped textures kept in tiles, filtered to the footprint of a ray.
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef TEXTURE_HPP__
+#define TEXTURE_HPP__
+
+#include "base.hpp"
+#include "color.hpp"
+#include "image.hpp"
+
+#include <ostream>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+namespace Base {
+  //////////////////////////////////////////////////////////////////////////////
+  // Struct: TexelCacheStats
+  //
+  // The use of the texel cache of one thread
+  struct TexelCacheStats {
+    size_t hits;       // Texel fetches from a tile in the cache
+    size_t misses;     // Texel fetches which had to decode a tile
+    size_t bytesRead;  // Bytes of texture storage read to decode tiles
+
+    TexelCacheStats()
+      : hits(0), misses(0), bytesRead(0)
+    { }
+
+    ////////////////////////////////////////////////////////////////////////////
+    // Function: hitRate
+    //
+    // Returns the fraction of texel fetches which hit the cache
+    Real hitRate() const {
+      return (hits + misses) > 0 ?
+        static_cast<Real>(hits) / (hits + misses) : 0;
+    }
+  };
+
+  //////////////////////////////////////////////////////////////////////////////
+  // Function: operator <<
+  //
+  // Writes the texel cache statistics in a human readable form
+  std::ostream& operator << (std::ostream& out, const TexelCacheStats& stats);
+
+  //////////////////////////////////////////////////////////////////////////////
+  // Function: GetTexelCacheStats, ResetTexelCacheStats
+  //
+  // Returns or clears the statistics of the calling thread's texel cache
+  TexelCacheStats GetTexelCacheStats();
+  void ResetTexelCacheStats();
+
+  //////////////////////////////////////////////////////////////////////////////
+  // Class: Texture
+  //
+  // An image to be mapped onto surfaces, with a chain of mip levels each half
+  // the size of the one before (rounded down), down to a single texel. The
+  // levels are box filtered at full precision and then kept as 8-bit RGBA
+  // texels in the eTiled layout of Image, so the kImageTileSize x
+  // kImageTileSize texels around a point lie in one run of memory.
+  //
+  // A sample is taken from the levels whose texels are about the size of the
+  // footprint of the ray being shaded, so a large texture seen from afar
+  // reads only its small levels and costs memory bandwidth in proportion to
+  // the part of the screen it covers rather than its own size. Tiles are
+  // decoded into a small cache kept by each thread, which the four texels of
+  // a bilinear lookup and the lookups of neighbouring rays mostly hit.
+  class Texture {
+  public:
+    Texture()
+      : id_(0)
+    { }
+
+    ////////////////////////////////////////////////////////////////////////////
+    // Function: build
+    //
+    // Replaces the contents of the texture with the given image and builds
+    // its mip levels
+    void build(const ImageView& image);
+
+    ////////////////////////////////////////////////////////////////////////////
+    // Function: load
+    //
+    // Builds the texture from a Truevision-TGA file (see LoadTga). Returns
+    // false, leaving the texture as it was, if the file cannot be read.
+    bool load(const std::string& fileName);
+
+    ////////////////////////////////////////////////////////////////////////////
+    // Function: sample
+    //
+    // Parameters:
+    //   u, v - The texture coordinates, the texture repeating every unit
+    //   footprint - The width of the area to be filtered in texture
+    //               coordinates, such as a ray's footprint on the surface
+    //
+    // Returns the color of the texture filtered over the footprint, blended
+    // between bilinear samples of the two nearest mip levels. A texture with
+    // no image is white.
+    Color sample(const Real& u, const Real& v, const Real& footprint) const;
+
+    ////////////////////////////////////////////////////////////////////////////
+    // Function: levelOfDetail
+    //
+    // Returns the (fractional) mip level whose texels are as wide as the
+    // given footprint, clamped to the levels of the texture
+    Real levelOfDetail(const Real& footprint) const;
+
+    ////////////////////////////////////////////////////////////////////////////
+    // Function: width, height
+    //
+    // Returns the size of the given mip level in texels, or 0 if the texture
+    // has no such level
+    int width(const size_t& level = 0) const {
+      return level < levels_.size() ? levels_[level].width : 0;
+    }
+    int height(const size_t& level = 0) const {
+      return level < levels_.size() ? levels_[level].height : 0;
+    }
+
+    ////////////////////////////////////////////////////////////////////////////
+    // Function: numLevels
+    //
+    // Returns the number of mip levels of the texture
+    size_t numLevels() const { return levels_.size(); }
+
+    ////////////////////////////////////////////////////////////////////////////
+    // Function: memoryBytes
+    //
+    // Returns the size of the texels of all the levels in bytes
+    size_t memoryBytes() const { return texels_.size() * sizeof(uint32_t); }
+  private:
+    ////////////////////////////////////////////////////////////////////////////
+    // Struct: Level
+    //
+    // A mip level, stored from offset in texels_
+    struct Level {
+      int    width, height; // The size of the level in texels
+      int    stride;        // The stride of the level (see PixelOffset)
+      size_t offset;        // The index of the level's first texel
+
+      Level(const int& w, const int& h, const size_t& o)
+        : width(w), height(h), stride(ImageStride(eTiled, w)), offset(o)
+      { }
+    };
+
+    ////////////////////////////////////////////////////////////////////////////
+    // Function: _bilinear
+    //
+    // Returns the bilinear filtered color of the given level at (u, v)
+    Color _bilinear(const size_t& level, const Real& u, const Real& v) const;
+
+    ////////////////////////////////////////////////////////////////////////////
+    // Function: _texel
+    //
+    // Copies the decoded red, green and blue of a texel of the given level
+    // to texel, through the calling thread's texel cache
+    void _texel(const size_t& level, const int& x, const int& y,
+                float* texel) const;
+
+    uint32_t              id_;     // Identifies the contents in texel caches
+    std::vector<Level>    levels_; // The mip levels, largest first
+    std::vector<uint32_t> texels_; // The texels of every level, as RGBA8
+  };
+}
+
+#endif // TEXTURE_HPP__
@@ -0,0 +1,174 @@
+////////////////////////////////////////////////////////////////////////////////
+// Base: A Simple Graphics Suite
+// Author: Eric Scrivner
+//
+// Time-stamp: <Last modified 2026-10-19 20:05:42 by Eric Scrivner>
+//
+// Description:
+//   Materials whose diffuse and specular colors are read from textures.
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef TEXTURED_MATERIAL_HPP__
+#define TEXTURED_MATERIAL_HPP__
+
+#include "material.hpp"
+#include "texture.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace Base {
+  //////////////////////////////////////////////////////////////////////////////
+  // Class: TextureMapping
+  //
+  // Maps points on a surface to texture coordinates. Primitives carry no
+  // texture coordinates of their own, so they are found from the position of
+  // the point hit.
+  class TextureMapping {
+  public:
+    virtual ~TextureMapping()
+    { }
+
+    ////////////////////////////////////////////////////////////////////////////
+    // Function: map
+    //
+    // Parameters:
+    //   point - The point on the surface
+    //   width - The width of the area to be filtered around it
+    //   u, v - Set to the texture coordinates of the point
+    //   footprint - Set to the width of the area in texture coordinates
+    virtual void map(const Vector3& point, const Real& width,
+                     Real& u, Real& v, Real& footprint) const = 0;
+  };
+
+  //////////////////////////////////////////////////////////////////////////////
+  // Class: PlanarMapping
+  //
+  // Projects the texture along the normal of a plane, repeating it across
+  // the parallelograms spanned by two axes from an origin
+  class PlanarMapping : public TextureMapping {
+  public:
+    PlanarMapping(const Vector3& origin, const Vector3& axisU,
+                  const Vector3& axisV)
+      : origin_(origin), axisU_(axisU), axisV_(axisV),
+        lengthU_(axisU.magnitude()), lengthV_(axisV.magnitude())
+    { }
+
+    void map(const Vector3& point, const Real& width,
+             Real& u, Real& v, Real& footprint) const {
+      Vector3 offset = point - origin_;
+      u = offset.dotProduct(axisU_) / (lengthU_ * lengthU_);
+      v = offset.dotProduct(axisV_) / (lengthV_ * lengthV_);
+      footprint = width / std::min(lengthU_, lengthV_);
+    }
+  private:
+    Vector3 origin_;            // The point at texture coordinates (0, 0)
+    Vector3 axisU_, axisV_;     // The extent of one repeat of the texture
+    Real    lengthU_, lengthV_; // The lengths of the axes
+  };
+
+  //////////////////////////////////////////////////////////////////////////////
+  // Class: SphericalMapping
+  //
+  // Wraps the texture once around a sphere, by longitude and latitude
+  class SphericalMapping : public TextureMapping {
+  public:
+    SphericalMapping(const Vector3& center, const Real& radius)
+      : center_(center), radius_(radius)
+    { }
+
+    void map(const Vector3& point, const Real& width,
+             Real& u, Real& v, Real& footprint) const {
+      Vector3 offset = point - center_;
+      Real distance = offset.magnitude();
+      Real height = distance > 0 ? offset.y / distance : 0;
+      u = 0.5 + atan2(offset.z, offset.x) / (2 * M_PI);
+      v = acos(std::max(-1.0, std::min(1.0, -height))) / M_PI;
+
+      // The latitudes are the more stretched coordinate
+      footprint = width / (M_PI * radius_);
+    }
+  private:
+    Vector3 center_; // The center of the sphere
+    Real    radius_; // The radius of the sphere
+  };
+
+  //////////////////////////////////////////////////////////////////////////////
+  // Class: TexturedMaterial
+  //
+  // A Phong material whose diffuse and specular colors are modulated by
+  // textures. Each texture is filtered over the footprint of the ray hitting
+  // the material, widened where the ray meets the surface at a glancing
+  // angle. The mapping and textures are not owned by the material.
+  class TexturedMaterial : public PhongMaterial {
+  public:
+    ////////////////////////////////////////////////////////////////////////////
+    // Function: TexturedMaterial
+    //
+    // Parameters:
+    //   mapping - Maps the points hit to texture coordinates
+    //   diffuseTexture - Modulates the diffuse color, if not null
+    //   specularTexture - Modulates the specular color, if not null
+    //
+    // The remaining parameters are those of PhongMaterial
+    TexturedMaterial(const TextureMapping* mapping,
+                     const Texture* diffuseTexture,
+                     const Texture* specularTexture,
+                     const Color& diffuseColor,
+                     const Color& specularColor,
+                     const Real& fShininess,
+                     const Color& refractionColor,
+                     const Color& reflectionColor,
+                     const Real& indexOfRefraction)
+      : PhongMaterial(diffuseColor,
+                      specularColor,
+                      fShininess,
+                      refractionColor,
+                      reflectionColor,
+                      indexOfRefraction),
+        mapping_(mapping),
+        diffuseTexture_(diffuseTexture),
+        specularTexture_(specularTexture)
+    { }
+
+    Color diffuseAt(const Ray& ray, const Hit& hit) const {
+      if (diffuseTexture_ == 0) {
+	return diffuse;
+      }
+      return diffuse * _sample(*diffuseTexture_, ray, hit);
+    }
+
+    Color specularAt(const Ray& ray, const Hit& hit) const {
+      if (specularTexture_ == 0) {
+	return specular;
+      }
+      return specular * _sample(*specularTexture_, ray, hit);
+    }
+  private:
+    ////////////////////////////////////////////////////////////////////////////
+    // Function: _sample
+    //
+    // Returns the given texture filtered over the footprint of the ray where
+    // it hit
+    Color _sample(const Texture& texture, const Ray& ray,
+                  const Hit& hit) const {
+      // The footprint grows as 1 / cos of the angle to the normal, up to
+      // the width at a very glancing angle
+      const Real kMinCosine = 0.05;
+      Real cosine = fabs(ray.direction.dotProduct(hit.getNormal()));
+      Real width = ray.widthAtTime(hit.getDistance()) /
+                   std::max(cosine, kMinCosine);
+
+      Real u, v, footprint;
+      mapping_->map(ray.positionAtTime(hit.getDistance()), width,
+                    u, v, footprint);
+      return texture.sample(u, v, footprint);
+    }
+
+    const TextureMapping* mapping_;         // Maps points to coordinates
+    const Texture*        diffuseTexture_;  // Modulates the diffuse color
+    const Texture*        specularTexture_; // Modulates the specular color
+  };
+}
+
+#endif // TEXTURED_MATERIAL_HPP__
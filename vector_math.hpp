@@ -0,0 +1,246 @@
+////////////////////////////////////////////////////////////////////////////////
+// Base: A Simple Graphics Suite
+// Author: Eric Scrivner
+//
+// Time-stamp: <Last modified 2026-10-19 15:02:11 by Eric Scrivner>
+//
+// Description:
+//   Padded 4-wide vectors for doing vector and color arithmetic in SIMD
+//   registers.
+////////////////////////////////////////////////////////////////////////////////
+#ifndef VECTOR_MATH_HPP__
+#define VECTOR_MATH_HPP__
+
+#include "base.hpp"
+#include "color.hpp"
+#include "vector3.hpp"
+
+#include <cmath>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace Base {
+  //////////////////////////////////////////////////////////////////////////////
+  // Class: Vec4
+  //
+  // A 16-byte aligned vector of four doubles, where the fourth is padding
+  // which is kept at zero. Vector3 and Color keep their packed three-double
+  // layout, since they are stored in bulk (meshes, mesh caches, images), and
+  // are loaded into a Vec4 to do a run of arithmetic in registers. With SSE2
+  // each Vec4 occupies two registers, (x, y) and (z, 0).
+  //
+  // Every operation rounds exactly as the equivalent scalar Vector3 or Color
+  // code does, so results are identical either way.
+  class alignas(16) Vec4 {
+  public:
+    Vec4()
+    { }
+
+    Vec4(const Real& x, const Real& y, const Real& z) {
+#ifdef __SSE2__
+      xy_ = _mm_set_pd(y, x);
+      zw_ = _mm_set_sd(z);
+#else
+      v_[0] = x; v_[1] = y; v_[2] = z; v_[3] = 0;
+#endif
+    }
+
+    Vec4(const Vector3& v) {
+#ifdef __SSE2__
+      xy_ = _mm_loadu_pd(&v.x);
+      zw_ = _mm_load_sd(&v.z);
+#else
+      v_[0] = v.x; v_[1] = v.y; v_[2] = v.z; v_[3] = 0;
+#endif
+    }
+
+    Vec4(const Color& c) {
+#ifdef __SSE2__
+      xy_ = _mm_loadu_pd(&c.r);
+      zw_ = _mm_load_sd(&c.b);
+#else
+      v_[0] = c.r; v_[1] = c.g; v_[2] = c.b; v_[3] = 0;
+#endif
+    }
+
+    ////////////////////////////////////////////////////////////////////////////
+    // Function: splat
+    //
+    // Returns a vector with the given value in its first three components
+    static Vec4 splat(const Real& s) {
+      return Vec4(s, s, s);
+    }
+
+    ////////////////////////////////////////////////////////////////////////////
+    // Function: toVector3
+    //
+    // Returns the first three components as a Vector3
+    Vector3 toVector3() const {
+      Vector3 result;
+#ifdef __SSE2__
+      _mm_storeu_pd(&result.x, xy_);
+      _mm_store_sd(&result.z, zw_);
+#else
+      result.x = v_[0]; result.y = v_[1]; result.z = v_[2];
+#endif
+      return result;
+    }
+
+    ////////////////////////////////////////////////////////////////////////////
+    // Function: toColor
+    //
+    // Returns the first three components as a Color
+    Color toColor() const {
+      Color result;
+#ifdef __SSE2__
+      _mm_storeu_pd(&result.r, xy_);
+      _mm_store_sd(&result.b, zw_);
+#else
+      result.r = v_[0]; result.g = v_[1]; result.b = v_[2];
+#endif
+      return result;
+    }
+
+#ifdef __SSE2__
+    inline Vec4 operator - () const {
+      __m128d sign = _mm_set_pd(-0.0, -0.0);
+      return Vec4(_mm_xor_pd(xy_, sign), _mm_xor_pd(zw_, _mm_set_sd(-0.0)));
+    }
+
+    inline Vec4 operator + (const Vec4& rhs) const {
+      return Vec4(_mm_add_pd(xy_, rhs.xy_), _mm_add_pd(zw_, rhs.zw_));
+    }
+
+    inline Vec4 operator - (const Vec4& rhs) const {
+      return Vec4(_mm_sub_pd(xy_, rhs.xy_), _mm_sub_pd(zw_, rhs.zw_));
+    }
+
+    inline Vec4 operator * (const Vec4& rhs) const {
+      return Vec4(_mm_mul_pd(xy_, rhs.xy_), _mm_mul_pd(zw_, rhs.zw_));
+    }
+
+    inline Vec4 operator * (const Real& fScalar) const {
+      __m128d s = _mm_set1_pd(fScalar);
+      return Vec4(_mm_mul_pd(xy_, s), _mm_mul_pd(zw_, s));
+    }
+
+    inline Vec4 operator / (const Real& fScalar) const {
+      __m128d s = _mm_set1_pd(fScalar);
+      return Vec4(_mm_div_pd(xy_, s), _mm_div_sd(zw_, s));
+    }
+
+    ////////////////////////////////////////////////////////////////////////////
+    // Function: dot
+    //
+    // Returns the dot product of the first three components, summed in the
+    // same order as Vector3::dotProduct
+    inline Real dot(const Vec4& rhs) const {
+      __m128d xy = _mm_mul_pd(xy_, rhs.xy_);
+      __m128d z = _mm_mul_sd(zw_, rhs.zw_);
+      __m128d sum = _mm_add_sd(xy, _mm_unpackhi_pd(xy, xy));
+      return _mm_cvtsd_f64(_mm_add_sd(sum, z));
+    }
+#else
+    inline Vec4 operator - () const {
+      return Vec4(-v_[0], -v_[1], -v_[2]);
+    }
+
+    inline Vec4 operator + (const Vec4& rhs) const {
+      return Vec4(v_[0] + rhs.v_[0], v_[1] + rhs.v_[1], v_[2] + rhs.v_[2]);
+    }
+
+    inline Vec4 operator - (const Vec4& rhs) const {
+      return Vec4(v_[0] - rhs.v_[0], v_[1] - rhs.v_[1], v_[2] - rhs.v_[2]);
+    }
+
+    inline Vec4 operator * (const Vec4& rhs) const {
+      return Vec4(v_[0] * rhs.v_[0], v_[1] * rhs.v_[1], v_[2] * rhs.v_[2]);
+    }
+
+    inline Vec4 operator * (const Real& fScalar) const {
+      return Vec4(v_[0] * fScalar, v_[1] * fScalar, v_[2] * fScalar);
+    }
+
+    inline Vec4 operator / (const Real& fScalar) const {
+      return Vec4(v_[0] / fScalar, v_[1] / fScalar, v_[2] / fScalar);
+    }
+
+    inline Real dot(const Vec4& rhs) const {
+      return v_[0] * rhs.v_[0] + v_[1] * rhs.v_[1] + v_[2] * rhs.v_[2];
+    }
+#endif
+
+    inline friend Vec4 operator * (const Real& fScalar, const Vec4& v) {
+      return v * fScalar;
+    }
+
+    inline Vec4& operator += (const Vec4& rhs) {
+      *this = *this + rhs;
+      return *this;
+    }
+
+    inline Vec4& operator -= (const Vec4& rhs) {
+      *this = *this - rhs;
+      return *this;
+    }
+
+    inline Vec4& operator *= (const Vec4& rhs) {
+      *this = *this * rhs;
+      return *this;
+    }
+
+    ////////////////////////////////////////////////////////////////////////////
+    // Function: magnitude
+    //
+    // Returns the length of the first three components
+    inline Real magnitude() const {
+      return sqrt(dot(*this));
+    }
+
+    ////////////////////////////////////////////////////////////////////////////
+    // Function: normalize
+    //
+    // Returns this vector scaled to unit length, or zero if it has no length
+    inline Vec4 normalize() const {
+      Real mag = magnitude();
+      if (mag == 0) {
+	return Vec4(0, 0, 0);
+      }
+      return *this / mag;
+    }
+
+    ////////////////////////////////////////////////////////////////////////////
+    // Function: cross
+    //
+    // Returns the cross product of the first three components
+    inline Vec4 cross(const Vec4& rhs) const {
+      Vector3 a = toVector3();
+      return Vec4(a.crossProduct(rhs.toVector3()));
+    }
+
+    ////////////////////////////////////////////////////////////////////////////
+    // Function: reflect
+    //
+    // Parameters:
+    //   normal - The unit surface normal to reflect about
+    //
+    // Returns the mirror reflection of this direction about the given normal
+    inline Vec4 reflect(const Vec4& normal) const {
+      return *this - (2 * dot(normal)) * normal;
+    }
+  private:
+#ifdef __SSE2__
+    Vec4(const __m128d& xy, const __m128d& zw)
+      : xy_(xy), zw_(zw)
+    { }
+
+    __m128d xy_, zw_; // The (x, y) and (z, 0) halves of the vector
+#else
+    Real v_[4]; // The components of the vector, with v_[3] always zero
+#endif
+  };
+}
+
+#endif // VECTOR_MATH_HPP__
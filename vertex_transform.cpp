@@ -0,0 +1,151 @@
+////////////////////////////////////////////////////////////////////////////////
+// Base: A Simple Graphics Suite
+// Author: Eric Scrivner
+//
+// Time-stamp: <Last modified 2026-10-19 14:15:36 by Eric Scrivner>
+//
+// Description:
+//   Batched transformation of vertex positions.
+////////////////////////////////////////////////////////////////////////////////
+
+#include "vertex_transform.hpp"
+
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+using namespace std;
+
+namespace {
+  //////////////////////////////////////////////////////////////////////////////
+  // Struct: Affine
+  //
+  // The top three rows of a transformation
+  struct Affine {
+    Base::Real m[3][4];
+
+    explicit Affine(const Base::Matrix44& transformation) {
+      for (int row = 0; row < 3; row++) {
+	for (int col = 0; col < 4; col++) {
+	  m[row][col] = transformation[row][col];
+	}
+      }
+    }
+  };
+
+  //////////////////////////////////////////////////////////////////////////////
+  // Function: TransformOne
+  //
+  // Transforms a single point
+  inline void TransformOne(const Affine& a, const Base::Vector3& in,
+                           Base::Vector3& out) {
+    Base::Real x = in.x, y = in.y, z = in.z;
+    out.x = a.m[0][0] * x + a.m[0][1] * y + a.m[0][2] * z + a.m[0][3];
+    out.y = a.m[1][0] * x + a.m[1][1] * y + a.m[1][2] * z + a.m[1][3];
+    out.z = a.m[2][0] * x + a.m[2][1] * y + a.m[2][2] * z + a.m[2][3];
+  }
+
+  //////////////////////////////////////////////////////////////////////////////
+  // Function: TransformRange
+  //
+  // Transforms the points [begin, end) of an array of Vector3s
+  void TransformRange(const Affine& a,
+                      const Base::Vector3* in,
+                      Base::Vector3* out,
+                      size_t begin,
+                      size_t end) {
+    size_t i = begin;
+
+#ifdef __SSE2__
+    // Each Vector3 is three consecutive doubles; x and y are computed
+    // together in one register, z in the low half of another.
+    {
+      const __m128d col0 = _mm_setr_pd(a.m[0][0], a.m[1][0]);
+      const __m128d col1 = _mm_setr_pd(a.m[0][1], a.m[1][1]);
+      const __m128d col2 = _mm_setr_pd(a.m[0][2], a.m[1][2]);
+      const __m128d col3 = _mm_setr_pd(a.m[0][3], a.m[1][3]);
+      const __m128d row2xy = _mm_setr_pd(a.m[2][0], a.m[2][1]);
+      const __m128d row2z = _mm_set_sd(a.m[2][2]);
+      const __m128d row2w = _mm_set_sd(a.m[2][3]);
+
+      for (; i < end; i++) {
+	const double* p = &in[i].x;
+	__m128d xy = _mm_loadu_pd(p);
+	__m128d z = _mm_load_sd(p + 2);
+	__m128d x = _mm_unpacklo_pd(xy, xy);
+	__m128d y = _mm_unpackhi_pd(xy, xy);
+	__m128d zz = _mm_unpacklo_pd(z, z);
+
+	__m128d rxy = _mm_add_pd(_mm_add_pd(_mm_mul_pd(col0, x),
+	                                    _mm_mul_pd(col1, y)),
+	                         _mm_add_pd(_mm_mul_pd(col2, zz), col3));
+
+	__m128d dz = _mm_mul_pd(row2xy, xy);
+	__m128d rz = _mm_add_sd(_mm_add_sd(dz, _mm_unpackhi_pd(dz, dz)),
+	                        _mm_add_sd(_mm_mul_sd(row2z, z), row2w));
+
+	double* q = &out[i].x;
+	_mm_storeu_pd(q, rxy);
+	_mm_store_sd(q + 2, rz);
+      }
+    }
+#endif
+
+    for (; i < end; i++) {
+      TransformOne(a, in[i], out[i]);
+    }
+  }
+
+  //////////////////////////////////////////////////////////////////////////////
+  // Function: ParallelFor
+  //
+  // Calls body(begin, end) over [0, count) split into one range per thread.
+  // Small batches are done on the calling thread alone.
+  template <typename Body>
+  void ParallelFor(const size_t& count, const Body& body) {
+    const size_t kMinBatchSize = 64 * 1024;
+
+    size_t numThreads = std::thread::hardware_concurrency();
+    size_t numBatches = min(max(numThreads, size_t(1)), count / kMinBatchSize);
+    numBatches = max(numBatches, size_t(1));
+
+    // Every batch but the first runs on its own thread
+    vector<std::thread> workers;
+    for (size_t i = 1; i < numBatches; i++) {
+      workers.push_back(std::thread(body, count * i / numBatches,
+                                    count * (i + 1) / numBatches));
+    }
+
+    body(0, count / numBatches);
+
+    for (size_t i = 0; i < workers.size(); i++) {
+      workers[i].join();
+    }
+  }
+
+  //////////////////////////////////////////////////////////////////////////////
+  // Function: TransformBatch
+  //
+  // Transforms an array of Vector3s across threads
+  void TransformBatch(const Affine& a,
+                      const Base::Vector3* in,
+                      Base::Vector3* out,
+                      const size_t& count) {
+    ParallelFor(count, [&a, in, out](size_t begin, size_t end) {
+	TransformRange(a, in, out, begin, end);
+      });
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void Base::TransformPoints(const Matrix44& transformation,
+                           const Vector3* in,
+                           Vector3* out,
+                           const size_t& count) {
+  TransformBatch(Affine(transformation), in, out, count);
+}
+
@@ -0,0 +1,38 @@
+////////////////////////////////////////////////////////////////////////////////
+// Base: A Simple Graphics Suite
+// Author: Eric Scrivner
+//
+// Time-stamp: <Last modified 2026-10-19 14:15:36 by Eric Scrivner>
+//
+// Description:
+//   Batched transformation of vertex positions.
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef VERTEX_TRANSFORM_HPP__
+#define VERTEX_TRANSFORM_HPP__
+
+#include "base.hpp"
+#include "matrix44.hpp"
+#include "vector3.hpp"
+
+namespace Base {
+  //////////////////////////////////////////////////////////////////////////////
+  // Function: TransformPoints
+  //
+  // Parameters:
+  //   transformation - An affine transformation (the bottom row is ignored)
+  //   in - The first of count points to be transformed
+  //   out - Where the transformed points are written; may equal in
+  //   count - The number of points
+  //
+  // Transforms a batch of points, using SSE2 where available and splitting
+  // large batches across threads. The points are transformed where they lie
+  // in the array, x and y of each together in one register, so the vertices
+  // of a Model need not be copied into separate coordinate arrays first.
+  void TransformPoints(const Matrix44& transformation,
+                       const Vector3* in,
+                       Vector3* out,
+                       const size_t& count);
+}
+
+#endif // VERTEX_TRANSFORM_HPP__